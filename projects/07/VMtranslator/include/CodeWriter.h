@@ -1,36 +0,0 @@
-#ifndef CODEWRITER_H
-#define CODEWRITER_H
-
-#include <vector>
-#include <fstream>
-#include <string>
-#include "CommandType.h"
-
-class CodeWriter
-{
-private:
-  std::ofstream& m_outputFile;
-  std::string m_fileName{};
-
-  int m_eqLabelId{ 0 };
-  int m_gtLabelId{ 0 };
-  int m_ltLabelId{ 0 };
-
-  std::string uniqueLabel(const std::string& jmp);
-  std::string emitBinary(const std::string& op);
-  std::string emitUnary(const std::string& op);
-  std::string emitCompare(const std::string& jmp);
-  std::string emitPush(const std::string& segment, int index);
-  std::string emitPop(const std::string& segment, int index);
-  std::string emitMemorySegment(const std::string& segment, int index);
-  
-public:
-  CodeWriter(std::ofstream& outputFile);
-
-  void setFileName(const std::string& fileName);
-  void writeArithmetic(const std::string& command);
-  void writePushPop(CommandType command, const std::string& segment, int index);
-  void close();
-};
-
-#endif
\ No newline at end of file
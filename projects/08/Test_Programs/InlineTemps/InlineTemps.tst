@@ -0,0 +1,13 @@
+// Tests InlineTemps.asm in the CPU emulator.
+// This assembly file results from translating the InlineTemps folder.
+
+compare-to InlineTemps.cmp,
+
+set RAM[0] 256,
+
+repeat 2000 {
+	ticktock;
+}
+
+output-list RAM[0]%D1.6.1 RAM[261]%D1.6.1;
+output;
\ No newline at end of file
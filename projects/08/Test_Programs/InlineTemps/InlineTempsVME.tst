@@ -0,0 +1,13 @@
+// Tests the inlined temps program on the VM emulator.
+
+load,
+compare-to InlineTemps.cmp,
+
+set sp 261,
+
+repeat 25 {
+	vmstep;
+}
+
+output-list RAM[0]%D1.6.1 RAM[261]%D1.6.1;
+output;
\ No newline at end of file
@@ -0,0 +1,14 @@
+// Tests SharedStem.asm in the CPU emulator.
+// This assembly file results from translating the SharedStem folder,
+// subfolders included.
+
+compare-to SharedStem.cmp,
+
+set RAM[0] 256,
+
+repeat 2000 {
+	ticktock;
+}
+
+output-list RAM[0]%D1.6.1 RAM[261]%D1.6.1;
+output;
\ No newline at end of file
@@ -0,0 +1,158 @@
+#ifndef NATIVEOS_H
+#define NATIVEOS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <vector>
+
+class VMBytecode;
+class VMEmulator;
+
+// C++ implementations of the Jack OS (the projects/12 API) for the
+// VMEmulator, enabled class by class: the functions of an enabled class
+// replace its VM code, every other class keeps running as VM code, so a
+// user's own Memory.vm can be tested with the rest of the OS native.
+// Natives reach the other OS classes, native or not, through
+// VMEmulator::call, and keep the RAM layout of the VM OS: the heap from
+// 2048 with the same allocator, the String fields (maxLength, chars,
+// length), the screen at 16384 and the keyboard at 24576. Unlike the VM
+// OS they keep their tables (font, powers of two) out of the heap, and
+// Sys.wait returns at once.
+class NativeOS
+{
+public:
+  // Most arguments of a native function
+  static constexpr int maxArgs{ 4 };
+
+  // Array, Keyboard, Math, Memory, Output, Screen, String, Sys
+  static const std::vector<std::string>& classNames();
+
+  // Throws std::invalid_argument for a class without a native version
+  explicit NativeOS(const std::vector<std::string>& classes = classNames());
+
+  // Every native function of the enabled classes, by index
+  const std::vector<std::string>& functionNames() const noexcept { return m_functionNames; }
+
+  int nArgs(size_t function) const noexcept { return m_natives[function]->nArgs; }
+
+  // Resolves the OS functions the natives call in the program
+  void bind(const VMBytecode& bytecode);
+
+  // Runs native `function` with its arguments; no value when it has to
+  // wait for the keyboard and must be run again later
+  std::optional<int16_t> run(size_t function, VMEmulator& emulator, const int16_t* args);
+
+private:
+  enum Callee
+  {
+    MEMORY_ALLOC,
+    MEMORY_DEALLOC,
+    ARRAY_NEW,
+    ARRAY_DISPOSE,
+    STRING_NEW,
+    STRING_DISPOSE,
+    STRING_LENGTH,
+    STRING_CHAR_AT,
+    STRING_APPEND_CHAR,
+    STRING_ERASE_LAST_CHAR,
+    STRING_INT_VALUE,
+    OUTPUT_PRINT_CHAR,
+    OUTPUT_PRINT_STRING,
+    SYS_ERROR,
+    CALLEES
+  };
+
+  typedef std::optional<int16_t> (NativeOS::*Function)(VMEmulator&, const int16_t*);
+
+  struct Native
+  {
+    const char* name;
+    int nArgs;
+    Function function;
+  };
+
+  static const Native natives[];
+
+  std::vector<std::string> m_functionNames{};
+  std::vector<const Native*> m_natives{};
+  int m_callees[CALLEES]{};
+
+  // Screen.setColor
+  bool m_black{ true };
+
+  // Output cursor, as the VM Output keeps it: word column, screen word
+  // under the cursor and left or right half of the word
+  int m_column{ 0 };
+  int m_address{ 32 };
+  bool m_left{ true };
+
+  // Keyboard.readChar in progress: 0 before the key is pressed, then the
+  // key until it is released. Keyboard.readLine in progress: its String.
+  bool m_reading{ false };
+  int16_t m_key{ 0 };
+  int16_t m_line{ 0 };
+
+  int16_t call(VMEmulator& emulator, Callee callee, std::initializer_list<int16_t> args);
+  void error(VMEmulator& emulator, int code);
+  void updateLocation(VMEmulator& emulator, int address, int16_t mask);
+  void drawPixel(VMEmulator& emulator, int x, int y);
+  void drawHorizontal(VMEmulator& emulator, int y, int x1, int x2);
+  void drawChar(VMEmulator& emulator, int c);
+  void println();
+  std::optional<int16_t> readChar(VMEmulator& emulator);
+  std::optional<int16_t> readLine(VMEmulator& emulator, int16_t message);
+
+  std::optional<int16_t> arrayNew(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> arrayDispose(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> keyboardInit(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> keyboardKeyPressed(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> keyboardReadChar(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> keyboardReadLine(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> keyboardReadInt(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> mathInit(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> mathAbs(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> mathMultiply(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> mathDivide(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> mathSqrt(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> mathMax(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> mathMin(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> memoryInit(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> memoryPeek(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> memoryPoke(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> memoryAlloc(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> memoryDeAlloc(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> outputInit(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> outputMoveCursor(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> outputPrintChar(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> outputPrintString(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> outputPrintInt(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> outputPrintln(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> outputBackSpace(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> screenInit(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> screenClearScreen(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> screenSetColor(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> screenDrawPixel(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> screenDrawLine(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> screenDrawRectangle(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> screenDrawCircle(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> stringNew(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> stringDispose(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> stringLength(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> stringCharAt(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> stringSetCharAt(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> stringAppendChar(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> stringEraseLastChar(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> stringIntValue(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> stringSetInt(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> stringNewLine(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> stringBackSpace(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> stringDoubleQuote(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> sysHalt(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> sysWait(VMEmulator& emulator, const int16_t* args);
+  std::optional<int16_t> sysError(VMEmulator& emulator, const int16_t* args);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,143 @@
+#ifndef VMBYTECODE_H
+#define VMBYTECODE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include "VMProgram.h"
+
+// A whole VM program compiled for the VMEmulator: one flat array of 8-byte
+// instructions where segments are split into opcodes, temp/pointer/static
+// cells are absolute addresses (statics laid out by StaticLayout, as the
+// translator does), labels are instruction indices and calls are indices
+// into the function table. Nothing is looked up by name at run time.
+// Functions given as natives get a one-instruction body that runs their
+// C++ version (NativeOS) instead of their VM code, if any.
+enum class VMOpcode : uint8_t
+{
+  PUSH_CONSTANT,    // b: value
+  PUSH_LOCAL,       // a: index
+  PUSH_ARGUMENT,
+  PUSH_THIS,
+  PUSH_THAT,
+  PUSH_FIXED,       // b: address of a temp, pointer or static cell
+  POP_LOCAL,
+  POP_ARGUMENT,
+  POP_THIS,
+  POP_THAT,
+  POP_FIXED,
+  ADD,
+  SUB,
+  NEG,
+  EQ,
+  GT,
+  LT,
+  AND,
+  OR,
+  NOT,
+  GOTO,             // b: target instruction
+  IF_GOTO,
+  CALL,             // a: number of arguments, b: function index
+  FUNCTION,         // a: number of locals
+  RETURN,
+  END,              // stop: the bootstrap call returned or the code ran out
+  SET_SP,           // b: new stack pointer, for the bootstrap
+  NATIVE,           // b: NativeOS function, run and return
+  RESUME            // return point of functions called by native code
+};
+
+struct VMInstruction
+{
+  VMOpcode op{ VMOpcode::END };
+  uint16_t a{ 0 };
+  int32_t b{ 0 };
+};
+
+class VMBytecode
+{
+public:
+  static constexpr int stackBase{ 256 };
+
+  // Format of the cache files written by save
+  static constexpr uint32_t cacheVersion{ 1 };
+
+  struct Function
+  {
+    std::string name{};
+    uint32_t entry{ 0 };      // index of its FUNCTION instruction
+    uint16_t nLocals{ 0 };
+  };
+
+  // Where every instruction came from, for error messages and tools;
+  // the bootstrap and the final END come from no file
+  static constexpr uint32_t noFile{ UINT32_MAX };
+
+  struct Origin
+  {
+    uint32_t file{ 0 };
+    uint32_t command{ 0 };
+  };
+
+private:
+  std::vector<VMInstruction> m_code{};
+  std::vector<Origin> m_origins{};
+
+  // Code and origins as run: m_code and m_origins, or the mapped cache
+  // file a bytecode was loaded from
+  std::shared_ptr<const void> m_mapping{};
+  std::span<const VMInstruction> m_codeView{};
+  std::span<const Origin> m_originsView{};
+
+  std::vector<Function> m_functions{};
+  std::vector<std::string> m_fileNames{};
+  int m_sysInit{ -1 };
+  uint32_t m_start{ 0 };
+  uint32_t m_resume{ 0 };
+
+  void emit(VMOpcode op, int a, int b, Origin origin);
+
+  VMBytecode() = default;
+
+public:
+  // Throws std::invalid_argument for undefined labels or functions and for
+  // indices outside their segment. `natives` are function names, in the
+  // order of NativeOS::functionNames; they are the first functions of the
+  // table.
+  VMBytecode(const VMProgram& program, const std::vector<std::string>& natives = {});
+
+  // The views point into the bytecode's own storage
+  VMBytecode(const VMBytecode&) = delete;
+  VMBytecode& operator=(const VMBytecode&) = delete;
+  VMBytecode(VMBytecode&&) noexcept = default;
+  VMBytecode& operator=(VMBytecode&&) noexcept = default;
+
+  // Cache of compiled programs: the key of the .vm files (names and
+  // contents, in order) and natives a bytecode is built from; the bytecode
+  // written to a file with its key, and mapped back from it. load gives
+  // nothing for a missing, stale or damaged file; save throws
+  // std::runtime_error when the file cannot be written.
+  static uint64_t cacheKey(const std::vector<std::filesystem::path>& files, const std::vector<std::string>& natives);
+  static std::optional<VMBytecode> load(const std::filesystem::path& path, uint64_t key);
+  void save(const std::filesystem::path& path, uint64_t key) const;
+
+  std::span<const VMInstruction> code() const noexcept { return m_codeView; }
+  const std::vector<Function>& functions() const noexcept { return m_functions; }
+
+  // First instruction to run: the bootstrap call to Sys.init if there is
+  // one, otherwise the first command of the first file
+  uint32_t start() const noexcept { return m_start; }
+  bool hasSysInit() const noexcept { return m_sysInit >= 0; }
+
+  // The RESUME instruction, if there are natives
+  uint32_t resume() const noexcept { return m_resume; }
+
+  int functionIndex(const std::string& name) const;
+  int functionAt(uint32_t pc) const;
+  std::string location(uint32_t pc) const;
+};
+
+#endif
\ No newline at end of file
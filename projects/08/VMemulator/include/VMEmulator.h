@@ -0,0 +1,147 @@
+#ifndef VMEMULATOR_H
+#define VMEMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <vector>
+#include "VMBytecode.h"
+#include "VMTrace.h"
+#include "KeyboardLog.h"
+
+class NativeOS;
+class VMProfiler;
+class VMMemoryMonitor;
+
+// Interpreter of VMBytecode over the same 32K-word RAM layout as the Hack
+// platform: SP, LCL, ARG, THIS and THAT in RAM[0..4], temp in RAM[5..12],
+// statics from RAM[16], the stack from 256, the heap from 2048, the screen
+// at 16384 and the keyboard at 24576. Frames are the 5 words the translator
+// pushes, so a program leaves RAM as its translated code would, except for
+// the return addresses (instruction indices here, ROM addresses in Hack).
+// Comparisons follow the VM specification (true signed comparison), where
+// the Hack code compares the 16-bit difference x - y.
+// Loops that get hot are recorded as traces and run in register form from
+// then on (see VMTrace.h). A trace keeps its stack slots in registers, so
+// the dead cells above SP may differ from a run without traces, and a halt
+// inside a traced loop is found at the end of an iteration rather than at
+// the jump the interpreter stops on.
+class VMEmulator
+{
+public:
+  static constexpr size_t memorySize{ 32768 };
+  static constexpr uint16_t keyboard{ 24576 };
+
+  enum class Stop
+  {
+    STEPS,      // maxSteps instructions executed
+    HALT,       // a loop that can never leave: a backward jump came back to
+                // its target with SP and RAM as on the previous arrival
+    END,        // the bootstrap call to Sys.init returned, or the code ran out
+    CALL        // a CALL has pushed its frame, with call stops on: PC is at
+                // the FUNCTION instruction of the callee
+  };
+
+private:
+  // Cells a loop may write and still be recognised as a halt
+  static constexpr size_t maxLoopWrites{ 16 };
+
+  // Backward jumps to a loop header before its iteration is recorded
+  static constexpr uint16_t hotLoop{ 32 };
+
+  // Thrown through native code to end the run
+  struct Interrupt
+  {
+    Stop stop;
+  };
+
+  const VMBytecode& m_bytecode;
+  NativeOS* m_natives{ nullptr };
+  VMProfiler* m_profiler{ nullptr };
+  VMMemoryMonitor* m_monitor{ nullptr };
+  KeyboardLog* m_keyboard{ nullptr };
+  std::vector<int16_t> m_ram{};
+  uint32_t m_pc{ 0 };
+  uint64_t m_steps{ 0 };
+  uint64_t m_maxSteps{ 0 };
+  uint16_t m_stackPeak{ 0 };
+
+  // Runs of VM code called by native code, and whether one reached its
+  // return point; whether native code wrote to RAM
+  int m_depth{ 0 };
+  bool m_resumed{ false };
+  bool m_nativeWrote{ false };
+
+  // Recorded traces, and per instruction the trace starting there (-1:
+  // none yet, -2: cannot be traced) and the jumps that came back to it
+  bool m_jit{ true };
+  bool m_callStop{ false };
+  std::vector<Trace> m_traces{};
+  std::vector<int32_t> m_traceAt{};
+  std::vector<uint16_t> m_heat{};
+
+  bool recordTrace(uint32_t& pc, uint16_t& sp, uint64_t& steps, uint64_t maxSteps);
+  bool runTrace(const Trace& trace, uint32_t& pc, uint16_t& sp, uint64_t& steps, uint64_t maxSteps);
+
+public:
+  // `natives` must be the NativeOS whose function names the bytecode was
+  // built with
+  VMEmulator(const VMBytecode& bytecode, NativeOS* natives = nullptr);
+
+  VMEmulator(const VMEmulator&) = delete;
+  VMEmulator& operator=(const VMEmulator&) = delete;
+
+  // PC back to the start, step count and stack peak cleared; RAM is left
+  // alone
+  void reset() noexcept;
+
+  int16_t& ram(uint16_t address) { return m_ram[address & (memorySize - 1)]; }
+  int16_t ram(uint16_t address) const { return m_ram[address & (memorySize - 1)]; }
+
+  // All of RAM at once, for tools that compare it
+  std::span<const int16_t> memory() const noexcept { return m_ram; }
+
+  // Calls and returns are reported to `profiler` from the next run on
+  void setProfiler(VMProfiler* profiler) noexcept { m_profiler = profiler; }
+
+  // Calls, returns and stack peaks are reported to `monitor` from the
+  // next run on
+  void setMonitor(VMMemoryMonitor* monitor) noexcept { m_monitor = monitor; }
+
+  // The keyboard cell follows `keys` (timed in steps) from the next run
+  // on; a halt while keys are left waits for the next one
+  void setKeyboard(KeyboardLog* keys) noexcept { m_keyboard = keys; }
+
+  // Hot loops are traced unless disabled
+  void setJit(bool enabled) noexcept { m_jit = enabled; }
+
+  // Every call made by VM code (not within native code) ends the run with
+  // Stop::CALL; the next run goes on from the callee's entry
+  void setCallStop(bool enabled) noexcept { m_callStop = enabled; }
+
+  uint32_t pc() const noexcept { return m_pc; }
+  uint64_t steps() const noexcept { return m_steps; }
+
+  // Highest SP since the last reset
+  uint16_t stackPeak() const noexcept { return m_stackPeak; }
+
+  // Executes until one of the Stop conditions, maxSteps counting from the
+  // last reset. A step limit reached inside VM code called by a native
+  // function cannot be resumed: running on throws std::runtime_error.
+  Stop run(uint64_t maxSteps);
+
+  // For native functions: RAM access, calls to any function of the
+  // program (VM code runs to its return within the current step limit),
+  // and the end of the run as a halt
+  int16_t peek(int address) const { return m_ram[static_cast<size_t>(address) & (memorySize - 1)]; }
+  void poke(int address, int16_t value)
+  {
+    m_ram[static_cast<size_t>(address) & (memorySize - 1)] = value;
+    m_nativeWrote = true;
+  }
+  int16_t call(int function, std::initializer_list<int16_t> args);
+  [[noreturn]] void halt();
+};
+
+#endif
\ No newline at end of file
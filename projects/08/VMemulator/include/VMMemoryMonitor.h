@@ -0,0 +1,87 @@
+#ifndef VMMEMORYMONITOR_H
+#define VMMEMORYMONITOR_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "VMBytecode.h"
+
+// Stack and heap use of a VMEmulator run. The stack grows from 256 and
+// the heap Memory.alloc hands out starts at 2048: the monitor follows the
+// peak SP, the blocks allocated and freed (Memory.alloc and Memory.deAlloc,
+// VM or native, seen at their calls and returns) and reports the moment
+// the stack reaches the heap or a block lies outside it. A sample of all
+// counters is taken at every alloc and deAlloc, and at the first call or
+// return `interval` steps after the previous sample.
+class VMMemoryMonitor
+{
+public:
+  static constexpr int heapBase{ 2048 };
+  static constexpr int heapEnd{ 16384 };
+
+  struct Sample
+  {
+    uint64_t steps{ 0 };
+    uint16_t sp{ 0 };
+    uint16_t stackPeak{ 0 };
+    uint16_t heapTop{ 0 };              // end of the highest block so far
+    uint64_t allocs{ 0 };
+    uint64_t deAllocs{ 0 };
+    uint32_t liveBlocks{ 0 };
+    uint32_t liveWords{ 0 };
+  };
+
+  struct Collision
+  {
+    uint64_t steps{ 0 };
+    std::string what{};
+  };
+
+private:
+  struct PendingAlloc
+  {
+    uint32_t depth{ 0 };
+    uint16_t size{ 0 };
+  };
+
+  const VMBytecode& m_bytecode;
+  const int m_alloc{ -1 };
+  const int m_deAlloc{ -1 };
+  const uint64_t m_interval{ 0 };
+  uint64_t m_nextSample{ 0 };
+
+  uint32_t m_depth{ 0 };
+  std::vector<PendingAlloc> m_pending{};
+  std::unordered_map<uint16_t, uint16_t> m_blocks{};    // live blocks: address, size
+  Sample m_now{};
+  bool m_stackCollided{ false };
+
+  std::vector<Sample> m_samples{};
+  std::vector<Collision> m_collisions{};
+
+  void sample(uint16_t sp, uint64_t steps);
+
+public:
+  VMMemoryMonitor(const VMBytecode& bytecode, uint64_t interval = 10000);
+
+  // Called by the emulator: the arguments of a call where they are on the
+  // stack, a return value, a new peak SP at the instruction `pc` (at the
+  // next call or return, or at once past the heap base)
+  void enter(int function, const int16_t* args, uint16_t sp, uint64_t steps);
+  void leave(int16_t value, uint16_t sp, uint64_t steps);
+  void stackPeak(uint16_t sp, uint32_t pc, uint64_t steps);
+  void stop(uint16_t sp, uint64_t steps);
+
+  const std::vector<Sample>& samples() const noexcept { return m_samples; }
+  const std::vector<Collision>& collisions() const noexcept { return m_collisions; }
+
+  // Peaks, counts, what is still allocated, and the collisions
+  void writeReport(std::ostream& output) const;
+
+  // The samples as CSV, one row each
+  void writeSeries(std::ostream& output) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef VMPROFILER_H
+#define VMPROFILER_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "VMBytecode.h"
+
+// Call tree of a VMEmulator run, built from its calls and returns: calls
+// and instructions executed in each function (exclusive) and under it
+// (inclusive), per call path and per function. One lookup among the
+// children of the current node per call, so it can stay on for long runs.
+class VMProfiler
+{
+private:
+  struct Node
+  {
+    int function{ -1 };                 // -1: the root, code run before any call
+    uint32_t parent{ 0 };
+    uint64_t calls{ 0 };
+    uint64_t self{ 0 };                 // instructions executed in this node
+    std::vector<uint32_t> children{};
+  };
+
+  const VMBytecode& m_bytecode;
+  std::vector<Node> m_nodes{ Node{} };
+  uint32_t m_current{ 0 };
+  uint64_t m_lastSteps{ 0 };
+
+  // Steps since the last event go to the current node
+  void account(uint64_t steps);
+  std::string name(int function) const;
+
+public:
+  VMProfiler(const VMBytecode& bytecode);
+
+  // Called by the emulator: `steps` is its step count, the instruction
+  // making the call or return included
+  void enter(int function, uint64_t steps);
+  void leave(uint64_t steps);
+  void stop(uint64_t steps);
+
+  // Functions by exclusive instructions: calls, exclusive and inclusive
+  // instructions; recursive activations are counted once in the inclusive
+  void writeReport(std::ostream& output) const;
+
+  // One "caller;...;callee instructions" line per call path, the folded
+  // stack format of flame graph tools
+  void writeFolded(std::ostream& output) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,109 @@
+#ifndef VMTRACE_H
+#define VMTRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "VMBytecode.h"
+
+// Register form of one iteration of a hot loop, as the VMEmulator recorded
+// it: stack slots become registers (slot d, counted from SP at the loop
+// header, is register d), constants are folded into the instructions
+// that use them, jumps disappear and conditional jumps become guards that
+// leave the trace where the recorded iteration did not go.
+enum class TraceOpcode : uint8_t
+{
+  CONST,            // r[d] = imm
+  LOAD,             // r[d] = RAM[RAM[b] + imm], b: LCL, ARG, THIS or THAT;
+                    // leaves through exit for SP or the trace's own stack
+  LOAD_FIXED,       // r[d] = RAM[imm]
+  STORE,            // RAM[RAM[b] + imm] = r[a], leaves as LOAD does
+  STORE_FIXED,      // RAM[imm] = r[a]
+  ADD,              // r[d] = r[a] op r[b]
+  SUB,
+  AND,
+  OR,
+  EQ,
+  GT,
+  LT,
+  ADD_IMM,          // r[d] = r[a] op imm
+  AND_IMM,
+  OR_IMM,
+  EQ_IMM,
+  GT_IMM,
+  LT_IMM,
+  NEG,              // r[d] = op r[a]
+  NOT,
+  GUARD_TRUE,       // go on if r[a] != 0, otherwise leave through exit
+  GUARD_FALSE       // go on if r[a] == 0
+};
+
+struct TraceOp
+{
+  TraceOpcode op{ TraceOpcode::CONST };
+  uint8_t d{ 0 };
+  uint8_t a{ 0 };
+  uint8_t b{ 0 };
+  int16_t imm{ 0 };
+  uint16_t exit{ 0 };
+};
+
+// Where the interpreter goes on when a trace is left: the instruction, the
+// stack slots to write back (those holding a folded constant are not in
+// their register), the instructions of the iteration executed and the
+// deepest stack they reached
+struct TraceExit
+{
+  uint32_t pc{ 0 };
+  uint16_t depth{ 0 };
+  uint16_t steps{ 0 };
+  uint16_t peak{ 0 };
+  std::vector<std::pair<uint16_t, int16_t>> constants{};
+};
+
+struct Trace
+{
+  uint32_t header{ 0 };
+  uint16_t length{ 0 };             // VM instructions per iteration
+  uint16_t registers{ 0 };          // deepest stack slot + 1
+  std::vector<TraceOp> ops{};
+  std::vector<TraceExit> exits{};
+};
+
+// Translates the instructions of one loop iteration as they are executed
+class TraceRecorder
+{
+public:
+  static constexpr size_t maxLength{ 256 };
+  static constexpr size_t maxRegisters{ 256 };
+
+private:
+  Trace m_trace{};
+  std::vector<std::optional<int16_t>> m_constants{};    // per stack slot
+  uint16_t m_depth{ 0 };
+
+  void emit(TraceOpcode op, int d, int a, int b, int imm);
+  uint16_t exit(uint32_t pc, uint16_t depth, uint16_t steps);
+  void materialize(uint16_t slot);
+
+public:
+  TraceRecorder(uint32_t header);
+
+  // Only stack, segment, arithmetic and jump instructions can be traced
+  static bool traceable(VMOpcode op) noexcept { return op <= VMOpcode::IF_GOTO; }
+
+  const Trace& trace() const noexcept { return m_trace; }
+  uint16_t depth() const noexcept { return m_depth; }
+
+  // Value of stack slot `slot`, constant or in the registers
+  int16_t value(uint16_t slot, const int16_t* registers) const;
+
+  // Appends the instruction at `pc`; `taken` is the direction of an
+  // IF_GOTO in this iteration. False, with nothing appended, if the
+  // instruction would pop below the header's stack or use too many registers.
+  bool add(const VMInstruction& instruction, uint32_t pc, bool taken);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,923 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "NativeOS.h"
+#include "VMBytecode.h"
+#include "VMEmulator.h"
+
+namespace
+{
+  constexpr int screen{ 16384 };
+  constexpr int keyboard{ 24576 };
+  constexpr int16_t newLine{ 128 };
+  constexpr int16_t backSpace{ 129 };
+
+  // Results are 16-bit words, as in the VM
+  int16_t word(int value)
+  {
+    return static_cast<int16_t>(value);
+  }
+
+  const char* const calleeNames[]{
+    "Memory.alloc", "Memory.deAlloc", "Array.new", "Array.dispose",
+    "String.new", "String.dispose", "String.length", "String.charAt",
+    "String.appendChar", "String.eraseLastChar", "String.intValue",
+    "Output.printChar", "Output.printString", "Sys.error"
+  };
+
+  // The font of the VM Output: the block for character 0, then 32..126,
+  // 11 rows of 8 pixels each
+  const int16_t glyphs[96][11]{
+    { 63, 63, 63, 63, 63, 63, 63, 63, 63,  0,  0 },  // block
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0 },  // space
+    { 12, 30, 30, 30, 12, 12,  0, 12, 12,  0,  0 },  // !
+    { 54, 54, 20,  0,  0,  0,  0,  0,  0,  0,  0 },  // "
+    {  0, 18, 18, 63, 18, 18, 63, 18, 18,  0,  0 },  // #
+    { 12, 30, 51,  3, 30, 48, 51, 30, 12, 12,  0 },  // $
+    {  0,  0, 35, 51, 24, 12,  6, 51, 49,  0,  0 },  // %
+    { 12, 30, 30, 12, 54, 27, 27, 27, 54,  0,  0 },  // &
+    { 12, 12,  6,  0,  0,  0,  0,  0,  0,  0,  0 },  // '
+    { 24, 12,  6,  6,  6,  6,  6, 12, 24,  0,  0 },  // (
+    {  6, 12, 24, 24, 24, 24, 24, 12,  6,  0,  0 },  // )
+    {  0,  0,  0, 51, 30, 63, 30, 51,  0,  0,  0 },  // *
+    {  0,  0,  0, 12, 12, 63, 12, 12,  0,  0,  0 },  // +
+    {  0,  0,  0,  0,  0,  0,  0, 12, 12,  6,  0 },  // ,
+    {  0,  0,  0,  0,  0, 63,  0,  0,  0,  0,  0 },  // -
+    {  0,  0,  0,  0,  0,  0,  0, 12, 12,  0,  0 },  // .
+    {  0,  0, 32, 48, 24, 12,  6,  3,  1,  0,  0 },  // /
+    { 12, 30, 51, 51, 51, 51, 51, 30, 12,  0,  0 },  // 0
+    { 12, 14, 15, 12, 12, 12, 12, 12, 63,  0,  0 },  // 1
+    { 30, 51, 48, 24, 12,  6,  3, 51, 63,  0,  0 },  // 2
+    { 30, 51, 48, 48, 28, 48, 48, 51, 30,  0,  0 },  // 3
+    { 16, 24, 28, 26, 25, 63, 24, 24, 60,  0,  0 },  // 4
+    { 63,  3,  3, 31, 48, 48, 48, 51, 30,  0,  0 },  // 5
+    { 28,  6,  3,  3, 31, 51, 51, 51, 30,  0,  0 },  // 6
+    { 63, 49, 48, 48, 24, 12, 12, 12, 12,  0,  0 },  // 7
+    { 30, 51, 51, 51, 30, 51, 51, 51, 30,  0,  0 },  // 8
+    { 30, 51, 51, 51, 62, 48, 48, 24, 14,  0,  0 },  // 9
+    {  0,  0, 12, 12,  0,  0, 12, 12,  0,  0,  0 },  // :
+    {  0,  0, 12, 12,  0,  0, 12, 12,  6,  0,  0 },  // ;
+    {  0,  0, 24, 12,  6,  3,  6, 12, 24,  0,  0 },  // <
+    {  0,  0,  0, 63,  0,  0, 63,  0,  0,  0,  0 },  // =
+    {  0,  0,  3,  6, 12, 24, 12,  6,  3,  0,  0 },  // >
+    { 30, 51, 51, 24, 12, 12,  0, 12, 12,  0,  0 },  // ?
+    { 30, 51, 51, 59, 59, 59, 27,  3, 30,  0,  0 },  // @
+    { 12, 30, 51, 51, 63, 51, 51, 51, 51,  0,  0 },  // A
+    { 31, 51, 51, 51, 31, 51, 51, 51, 31,  0,  0 },  // B
+    { 28, 54, 35,  3,  3,  3, 35, 54, 28,  0,  0 },  // C
+    { 15, 27, 51, 51, 51, 51, 51, 27, 15,  0,  0 },  // D
+    { 63, 51, 35, 11, 15, 11, 35, 51, 63,  0,  0 },  // E
+    { 63, 51, 35, 11, 15, 11,  3,  3,  3,  0,  0 },  // F
+    { 28, 54, 35,  3, 59, 51, 51, 54, 44,  0,  0 },  // G
+    { 51, 51, 51, 51, 63, 51, 51, 51, 51,  0,  0 },  // H
+    { 30, 12, 12, 12, 12, 12, 12, 12, 30,  0,  0 },  // I
+    { 60, 24, 24, 24, 24, 24, 27, 27, 14,  0,  0 },  // J
+    { 51, 51, 51, 27, 15, 27, 51, 51, 51,  0,  0 },  // K
+    {  3,  3,  3,  3,  3,  3, 35, 51, 63,  0,  0 },  // L
+    { 33, 51, 63, 63, 51, 51, 51, 51, 51,  0,  0 },  // M
+    { 51, 51, 55, 55, 63, 59, 59, 51, 51,  0,  0 },  // N
+    { 30, 51, 51, 51, 51, 51, 51, 51, 30,  0,  0 },  // O
+    { 31, 51, 51, 51, 31,  3,  3,  3,  3,  0,  0 },  // P
+    { 30, 51, 51, 51, 51, 51, 63, 59, 30, 48,  0 },  // Q
+    { 31, 51, 51, 51, 31, 27, 51, 51, 51,  0,  0 },  // R
+    { 30, 51, 51,  6, 28, 48, 51, 51, 30,  0,  0 },  // S
+    { 63, 63, 45, 12, 12, 12, 12, 12, 30,  0,  0 },  // T
+    { 51, 51, 51, 51, 51, 51, 51, 51, 30,  0,  0 },  // U
+    { 51, 51, 51, 51, 51, 30, 30, 12, 12,  0,  0 },  // V
+    { 51, 51, 51, 51, 51, 63, 63, 63, 18,  0,  0 },  // W
+    { 51, 51, 30, 30, 12, 30, 30, 51, 51,  0,  0 },  // X
+    { 51, 51, 51, 51, 30, 12, 12, 12, 30,  0,  0 },  // Y
+    { 63, 51, 49, 24, 12,  6, 35, 51, 63,  0,  0 },  // Z
+    { 30,  6,  6,  6,  6,  6,  6,  6, 30,  0,  0 },  // [
+    {  0,  0,  1,  3,  6, 12, 24, 48, 32,  0,  0 },  // backslash
+    { 30, 24, 24, 24, 24, 24, 24, 24, 30,  0,  0 },  // ]
+    {  8, 28, 54,  0,  0,  0,  0,  0,  0,  0,  0 },  // ^
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0, 63,  0 },  // _
+    {  6, 12, 24,  0,  0,  0,  0,  0,  0,  0,  0 },  // `
+    {  0,  0,  0, 14, 24, 30, 27, 27, 54,  0,  0 },  // a
+    {  3,  3,  3, 15, 27, 51, 51, 51, 30,  0,  0 },  // b
+    {  0,  0,  0, 30, 51,  3,  3, 51, 30,  0,  0 },  // c
+    { 48, 48, 48, 60, 54, 51, 51, 51, 30,  0,  0 },  // d
+    {  0,  0,  0, 30, 51, 63,  3, 51, 30,  0,  0 },  // e
+    { 28, 54, 38,  6, 15,  6,  6,  6, 15,  0,  0 },  // f
+    {  0,  0, 30, 51, 51, 51, 62, 48, 51, 30,  0 },  // g
+    {  3,  3,  3, 27, 55, 51, 51, 51, 51,  0,  0 },  // h
+    { 12, 12,  0, 14, 12, 12, 12, 12, 30,  0,  0 },  // i
+    { 48, 48,  0, 56, 48, 48, 48, 48, 51, 30,  0 },  // j
+    {  3,  3,  3, 51, 27, 15, 15, 27, 51,  0,  0 },  // k
+    { 14, 12, 12, 12, 12, 12, 12, 12, 30,  0,  0 },  // l
+    {  0,  0,  0, 29, 63, 43, 43, 43, 43,  0,  0 },  // m
+    {  0,  0,  0, 29, 51, 51, 51, 51, 51,  0,  0 },  // n
+    {  0,  0,  0, 30, 51, 51, 51, 51, 30,  0,  0 },  // o
+    {  0,  0,  0, 30, 51, 51, 51, 31,  3,  3,  0 },  // p
+    {  0,  0,  0, 30, 51, 51, 51, 62, 48, 48,  0 },  // q
+    {  0,  0,  0, 29, 55, 51,  3,  3,  7,  0,  0 },  // r
+    {  0,  0,  0, 30, 51,  6, 24, 51, 30,  0,  0 },  // s
+    {  4,  6,  6, 15,  6,  6,  6, 54, 28,  0,  0 },  // t
+    {  0,  0,  0, 27, 27, 27, 27, 27, 54,  0,  0 },  // u
+    {  0,  0,  0, 51, 51, 51, 51, 30, 12,  0,  0 },  // v
+    {  0,  0,  0, 51, 51, 51, 63, 63, 18,  0,  0 },  // w
+    {  0,  0,  0, 51, 30, 12, 12, 30, 51,  0,  0 },  // x
+    {  0,  0,  0, 51, 51, 51, 62, 48, 24, 15,  0 },  // y
+    {  0,  0,  0, 63, 27, 12,  6, 51, 63,  0,  0 },  // z
+    { 56, 12, 12, 12,  7, 12, 12, 12, 56,  0,  0 },  // {
+    { 12, 12, 12, 12, 12, 12, 12, 12, 12,  0,  0 },  // |
+    {  7, 12, 12, 12, 56, 12, 12, 12,  7,  0,  0 },  // }
+    { 38, 45, 25,  0,  0,  0,  0,  0,  0,  0,  0 },  // ~
+  };
+
+  const int16_t* glyph(int c)
+  {
+    return (c < 32 || c > 126) ? glyphs[0] : glyphs[c - 31];
+  }
+
+  // Decimal digits as String.setInt writes them: most negative value
+  // included, which the VM OS prints as a lone "-"
+  std::vector<int16_t> decimal(int16_t value)
+  {
+    std::vector<int16_t> digits{};
+    const bool negative{ value < 0 };
+    int16_t rest{ negative ? word(-value) : value };
+    while (rest > 0)
+    {
+      digits.insert(digits.begin(), word('0' + rest % 10));
+      rest = word(rest / 10);
+    }
+    if (negative)
+      digits.insert(digits.begin(), word('-'));
+    if (digits.empty())
+      digits.push_back(word('0'));
+    return digits;
+  }
+}
+
+const NativeOS::Native NativeOS::natives[]{
+  { "Array.new", 1, &NativeOS::arrayNew },
+  { "Array.dispose", 1, &NativeOS::arrayDispose },
+  { "Keyboard.init", 0, &NativeOS::keyboardInit },
+  { "Keyboard.keyPressed", 0, &NativeOS::keyboardKeyPressed },
+  { "Keyboard.readChar", 0, &NativeOS::keyboardReadChar },
+  { "Keyboard.readLine", 1, &NativeOS::keyboardReadLine },
+  { "Keyboard.readInt", 1, &NativeOS::keyboardReadInt },
+  { "Math.init", 0, &NativeOS::mathInit },
+  { "Math.abs", 1, &NativeOS::mathAbs },
+  { "Math.multiply", 2, &NativeOS::mathMultiply },
+  { "Math.divide", 2, &NativeOS::mathDivide },
+  { "Math.sqrt", 1, &NativeOS::mathSqrt },
+  { "Math.max", 2, &NativeOS::mathMax },
+  { "Math.min", 2, &NativeOS::mathMin },
+  { "Memory.init", 0, &NativeOS::memoryInit },
+  { "Memory.peek", 1, &NativeOS::memoryPeek },
+  { "Memory.poke", 2, &NativeOS::memoryPoke },
+  { "Memory.alloc", 1, &NativeOS::memoryAlloc },
+  { "Memory.deAlloc", 1, &NativeOS::memoryDeAlloc },
+  { "Output.init", 0, &NativeOS::outputInit },
+  { "Output.moveCursor", 2, &NativeOS::outputMoveCursor },
+  { "Output.printChar", 1, &NativeOS::outputPrintChar },
+  { "Output.printString", 1, &NativeOS::outputPrintString },
+  { "Output.printInt", 1, &NativeOS::outputPrintInt },
+  { "Output.println", 0, &NativeOS::outputPrintln },
+  { "Output.backSpace", 0, &NativeOS::outputBackSpace },
+  { "Screen.init", 0, &NativeOS::screenInit },
+  { "Screen.clearScreen", 0, &NativeOS::screenClearScreen },
+  { "Screen.setColor", 1, &NativeOS::screenSetColor },
+  { "Screen.drawPixel", 2, &NativeOS::screenDrawPixel },
+  { "Screen.drawLine", 4, &NativeOS::screenDrawLine },
+  { "Screen.drawRectangle", 4, &NativeOS::screenDrawRectangle },
+  { "Screen.drawCircle", 3, &NativeOS::screenDrawCircle },
+  { "String.new", 1, &NativeOS::stringNew },
+  { "String.dispose", 1, &NativeOS::stringDispose },
+  { "String.length", 1, &NativeOS::stringLength },
+  { "String.charAt", 2, &NativeOS::stringCharAt },
+  { "String.setCharAt", 3, &NativeOS::stringSetCharAt },
+  { "String.appendChar", 2, &NativeOS::stringAppendChar },
+  { "String.eraseLastChar", 1, &NativeOS::stringEraseLastChar },
+  { "String.intValue", 1, &NativeOS::stringIntValue },
+  { "String.setInt", 2, &NativeOS::stringSetInt },
+  { "String.newLine", 0, &NativeOS::stringNewLine },
+  { "String.backSpace", 0, &NativeOS::stringBackSpace },
+  { "String.doubleQuote", 0, &NativeOS::stringDoubleQuote },
+  { "Sys.halt", 0, &NativeOS::sysHalt },
+  { "Sys.wait", 1, &NativeOS::sysWait },
+  { "Sys.error", 1, &NativeOS::sysError },
+};
+
+const std::vector<std::string>& NativeOS::classNames()
+{
+  static const std::vector<std::string> names{
+    "Array", "Keyboard", "Math", "Memory", "Output", "Screen", "String", "Sys"
+  };
+  return names;
+}
+
+NativeOS::NativeOS(const std::vector<std::string>& classes)
+{
+  for (const auto& className : classes)
+  {
+    if (std::find(classNames().begin(), classNames().end(), className) == classNames().end())
+      throw std::invalid_argument("No native version of class " + className);
+  }
+
+  for (const Native& native : natives)
+  {
+    std::string name{ native.name };
+    if (std::find(classes.begin(), classes.end(), name.substr(0, name.find('.'))) == classes.end())
+      continue;
+    m_functionNames.push_back(name);
+    m_natives.push_back(&native);
+  }
+
+  std::fill(std::begin(m_callees), std::end(m_callees), -1);
+}
+
+void NativeOS::bind(const VMBytecode& bytecode)
+{
+  for (int callee = 0; callee < CALLEES; callee++)
+    m_callees[callee] = bytecode.functionIndex(calleeNames[callee]);
+}
+
+std::optional<int16_t> NativeOS::run(size_t function, VMEmulator& emulator, const int16_t* args)
+{
+  return (this->*m_natives[function]->function)(emulator, args);
+}
+
+int16_t NativeOS::call(VMEmulator& emulator, Callee callee, std::initializer_list<int16_t> args)
+{
+  if (m_callees[callee] < 0)
+    throw std::invalid_argument(std::string("Native OS needs undefined function ") + calleeNames[callee]);
+  return emulator.call(m_callees[callee], args);
+}
+
+// Sys.error does not return in the VM OS; when it does, the caller goes on
+// as the VM code would
+void NativeOS::error(VMEmulator& emulator, int code)
+{
+  call(emulator, SYS_ERROR, { word(code) });
+}
+
+// ---- Array ----
+
+std::optional<int16_t> NativeOS::arrayNew(VMEmulator& emulator, const int16_t* args)
+{
+  if (args[0] <= 0)
+    error(emulator, 2);
+  return call(emulator, MEMORY_ALLOC, { args[0] });
+}
+
+std::optional<int16_t> NativeOS::arrayDispose(VMEmulator& emulator, const int16_t* args)
+{
+  call(emulator, MEMORY_DEALLOC, { args[0] });
+  return 0;
+}
+
+// ---- Keyboard ----
+
+std::optional<int16_t> NativeOS::keyboardInit(VMEmulator&, const int16_t*)
+{
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::keyboardKeyPressed(VMEmulator& emulator, const int16_t*)
+{
+  return emulator.peek(keyboard);
+}
+
+// Cursor, wait for a key to be pressed and released, echo it
+std::optional<int16_t> NativeOS::readChar(VMEmulator& emulator)
+{
+  if (!m_reading)
+  {
+    call(emulator, OUTPUT_PRINT_CHAR, { 0 });
+    m_reading = true;
+    m_key = 0;
+  }
+
+  int16_t c{ emulator.peek(keyboard) };
+  if (c > 0)
+    m_key = c;
+  if (m_key == 0 || c > 0)
+    return std::nullopt;
+
+  m_reading = false;
+  call(emulator, OUTPUT_PRINT_CHAR, { backSpace });
+  call(emulator, OUTPUT_PRINT_CHAR, { m_key });
+  return m_key;
+}
+
+std::optional<int16_t> NativeOS::readLine(VMEmulator& emulator, int16_t message)
+{
+  if (m_line == 0)
+  {
+    m_line = call(emulator, STRING_NEW, { 80 });
+    call(emulator, OUTPUT_PRINT_STRING, { message });
+  }
+
+  for (;;)
+  {
+    std::optional<int16_t> c{ readChar(emulator) };
+    if (!c)
+      return std::nullopt;
+    if (*c == newLine)
+      break;
+    if (*c == backSpace)
+      call(emulator, STRING_ERASE_LAST_CHAR, { m_line });
+    else
+      m_line = call(emulator, STRING_APPEND_CHAR, { m_line, *c });
+  }
+
+  int16_t line{ m_line };
+  m_line = 0;
+  return line;
+}
+
+std::optional<int16_t> NativeOS::keyboardReadChar(VMEmulator& emulator, const int16_t*)
+{
+  return readChar(emulator);
+}
+
+std::optional<int16_t> NativeOS::keyboardReadLine(VMEmulator& emulator, const int16_t* args)
+{
+  return readLine(emulator, args[0]);
+}
+
+std::optional<int16_t> NativeOS::keyboardReadInt(VMEmulator& emulator, const int16_t* args)
+{
+  std::optional<int16_t> line{ readLine(emulator, args[0]) };
+  if (!line)
+    return std::nullopt;
+  int16_t value{ call(emulator, STRING_INT_VALUE, { *line }) };
+  call(emulator, STRING_DISPOSE, { *line });
+  return value;
+}
+
+// ---- Math ----
+
+std::optional<int16_t> NativeOS::mathInit(VMEmulator&, const int16_t*)
+{
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::mathAbs(VMEmulator&, const int16_t* args)
+{
+  return args[0] < 0 ? word(-args[0]) : args[0];
+}
+
+std::optional<int16_t> NativeOS::mathMultiply(VMEmulator&, const int16_t* args)
+{
+  return word(args[0] * args[1]);
+}
+
+std::optional<int16_t> NativeOS::mathDivide(VMEmulator& emulator, const int16_t* args)
+{
+  if (args[1] == 0)
+  {
+    error(emulator, 3);
+    return 0;
+  }
+  return word(args[0] / args[1]);
+}
+
+// Bit by bit from the top, as the VM OS does, with 16-bit squares
+std::optional<int16_t> NativeOS::mathSqrt(VMEmulator& emulator, const int16_t* args)
+{
+  if (args[0] < 0)
+    error(emulator, 4);
+
+  int16_t root{ 0 };
+  for (int bit = 7; bit >= 0; bit--)
+  {
+    int16_t candidate{ word(root + (1 << bit)) };
+    int16_t square{ word(candidate * candidate) };
+    if (square <= args[0] && square >= 0)
+      root = candidate;
+  }
+  return root;
+}
+
+std::optional<int16_t> NativeOS::mathMax(VMEmulator&, const int16_t* args)
+{
+  return args[0] > args[1] ? args[0] : args[1];
+}
+
+std::optional<int16_t> NativeOS::mathMin(VMEmulator&, const int16_t* args)
+{
+  return args[0] < args[1] ? args[0] : args[1];
+}
+
+// ---- Memory ----
+// The allocator of the VM OS: blocks of [size, next, data...] from 2048,
+// first fit, split when the rest can hold a block of its own
+
+std::optional<int16_t> NativeOS::memoryInit(VMEmulator& emulator, const int16_t*)
+{
+  emulator.poke(2048, 14334);
+  emulator.poke(2049, 2050);
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::memoryPeek(VMEmulator& emulator, const int16_t* args)
+{
+  return emulator.peek(args[0]);
+}
+
+std::optional<int16_t> NativeOS::memoryPoke(VMEmulator& emulator, const int16_t* args)
+{
+  emulator.poke(args[0], args[1]);
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::memoryAlloc(VMEmulator& emulator, const int16_t* args)
+{
+  const int16_t size{ args[0] };
+  if (size < 1)
+    error(emulator, 5);
+
+  // A broken free list would keep the VM code looping without writing
+  // anything, which is a halt
+  int16_t block{ 2048 };
+  for (size_t n = 0; emulator.peek(block) < size; n++)
+  {
+    if (n == VMEmulator::memorySize)
+      emulator.halt();
+    block = emulator.peek(block + 1);
+  }
+
+  if (word(block + size) > 16379)
+    error(emulator, 6);
+
+  if (emulator.peek(block) > word(size + 2))
+  {
+    emulator.poke(block + size + 2, word(emulator.peek(block) - size - 2));
+    if (emulator.peek(block + 1) == word(block + 2))
+      emulator.poke(block + size + 3, word(block + size + 4));
+    else
+      emulator.poke(block + size + 3, emulator.peek(block + 1));
+    emulator.poke(block + 1, word(block + size + 2));
+  }
+  emulator.poke(block, 0);
+  return word(block + 2);
+}
+
+std::optional<int16_t> NativeOS::memoryDeAlloc(VMEmulator& emulator, const int16_t* args)
+{
+  const int16_t segment{ word(args[0] - 2) };
+  const int16_t next{ emulator.peek(segment + 1) };
+
+  if (emulator.peek(next) == 0)
+  {
+    emulator.poke(segment, word(emulator.peek(segment + 1) - segment - 2));
+  }
+  else
+  {
+    emulator.poke(segment, word(emulator.peek(segment + 1) - segment + emulator.peek(next)));
+    if (emulator.peek(next + 1) == word(next + 2))
+      emulator.poke(segment + 1, word(segment + 2));
+    else
+      emulator.poke(segment + 1, emulator.peek(next + 1));
+  }
+  return 0;
+}
+
+// ---- Output ----
+// 23 lines of 64 characters, 11 pixels high, two characters per screen
+// word; line 0 starts one pixel row down, as in the VM OS
+
+void NativeOS::drawChar(VMEmulator& emulator, int c)
+{
+  const int16_t* rows{ glyph(c) };
+  int address{ screen + m_address };
+  for (int row = 0; row < 11; row++, address += 32)
+  {
+    int16_t kept{ word(emulator.peek(address) & (m_left ? -256 : 255)) };
+    int16_t bits{ m_left ? rows[row] : word(rows[row] * 256) };
+    emulator.poke(address, word(bits | kept));
+  }
+}
+
+void NativeOS::println()
+{
+  m_address += 352 - m_column;
+  m_column = 0;
+  m_left = true;
+  if (m_address == 8128)
+    m_address = 32;
+}
+
+std::optional<int16_t> NativeOS::outputInit(VMEmulator&, const int16_t*)
+{
+  m_column = 0;
+  m_address = 32;
+  m_left = true;
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::outputMoveCursor(VMEmulator& emulator, const int16_t* args)
+{
+  const int16_t i{ args[0] };
+  const int16_t j{ args[1] };
+  if (i < 0 || i > 22 || j < 0 || j > 63)
+  {
+    error(emulator, 20);
+    return 0;
+  }
+
+  m_column = j / 2;
+  m_address = 32 + i * 352 + m_column;
+  m_left = j == m_column * 2;
+  drawChar(emulator, ' ');
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::outputPrintChar(VMEmulator& emulator, const int16_t* args)
+{
+  const int16_t c{ args[0] };
+  if (c == newLine)
+    return outputPrintln(emulator, args);
+  if (c == backSpace)
+    return outputBackSpace(emulator, args);
+
+  drawChar(emulator, c);
+  if (!m_left)
+  {
+    m_column++;
+    m_address++;
+  }
+  if (m_column == 32)
+    println();
+  else
+    m_left = !m_left;
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::outputPrintString(VMEmulator& emulator, const int16_t* args)
+{
+  const int16_t length{ call(emulator, STRING_LENGTH, { args[0] }) };
+  for (int16_t i = 0; i < length; i++)
+  {
+    int16_t c{ call(emulator, STRING_CHAR_AT, { args[0], i }) };
+    outputPrintChar(emulator, &c);
+  }
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::outputPrintInt(VMEmulator& emulator, const int16_t* args)
+{
+  for (int16_t c : decimal(args[0]))
+    outputPrintChar(emulator, &c);
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::outputPrintln(VMEmulator&, const int16_t*)
+{
+  println();
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::outputBackSpace(VMEmulator& emulator, const int16_t*)
+{
+  if (m_left)
+  {
+    if (m_column > 0)
+    {
+      m_column--;
+      m_address--;
+    }
+    else
+    {
+      m_column = 31;
+      if (m_address == 32)
+        m_address = 8128;
+      m_address -= 321;
+    }
+    m_left = false;
+  }
+  else
+  {
+    m_left = true;
+  }
+  drawChar(emulator, ' ');
+  return 0;
+}
+
+// ---- Screen ----
+// Same pixels as the VM OS: its line, rectangle and circle algorithms
+
+void NativeOS::updateLocation(VMEmulator& emulator, int address, int16_t mask)
+{
+  int16_t value{ emulator.peek(screen + address) };
+  emulator.poke(screen + address, m_black ? word(value | mask) : word(value & ~mask));
+}
+
+void NativeOS::drawPixel(VMEmulator& emulator, int x, int y)
+{
+  if (x < 0 || x > 511 || y < 0 || y > 255)
+  {
+    error(emulator, 7);
+    return;
+  }
+  updateLocation(emulator, y * 32 + x / 16, word(1 << (x % 16)));
+}
+
+void NativeOS::drawHorizontal(VMEmulator& emulator, int y, int x1, int x2)
+{
+  int from{ std::min(x1, x2) };
+  int to{ std::max(x1, x2) };
+  if (y < 0 || y > 255 || from > 511 || to < 0)
+    return;
+  from = std::max(from, 0);
+  to = std::min(to, 511);
+
+  const int16_t firstMask{ word(~((1 << (from % 16)) - 1)) };
+  const int16_t lastMask{ word((1 << (to % 16 + 1)) - 1) };
+  int address{ y * 32 + from / 16 };
+  const int last{ y * 32 + to / 16 };
+
+  if (address == last)
+  {
+    updateLocation(emulator, address, word(firstMask & lastMask));
+    return;
+  }
+  updateLocation(emulator, address++, firstMask);
+  while (address < last)
+    updateLocation(emulator, address++, -1);
+  updateLocation(emulator, last, lastMask);
+}
+
+std::optional<int16_t> NativeOS::screenInit(VMEmulator&, const int16_t*)
+{
+  m_black = true;
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::screenClearScreen(VMEmulator& emulator, const int16_t*)
+{
+  for (int address = screen; address < keyboard; address++)
+    emulator.poke(address, 0);
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::screenSetColor(VMEmulator&, const int16_t* args)
+{
+  m_black = args[0] != 0;
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::screenDrawPixel(VMEmulator& emulator, const int16_t* args)
+{
+  drawPixel(emulator, args[0], args[1]);
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::screenDrawLine(VMEmulator& emulator, const int16_t* args)
+{
+  int x1{ args[0] }, y1{ args[1] }, x2{ args[2] }, y2{ args[3] };
+  if (x1 < 0 || x2 > 511 || y1 < 0 || y2 > 255)
+  {
+    error(emulator, 8);
+    return 0;
+  }
+
+  // Walk along the longer axis, from the lower end
+  int dx{ std::abs(x2 - x1) };
+  int dy{ std::abs(y2 - y1) };
+  const bool steep{ dx < dy };
+  if ((steep && y2 < y1) || (!steep && x2 < x1))
+  {
+    std::swap(x1, x2);
+    std::swap(y1, y2);
+  }
+
+  int a{ steep ? y1 : x1 };
+  int b{ steep ? x1 : y1 };
+  const int end{ steep ? y2 : x2 };
+  const bool decreasing{ steep ? x1 > x2 : y1 > y2 };
+  if (steep)
+    std::swap(dx, dy);
+
+  int decision{ 2 * dy - dx };
+  const int straight{ 2 * dy };
+  const int diagonal{ 2 * (dy - dx) };
+
+  steep ? drawPixel(emulator, b, a) : drawPixel(emulator, a, b);
+  while (a < end)
+  {
+    if (decision < 0)
+    {
+      decision += straight;
+    }
+    else
+    {
+      decision += diagonal;
+      b += decreasing ? -1 : 1;
+    }
+    a++;
+    steep ? drawPixel(emulator, b, a) : drawPixel(emulator, a, b);
+  }
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::screenDrawRectangle(VMEmulator& emulator, const int16_t* args)
+{
+  const int x1{ args[0] }, y1{ args[1] }, x2{ args[2] }, y2{ args[3] };
+  if (x1 > x2 || y1 > y2 || x1 < 0 || x2 > 511 || y1 < 0 || y2 > 255)
+  {
+    error(emulator, 9);
+    return 0;
+  }
+
+  for (int y = y1; y <= y2; y++)
+    drawHorizontal(emulator, y, x1, x2);
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::screenDrawCircle(VMEmulator& emulator, const int16_t* args)
+{
+  const int x{ args[0] }, y{ args[1] }, r{ args[2] };
+  if (x < 0 || x > 511 || y < 0 || y > 255)
+  {
+    error(emulator, 12);
+    return 0;
+  }
+  if (x - r < 0 || x + r > 511 || y - r < 0 || y + r > 255)
+  {
+    error(emulator, 13);
+    return 0;
+  }
+
+  // Midpoint circle, filled with horizontal lines in all eight octants
+  auto drawSymmetric = [&](int a, int b)
+  {
+    drawHorizontal(emulator, y - b, x + a, x - a);
+    drawHorizontal(emulator, y + b, x + a, x - a);
+    drawHorizontal(emulator, y - a, x - b, x + b);
+    drawHorizontal(emulator, y + a, x - b, x + b);
+  };
+
+  int dx{ 0 };
+  int dy{ r };
+  int decision{ 1 - r };
+  drawSymmetric(dx, dy);
+  while (dy > dx)
+  {
+    if (decision < 0)
+    {
+      decision += 2 * dx + 3;
+    }
+    else
+    {
+      decision += 2 * (dx - dy) + 5;
+      dy--;
+    }
+    dx++;
+    drawSymmetric(dx, dy);
+  }
+  return 0;
+}
+
+// ---- String ----
+// Fields of the VM String: maxLength, chars (an Array, only when
+// maxLength > 0) and length
+
+std::optional<int16_t> NativeOS::stringNew(VMEmulator& emulator, const int16_t* args)
+{
+  const int16_t maxLength{ args[0] };
+  const int16_t string{ call(emulator, MEMORY_ALLOC, { 3 }) };
+  if (maxLength < 0)
+    error(emulator, 14);
+  if (maxLength > 0)
+    emulator.poke(string + 1, call(emulator, ARRAY_NEW, { maxLength }));
+  emulator.poke(string, maxLength);
+  emulator.poke(string + 2, 0);
+  return string;
+}
+
+std::optional<int16_t> NativeOS::stringDispose(VMEmulator& emulator, const int16_t* args)
+{
+  if (emulator.peek(args[0]) > 0)
+    call(emulator, ARRAY_DISPOSE, { emulator.peek(args[0] + 1) });
+  call(emulator, MEMORY_DEALLOC, { args[0] });
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::stringLength(VMEmulator& emulator, const int16_t* args)
+{
+  return emulator.peek(args[0] + 2);
+}
+
+std::optional<int16_t> NativeOS::stringCharAt(VMEmulator& emulator, const int16_t* args)
+{
+  const int16_t j{ args[1] };
+  if (j < 0 || j >= emulator.peek(args[0] + 2))
+    error(emulator, 15);
+  return emulator.peek(emulator.peek(args[0] + 1) + j);
+}
+
+std::optional<int16_t> NativeOS::stringSetCharAt(VMEmulator& emulator, const int16_t* args)
+{
+  const int16_t j{ args[1] };
+  if (j < 0 || j >= emulator.peek(args[0] + 2))
+    error(emulator, 16);
+  emulator.poke(emulator.peek(args[0] + 1) + j, args[2]);
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::stringAppendChar(VMEmulator& emulator, const int16_t* args)
+{
+  const int16_t length{ emulator.peek(args[0] + 2) };
+  if (length == emulator.peek(args[0]))
+    error(emulator, 17);
+  emulator.poke(emulator.peek(args[0] + 1) + length, args[1]);
+  emulator.poke(args[0] + 2, word(length + 1));
+  return args[0];
+}
+
+std::optional<int16_t> NativeOS::stringEraseLastChar(VMEmulator& emulator, const int16_t* args)
+{
+  const int16_t length{ emulator.peek(args[0] + 2) };
+  if (length == 0)
+    error(emulator, 18);
+  emulator.poke(args[0] + 2, word(length - 1));
+  return 0;
+}
+
+// Optional '-', then digits up to the first non-digit
+std::optional<int16_t> NativeOS::stringIntValue(VMEmulator& emulator, const int16_t* args)
+{
+  const int16_t length{ emulator.peek(args[0] + 2) };
+  const int16_t chars{ emulator.peek(args[0] + 1) };
+  if (length == 0)
+    return 0;
+
+  const bool negative{ emulator.peek(chars) == '-' };
+  int16_t value{ 0 };
+  for (int i = negative ? 1 : 0; i < length; i++)
+  {
+    int16_t digit{ word(emulator.peek(chars + i) - '0') };
+    if (digit < 0 || digit > 9)
+      break;
+    value = word(value * 10 + digit);
+  }
+  return negative ? word(-value) : value;
+}
+
+std::optional<int16_t> NativeOS::stringSetInt(VMEmulator& emulator, const int16_t* args)
+{
+  const int16_t maxLength{ emulator.peek(args[0]) };
+  if (maxLength == 0)
+    error(emulator, 19);
+
+  const std::vector<int16_t> digits{ decimal(args[1]) };
+  if (maxLength < static_cast<int>(digits.size()))
+    error(emulator, 19);
+
+  const int16_t chars{ emulator.peek(args[0] + 1) };
+  for (size_t i = 0; i < digits.size(); i++)
+    emulator.poke(chars + static_cast<int>(i), digits[i]);
+  emulator.poke(args[0] + 2, word(static_cast<int>(digits.size())));
+  return 0;
+}
+
+std::optional<int16_t> NativeOS::stringNewLine(VMEmulator&, const int16_t*)
+{
+  return newLine;
+}
+
+std::optional<int16_t> NativeOS::stringBackSpace(VMEmulator&, const int16_t*)
+{
+  return backSpace;
+}
+
+std::optional<int16_t> NativeOS::stringDoubleQuote(VMEmulator&, const int16_t*)
+{
+  return 34;
+}
+
+// ---- Sys ----
+
+std::optional<int16_t> NativeOS::sysHalt(VMEmulator& emulator, const int16_t*)
+{
+  emulator.halt();
+}
+
+std::optional<int16_t> NativeOS::sysWait(VMEmulator& emulator, const int16_t* args)
+{
+  if (args[0] < 0)
+    error(emulator, 1);
+  return 0;
+}
+
+// "ERR<code>" through Output, then halt
+std::optional<int16_t> NativeOS::sysError(VMEmulator& emulator, const int16_t* args)
+{
+  for (int16_t c : { 'E', 'R', 'R' })
+    call(emulator, OUTPUT_PRINT_CHAR, { c });
+  for (int16_t c : decimal(args[0]))
+    call(emulator, OUTPUT_PRINT_CHAR, { c });
+  emulator.halt();
+}
\ No newline at end of file
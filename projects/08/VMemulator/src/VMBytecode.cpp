@@ -0,0 +1,480 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "VMBytecode.h"
+#include "VMProgram.h"
+#include "CommandType.h"
+#include "StaticLayout.h"
+
+namespace
+{
+  struct LabelUse
+  {
+    uint32_t pc{ 0 };
+    std::string label{};
+  };
+
+  VMOpcode arithmeticOpcode(const std::string& command)
+  {
+    if (command == "add") return VMOpcode::ADD;
+    if (command == "sub") return VMOpcode::SUB;
+    if (command == "neg") return VMOpcode::NEG;
+    if (command == "eq")  return VMOpcode::EQ;
+    if (command == "gt")  return VMOpcode::GT;
+    if (command == "lt")  return VMOpcode::LT;
+    if (command == "and") return VMOpcode::AND;
+    if (command == "or")  return VMOpcode::OR;
+    if (command == "not") return VMOpcode::NOT;
+    throw std::invalid_argument("Unknown arithmetic command: " + command);
+  }
+}
+
+void VMBytecode::emit(VMOpcode op, int a, int b, Origin origin)
+{
+  m_code.push_back({ op, static_cast<uint16_t>(a), b });
+  m_origins.push_back(origin);
+}
+
+VMBytecode::VMBytecode(const VMProgram& program, const std::vector<std::string>& natives)
+{
+  const StaticLayout staticLayout(program);
+
+  // 1. Function table, so calls can be resolved in one pass; natives first,
+  // replacing any VM function of the same name
+  std::unordered_map<std::string, int> functionIndex{};
+  for (const auto& name : natives)
+  {
+    functionIndex.emplace(name, static_cast<int>(m_functions.size()));
+    m_functions.push_back({ name, 0, 0 });
+  }
+  auto isNative = [&](const std::string& name)
+  {
+    auto function{ functionIndex.find(name) };
+    return function != functionIndex.end() && function->second < static_cast<int>(natives.size());
+  };
+
+  for (const auto& vmFile : program)
+  {
+    for (const auto& [type, arg1, arg2] : vmFile.commands)
+    {
+      if (type != CommandType::C_FUNCTION || isNative(arg1))
+        continue;
+      if (!functionIndex.emplace(arg1, static_cast<int>(m_functions.size())).second)
+        throw std::invalid_argument("Function defined twice: " + arg1);
+      m_functions.push_back({ arg1, 0, static_cast<uint16_t>(arg2) });
+    }
+  }
+
+  // 2. Bootstrap, as the translator writes it: SP = 256, call Sys.init,
+  // stop if it returns
+  auto sysInit{ functionIndex.find("Sys.init") };
+  if (sysInit != functionIndex.end())
+  {
+    m_sysInit = sysInit->second;
+    emit(VMOpcode::SET_SP, 0, stackBase, { noFile, 0 });
+    emit(VMOpcode::CALL, 0, m_sysInit, { noFile, 0 });
+    emit(VMOpcode::END, 0, 0, { noFile, 0 });
+  }
+
+  // Native bodies, after the return point used when they call VM code
+  if (!natives.empty())
+  {
+    m_resume = static_cast<uint32_t>(m_code.size());
+    emit(VMOpcode::RESUME, 0, 0, { noFile, 0 });
+    for (size_t n = 0; n < natives.size(); n++)
+    {
+      m_functions[n].entry = static_cast<uint32_t>(m_code.size());
+      emit(VMOpcode::NATIVE, 0, static_cast<int>(n), { noFile, 0 });
+    }
+  }
+  m_start = hasSysInit() ? 0 : static_cast<uint32_t>(m_code.size());
+
+  // 3. Code; labels are scoped by function as in the translator
+  std::unordered_map<std::string, uint32_t> labels{};
+  std::vector<LabelUse> labelUses{};
+
+  for (uint32_t f = 0; f < program.size(); f++)
+  {
+    const VMFile& vmFile{ program[f] };
+    m_fileNames.push_back(vmFile.fileName);
+    const int staticBase{ staticLayout.base(vmFile.fileName) };
+    std::string currentFunctionName{};
+    bool replaced{ false };
+
+    for (uint32_t c = 0; c < vmFile.commands.size(); c++)
+    {
+      const auto& [type, arg1, arg2] = vmFile.commands[c];
+      const Origin origin{ f, c };
+
+      // The VM code of a native function is left out
+      if (type == CommandType::C_FUNCTION)
+        replaced = isNative(arg1);
+      if (replaced)
+        continue;
+
+      const std::string where{ " (" + vmFile.fileName + ", command " + std::to_string(c + 1) + ")" };
+
+      switch (type)
+      {
+      case CommandType::C_ARITHMETIC:
+        emit(arithmeticOpcode(arg1), 0, 0, origin);
+        break;
+      case CommandType::C_PUSH:
+      case CommandType::C_POP:
+      {
+        const bool isPush{ type == CommandType::C_PUSH };
+        if (arg2 > 32767)
+          throw std::invalid_argument("Index out of range: " + arg1 + " " + std::to_string(arg2) + where);
+
+        if (arg1 == "constant" && isPush)
+          emit(VMOpcode::PUSH_CONSTANT, 0, arg2, origin);
+        else if (arg1 == "local")
+          emit(isPush ? VMOpcode::PUSH_LOCAL : VMOpcode::POP_LOCAL, arg2, 0, origin);
+        else if (arg1 == "argument")
+          emit(isPush ? VMOpcode::PUSH_ARGUMENT : VMOpcode::POP_ARGUMENT, arg2, 0, origin);
+        else if (arg1 == "this")
+          emit(isPush ? VMOpcode::PUSH_THIS : VMOpcode::POP_THIS, arg2, 0, origin);
+        else if (arg1 == "that")
+          emit(isPush ? VMOpcode::PUSH_THAT : VMOpcode::POP_THAT, arg2, 0, origin);
+        else if ((arg1 == "temp" && arg2 < 8) || (arg1 == "pointer" && arg2 < 2) || arg1 == "static")
+        {
+          int address{ (arg1 == "temp") ? 5 + arg2 : (arg1 == "pointer") ? 3 + arg2 : staticBase + arg2 };
+          emit(isPush ? VMOpcode::PUSH_FIXED : VMOpcode::POP_FIXED, 0, address, origin);
+        }
+        else
+          throw std::invalid_argument("Invalid segment for " + std::string(isPush ? "push" : "pop") + ": " +
+                                      arg1 + " " + std::to_string(arg2) + where);
+        break;
+      }
+      case CommandType::C_LABEL:
+        if (!labels.emplace(currentFunctionName + "$" + arg1, static_cast<uint32_t>(m_code.size())).second)
+          throw std::invalid_argument("Label defined twice: " + arg1 + where);
+        break;
+      case CommandType::C_GOTO:
+      case CommandType::C_IF:
+        labelUses.push_back({ static_cast<uint32_t>(m_code.size()), currentFunctionName + "$" + arg1 });
+        emit(type == CommandType::C_GOTO ? VMOpcode::GOTO : VMOpcode::IF_GOTO, 0, 0, origin);
+        break;
+      case CommandType::C_FUNCTION:
+        currentFunctionName = arg1;
+        m_functions[static_cast<size_t>(functionIndex.at(arg1))].entry = static_cast<uint32_t>(m_code.size());
+        emit(VMOpcode::FUNCTION, arg2, 0, origin);
+        break;
+      case CommandType::C_CALL:
+      {
+        auto callee{ functionIndex.find(arg1) };
+        if (callee == functionIndex.end())
+          throw std::invalid_argument("Call to undefined function: " + arg1 + where);
+        emit(VMOpcode::CALL, arg2, callee->second, origin);
+        break;
+      }
+      case CommandType::C_RETURN:
+        emit(VMOpcode::RETURN, 0, 0, origin);
+        break;
+      default:
+        throw std::runtime_error("Error: unknown command type");
+      }
+    }
+  }
+
+  // Running off the last function stops the program
+  emit(VMOpcode::END, 0, 0, { noFile, 0 });
+
+  // Return addresses are kept in 16-bit RAM cells
+  if (m_code.size() > 65536)
+    throw std::invalid_argument("Program too large: " + std::to_string(m_code.size()) + " instructions");
+  m_codeView = m_code;
+  m_originsView = m_origins;
+
+  for (const auto& use : labelUses)
+  {
+    auto target{ labels.find(use.label) };
+    if (target == labels.end())
+      throw std::invalid_argument("Undefined label: " + use.label.substr(use.label.find('$') + 1) +
+                                  " (in " + location(use.pc) + ")");
+    m_code[use.pc].b = static_cast<int32_t>(target->second);
+  }
+}
+
+int VMBytecode::functionIndex(const std::string& name) const
+{
+  for (size_t i = 0; i < m_functions.size(); i++)
+  {
+    if (m_functions[i].name == name)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+int VMBytecode::functionAt(uint32_t pc) const
+{
+  // Functions are compiled in table order, so their entries are sorted
+  auto it{ std::upper_bound(m_functions.begin(), m_functions.end(), pc,
+                            [](uint32_t p, const Function& f) { return p < f.entry; }) };
+  if (it == m_functions.begin() || pc >= m_codeView.size() || m_codeView[pc].op == VMOpcode::END)
+    return -1;
+  return static_cast<int>(it - m_functions.begin()) - 1;
+}
+
+std::string VMBytecode::location(uint32_t pc) const
+{
+  if (pc >= m_codeView.size())
+    return "outside the program";
+
+  int function{ functionAt(pc) };
+  const Origin& origin{ m_originsView[pc] };
+  if (m_codeView[pc].op == VMOpcode::NATIVE)
+    return "native " + m_functions[static_cast<size_t>(m_codeView[pc].b)].name;
+  if (origin.file == noFile)
+    return pc + 1 == m_codeView.size() ? "end of program" : "bootstrap";
+
+  std::string text{ m_fileNames[origin.file] + ", command " + std::to_string(origin.command + 1) };
+  if (function >= 0)
+    text += ", in " + m_functions[static_cast<size_t>(function)].name;
+  return text;
+}
+
+// ---- Cache files ----
+//
+// A header, then the code and the origins exactly as they are in memory
+// (run from the mapping as they are), the function and file tables, and
+// the names they point to. Native byte order: a cache file is only read
+// where it was written.
+
+namespace
+{
+  struct CacheHeader
+  {
+    char magic[8]{};
+    uint32_t version{ 0 };
+    uint32_t layout{ 0 };         // sizes of VMInstruction and Origin, byte order
+    uint64_t key{ 0 };
+    uint32_t nCode{ 0 };
+    uint32_t nFunctions{ 0 };
+    uint32_t nFiles{ 0 };
+    uint32_t nNameBytes{ 0 };
+    int32_t sysInit{ -1 };
+    uint32_t start{ 0 };
+    uint32_t resume{ 0 };
+    uint32_t unused{ 0 };
+  };
+
+  struct CacheFunction
+  {
+    uint32_t entry{ 0 };
+    uint32_t name{ 0 };           // offset in the names
+    uint16_t nameLength{ 0 };
+    uint16_t nLocals{ 0 };
+  };
+
+  struct CacheName
+  {
+    uint32_t offset{ 0 };
+    uint32_t length{ 0 };
+  };
+
+  constexpr char cacheMagic[8]{ 'V', 'M', 'B', 'C', 'O', 'D', 'E', '\0' };
+  constexpr uint32_t cacheLayout{ sizeof(VMInstruction) << 24 | sizeof(VMBytecode::Origin) << 16 | 0x0102 };
+
+  static_assert(sizeof(VMInstruction) == 8 && alignof(VMInstruction) <= 8);
+  static_assert(sizeof(CacheHeader) % 8 == 0 && sizeof(CacheFunction) % 4 == 0);
+
+  // 64-bit multiply and xor-shift over 8-byte words
+  uint64_t mix(uint64_t hash, const char* data, size_t size)
+  {
+    constexpr uint64_t multiplier{ 0x9E3779B97F4A7C15ull };
+    size_t i{ 0 };
+    for (; i + 8 <= size; i += 8)
+    {
+      uint64_t word{ 0 };
+      std::memcpy(&word, data + i, 8);
+      hash = (hash ^ word) * multiplier;
+      hash ^= hash >> 32;
+    }
+    for (; i < size; i++)
+    {
+      hash = (hash ^ static_cast<unsigned char>(data[i])) * multiplier;
+      hash ^= hash >> 32;
+    }
+    return (hash ^ size) * multiplier;
+  }
+}
+
+uint64_t VMBytecode::cacheKey(const std::vector<std::filesystem::path>& files, const std::vector<std::string>& natives)
+{
+  uint64_t key{ mix(0, reinterpret_cast<const char*>(&cacheVersion), sizeof cacheVersion) };
+  for (const auto& name : natives)
+    key = mix(key, name.data(), name.size());
+
+  std::string contents{};
+  for (const auto& path : files)
+  {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+      throw std::runtime_error("Unable to open file: " + path.string());
+    in.seekg(0, std::ios::end);
+    contents.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+
+    const std::string name{ path.stem().string() };
+    key = mix(key, name.data(), name.size());
+    key = mix(key, contents.data(), contents.size());
+  }
+  return key;
+}
+
+void VMBytecode::save(const std::filesystem::path& path, uint64_t key) const
+{
+  CacheHeader header{};
+  std::memcpy(header.magic, cacheMagic, sizeof cacheMagic);
+  header.version = cacheVersion;
+  header.layout = cacheLayout;
+  header.key = key;
+  header.nCode = static_cast<uint32_t>(m_codeView.size());
+  header.nFunctions = static_cast<uint32_t>(m_functions.size());
+  header.nFiles = static_cast<uint32_t>(m_fileNames.size());
+  header.sysInit = m_sysInit;
+  header.start = m_start;
+  header.resume = m_resume;
+
+  std::string names{};
+  std::vector<CacheFunction> functions{};
+  std::vector<CacheName> files{};
+  for (const Function& function : m_functions)
+  {
+    functions.push_back({ function.entry, static_cast<uint32_t>(names.size()),
+                          static_cast<uint16_t>(function.name.size()), function.nLocals });
+    names += function.name;
+  }
+  for (const std::string& fileName : m_fileNames)
+  {
+    files.push_back({ static_cast<uint32_t>(names.size()), static_cast<uint32_t>(fileName.size()) });
+    names += fileName;
+  }
+  header.nNameBytes = static_cast<uint32_t>(names.size());
+
+  // Padding bytes cleared, so that the same program gives the same file
+  std::vector<VMInstruction> code(m_codeView.size());
+  std::memset(static_cast<void*>(code.data()), 0, code.size() * sizeof(VMInstruction));
+  for (size_t i = 0; i < code.size(); i++)
+  {
+    code[i].op = m_codeView[i].op;
+    code[i].a = m_codeView[i].a;
+    code[i].b = m_codeView[i].b;
+  }
+
+  // Written aside and renamed, so that a reader never sees half a file
+  const std::filesystem::path temporary{ path.string() + ".tmp" + std::to_string(::getpid()) };
+  {
+    std::ofstream out(temporary, std::ios::binary);
+    auto write = [&](const void* data, size_t size)
+    {
+      out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    };
+    write(&header, sizeof header);
+    write(code.data(), code.size() * sizeof(VMInstruction));
+    write(m_originsView.data(), m_originsView.size() * sizeof(Origin));
+    write(functions.data(), functions.size() * sizeof(CacheFunction));
+    write(files.data(), files.size() * sizeof(CacheName));
+    write(names.data(), names.size());
+    if (!out)
+    {
+      std::error_code ignored{};
+      std::filesystem::remove(temporary, ignored);
+      throw std::runtime_error("Unable to write cache file: " + temporary.string());
+    }
+  }
+  std::filesystem::rename(temporary, path);
+}
+
+std::optional<VMBytecode> VMBytecode::load(const std::filesystem::path& path, uint64_t key)
+{
+  const int fd{ ::open(path.c_str(), O_RDONLY) };
+  if (fd < 0)
+    return std::nullopt;
+  struct stat status{};
+  void* address{ MAP_FAILED };
+  if (::fstat(fd, &status) == 0 && status.st_size >= static_cast<off_t>(sizeof(CacheHeader)))
+    address = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (address == MAP_FAILED)
+    return std::nullopt;
+
+  const size_t size{ static_cast<size_t>(status.st_size) };
+  std::shared_ptr<const void> mapping(address, [size](const void* p) { ::munmap(const_cast<void*>(p), size); });
+  const char* bytes{ static_cast<const char*>(address) };
+
+  CacheHeader header{};
+  std::memcpy(&header, bytes, sizeof header);
+  if (std::memcmp(header.magic, cacheMagic, sizeof cacheMagic) != 0 || header.version != cacheVersion ||
+      header.layout != cacheLayout || header.key != key)
+    return std::nullopt;
+
+  const size_t codeOffset{ sizeof(CacheHeader) };
+  const size_t originsOffset{ codeOffset + size_t{ header.nCode } * sizeof(VMInstruction) };
+  const size_t functionsOffset{ originsOffset + size_t{ header.nCode } * sizeof(Origin) };
+  const size_t filesOffset{ functionsOffset + size_t{ header.nFunctions } * sizeof(CacheFunction) };
+  const size_t namesOffset{ filesOffset + size_t{ header.nFiles } * sizeof(CacheName) };
+  if (namesOffset + header.nNameBytes != size || header.nCode == 0 || header.start >= header.nCode ||
+      header.resume >= header.nCode || header.sysInit >= static_cast<int32_t>(header.nFunctions))
+    return std::nullopt;
+
+  VMBytecode bytecode{};
+  bytecode.m_mapping = std::move(mapping);
+  bytecode.m_codeView = { reinterpret_cast<const VMInstruction*>(bytes + codeOffset), header.nCode };
+  bytecode.m_originsView = { reinterpret_cast<const Origin*>(bytes + originsOffset), header.nCode };
+  bytecode.m_sysInit = header.sysInit;
+  bytecode.m_start = header.start;
+  bytecode.m_resume = header.resume;
+
+  const std::string_view names{ bytes + namesOffset, header.nNameBytes };
+  for (uint32_t i = 0; i < header.nFunctions; i++)
+  {
+    CacheFunction function{};
+    std::memcpy(&function, bytes + functionsOffset + i * sizeof(CacheFunction), sizeof function);
+    if (function.entry >= header.nCode || size_t{ function.name } + function.nameLength > names.size())
+      return std::nullopt;
+    bytecode.m_functions.push_back({ std::string(names.substr(function.name, function.nameLength)),
+                                     function.entry, function.nLocals });
+  }
+  for (uint32_t i = 0; i < header.nFiles; i++)
+  {
+    CacheName file{};
+    std::memcpy(&file, bytes + filesOffset + i * sizeof(CacheName), sizeof file);
+    if (size_t{ file.offset } + file.length > names.size())
+      return std::nullopt;
+    bytecode.m_fileNames.emplace_back(names.substr(file.offset, file.length));
+  }
+
+  // Nothing the interpreter follows without checking may point outside
+  for (const VMInstruction& instruction : bytecode.m_codeView)
+  {
+    const uint32_t b{ static_cast<uint32_t>(instruction.b) };
+    const VMOpcode op{ instruction.op };
+    if (op > VMOpcode::RESUME ||
+        ((op == VMOpcode::GOTO || op == VMOpcode::IF_GOTO) && b >= header.nCode) ||
+        ((op == VMOpcode::CALL || op == VMOpcode::NATIVE) && b >= header.nFunctions) ||
+        ((op == VMOpcode::PUSH_FIXED || op == VMOpcode::POP_FIXED) && b >= 32768))
+      return std::nullopt;
+  }
+  for (const Origin& origin : bytecode.m_originsView)
+  {
+    if (origin.file != noFile && origin.file >= header.nFiles)
+      return std::nullopt;
+  }
+  return bytecode;
+}
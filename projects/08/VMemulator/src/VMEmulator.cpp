@@ -0,0 +1,729 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "VMEmulator.h"
+#include "VMBytecode.h"
+#include "NativeOS.h"
+#include "VMProfiler.h"
+#include "VMMemoryMonitor.h"
+#include "VMTrace.h"
+
+namespace
+{
+  constexpr uint16_t mask{ VMEmulator::memorySize - 1 };
+
+  // One trace instruction over the registers `r`; false where the trace
+  // has to be left. Cells of the trace's own stack, from `base` up, and SP
+  // are only reached through the interpreter. `changed` is set by a write
+  // that changes RAM.
+  inline bool execute(const TraceOp& op, int16_t* r, int16_t* ram, uint16_t base, uint16_t registers,
+                      bool& changed)
+  {
+    auto address = [&]() -> uint16_t
+    {
+      return static_cast<uint16_t>((static_cast<uint16_t>(ram[op.b]) + op.imm) & mask);
+    };
+    auto ownStack = [&](uint16_t address)
+    {
+      return address == 0 || static_cast<uint16_t>((address - base) & mask) < registers;
+    };
+    auto write = [&](uint16_t address, int16_t value)
+    {
+      changed |= ram[address] != value;
+      ram[address] = value;
+    };
+
+    switch (op.op)
+    {
+    case TraceOpcode::CONST:
+      r[op.d] = op.imm;
+      return true;
+    case TraceOpcode::LOAD:
+    {
+      const uint16_t cell{ address() };
+      if (ownStack(cell))
+        return false;
+      r[op.d] = ram[cell];
+      return true;
+    }
+    case TraceOpcode::LOAD_FIXED:
+      r[op.d] = ram[static_cast<uint16_t>(op.imm) & mask];
+      return true;
+    case TraceOpcode::STORE:
+    {
+      const uint16_t cell{ address() };
+      if (ownStack(cell))
+        return false;
+      write(cell, r[op.a]);
+      return true;
+    }
+    case TraceOpcode::STORE_FIXED:
+      write(static_cast<uint16_t>(op.imm) & mask, r[op.a]);
+      return true;
+    case TraceOpcode::ADD:
+      r[op.d] = static_cast<int16_t>(r[op.a] + r[op.b]);
+      return true;
+    case TraceOpcode::SUB:
+      r[op.d] = static_cast<int16_t>(r[op.a] - r[op.b]);
+      return true;
+    case TraceOpcode::AND:
+      r[op.d] = static_cast<int16_t>(r[op.a] & r[op.b]);
+      return true;
+    case TraceOpcode::OR:
+      r[op.d] = static_cast<int16_t>(r[op.a] | r[op.b]);
+      return true;
+    case TraceOpcode::EQ:
+      r[op.d] = r[op.a] == r[op.b] ? -1 : 0;
+      return true;
+    case TraceOpcode::GT:
+      r[op.d] = r[op.a] > r[op.b] ? -1 : 0;
+      return true;
+    case TraceOpcode::LT:
+      r[op.d] = r[op.a] < r[op.b] ? -1 : 0;
+      return true;
+    case TraceOpcode::ADD_IMM:
+      r[op.d] = static_cast<int16_t>(r[op.a] + op.imm);
+      return true;
+    case TraceOpcode::AND_IMM:
+      r[op.d] = static_cast<int16_t>(r[op.a] & op.imm);
+      return true;
+    case TraceOpcode::OR_IMM:
+      r[op.d] = static_cast<int16_t>(r[op.a] | op.imm);
+      return true;
+    case TraceOpcode::EQ_IMM:
+      r[op.d] = r[op.a] == op.imm ? -1 : 0;
+      return true;
+    case TraceOpcode::GT_IMM:
+      r[op.d] = r[op.a] > op.imm ? -1 : 0;
+      return true;
+    case TraceOpcode::LT_IMM:
+      r[op.d] = r[op.a] < op.imm ? -1 : 0;
+      return true;
+    case TraceOpcode::NEG:
+      r[op.d] = static_cast<int16_t>(-r[op.a]);
+      return true;
+    case TraceOpcode::NOT:
+      r[op.d] = static_cast<int16_t>(~r[op.a]);
+      return true;
+    case TraceOpcode::GUARD_TRUE:
+      return r[op.a] != 0;
+    case TraceOpcode::GUARD_FALSE:
+      return r[op.a] == 0;
+    }
+    return false;
+  }
+
+  // Back to the interpreter: the live stack slots written out from the
+  // registers and the constants
+  void leave(const TraceExit& exit, const int16_t* r, int16_t* ram, uint16_t base, uint32_t& pc, uint16_t& sp)
+  {
+    for (uint16_t slot = 0; slot < exit.depth; slot++)
+      ram[(base + slot) & mask] = r[slot];
+    for (const auto& [slot, value] : exit.constants)
+      ram[(base + slot) & mask] = value;
+    sp = static_cast<uint16_t>(base + exit.depth);
+    pc = exit.pc;
+  }
+}
+
+VMEmulator::VMEmulator(const VMBytecode& bytecode, NativeOS* natives)
+  : m_bytecode(bytecode)
+  , m_natives(natives)
+  , m_ram(memorySize, 0)
+  , m_traceAt(bytecode.code().size(), -1)
+  , m_heat(bytecode.code().size(), 0)
+{
+  if (m_natives)
+    m_natives->bind(m_bytecode);
+  reset();
+}
+
+void VMEmulator::reset() noexcept
+{
+  m_pc = m_bytecode.start();
+  m_steps = 0;
+  m_stackPeak = 0;
+  m_depth = 0;
+  m_resumed = false;
+}
+
+int16_t VMEmulator::call(int function, std::initializer_list<int16_t> args)
+{
+  constexpr uint16_t mask{ memorySize - 1 };
+  const VMBytecode::Function& callee{ m_bytecode.functions()[static_cast<size_t>(function)] };
+  const VMInstruction& entry{ m_bytecode.code()[callee.entry] };
+
+  // Native to native: a plain C++ call. One that has to wait for the
+  // keyboard can never be run again from here.
+  if (m_profiler)
+    m_profiler->enter(function, m_steps);
+  if (entry.op == VMOpcode::NATIVE)
+  {
+    if (m_monitor)
+      m_monitor->enter(function, args.begin(), static_cast<uint16_t>(m_ram[0]), m_steps);
+    std::optional<int16_t> value{ m_natives->run(static_cast<size_t>(entry.b), *this, args.begin()) };
+    if (!value)
+      halt();
+    if (m_profiler)
+      m_profiler->leave(m_steps);
+    if (m_monitor)
+      m_monitor->leave(*value, static_cast<uint16_t>(m_ram[0]), m_steps);
+    return *value;
+  }
+
+  // Arguments and the frame CALL pushes, returning to RESUME
+  uint16_t sp{ static_cast<uint16_t>(m_ram[0]) };
+  for (int16_t arg : args)
+    m_ram[sp++ & mask] = arg;
+  for (int16_t value : { static_cast<int16_t>(m_bytecode.resume()), m_ram[1], m_ram[2], m_ram[3], m_ram[4] })
+    m_ram[sp++ & mask] = value;
+  m_ram[2] = static_cast<int16_t>(sp - 5 - args.size());
+  m_ram[1] = static_cast<int16_t>(sp);
+  m_ram[0] = static_cast<int16_t>(sp);
+  if (m_monitor)
+    m_monitor->enter(function, &m_ram[static_cast<uint16_t>(m_ram[2]) & mask], sp, m_steps);
+
+  const uint32_t pc{ m_pc };
+  m_pc = callee.entry;
+  m_nativeWrote = true;
+  m_depth++;
+  Stop stop{ Stop::STEPS };
+  try
+  {
+    stop = run(m_maxSteps);
+  }
+  catch (...)
+  {
+    m_depth--;
+    throw;
+  }
+  m_depth--;
+
+  if (!m_resumed)
+    throw Interrupt{ stop };
+  m_resumed = false;
+  m_pc = pc;
+
+  // The return value, where the arguments were
+  sp = static_cast<uint16_t>(m_ram[0] - 1);
+  m_ram[0] = static_cast<int16_t>(sp);
+  return m_ram[sp & mask];
+}
+
+void VMEmulator::halt()
+{
+  throw Interrupt{ Stop::HALT };
+}
+
+// One iteration of the loop at `pc`, translated and executed instruction
+// by instruction. A loop that leaves through anything but its header, calls
+// or returns, or is too long, is left to the interpreter for good.
+bool VMEmulator::recordTrace(uint32_t& pc, uint16_t& sp, uint64_t& steps, uint64_t maxSteps)
+{
+  const VMInstruction* code{ m_bytecode.code().data() };
+  const size_t codeSize{ m_bytecode.code().size() };
+  int16_t* ram{ m_ram.data() };
+  const uint32_t header{ pc };
+  const uint16_t base{ sp };
+  const uint64_t start{ steps };
+  TraceRecorder recorder{ header };
+  int16_t r[TraceRecorder::maxRegisters]{};
+  bool changed{ false };
+
+  m_traceAt[header] = -2;
+  while (pc < codeSize && steps < maxSteps && recorder.trace().length < TraceRecorder::maxLength &&
+         TraceRecorder::traceable(code[pc].op))
+  {
+    const VMInstruction& instruction{ code[pc] };
+    const uint16_t depth{ recorder.depth() };
+    const bool taken{ instruction.op == VMOpcode::GOTO ||
+                      (instruction.op == VMOpcode::IF_GOTO && depth > 0 && recorder.value(static_cast<uint16_t>(depth - 1), r) != 0) };
+    const size_t first{ recorder.trace().ops.size() };
+    if (!recorder.add(instruction, pc, taken))
+      break;
+
+    const Trace& trace{ recorder.trace() };
+    for (size_t i = first; i < trace.ops.size(); i++)
+    {
+      if (!execute(trace.ops[i], r, ram, base, trace.registers, changed))
+      {
+        const TraceExit& exit{ trace.exits[trace.ops[i].exit] };
+        leave(exit, r, ram, base, pc, sp);
+        steps = start + exit.steps;
+        m_stackPeak = std::max(m_stackPeak, static_cast<uint16_t>(base + exit.peak));
+        return false;
+      }
+    }
+    steps++;
+
+    // Back at the header with the stack as it was closes the loop; any
+    // other backward jump is an inner loop
+    const uint32_t next{ taken ? static_cast<uint32_t>(instruction.b) : pc + 1 };
+    if (taken && next <= pc)
+    {
+      if (next == header && recorder.depth() == 0)
+      {
+        pc = header;
+        m_stackPeak = std::max(m_stackPeak, static_cast<uint16_t>(base + trace.registers));
+        m_traceAt[header] = static_cast<int32_t>(m_traces.size());
+        m_traces.push_back(trace);
+        return true;
+      }
+      pc = next;
+      break;
+    }
+    pc = next;
+  }
+
+  for (uint16_t slot = 0; slot < recorder.depth(); slot++)
+    ram[(base + slot) & mask] = recorder.value(slot, r);
+  sp = static_cast<uint16_t>(base + recorder.depth());
+  m_stackPeak = std::max(m_stackPeak, static_cast<uint16_t>(base + recorder.trace().registers));
+  return false;
+}
+
+// Iterations of `trace` from its header until a guard fails or the next
+// iteration would pass maxSteps; true if an iteration changed nothing, so
+// that the loop can never be left
+bool VMEmulator::runTrace(const Trace& trace, uint32_t& pc, uint16_t& sp, uint64_t& steps, uint64_t maxSteps)
+{
+  int16_t* ram{ m_ram.data() };
+  const TraceOp* ops{ trace.ops.data() };
+  const size_t nOps{ trace.ops.size() };
+  const uint16_t base{ sp };
+  int16_t r[TraceRecorder::maxRegisters]{};
+
+  while (steps + trace.length <= maxSteps)
+  {
+    bool changed{ false };
+    for (size_t i = 0; i < nOps; i++)
+    {
+      if (!execute(ops[i], r, ram, base, trace.registers, changed))
+      {
+        const TraceExit& exit{ trace.exits[ops[i].exit] };
+        leave(exit, r, ram, base, pc, sp);
+        steps += exit.steps;
+        m_stackPeak = std::max(m_stackPeak, static_cast<uint16_t>(base + exit.peak));
+        return false;
+      }
+    }
+    steps += trace.length;
+    m_stackPeak = std::max(m_stackPeak, static_cast<uint16_t>(base + trace.registers));
+    if (!changed)
+      return true;
+  }
+  return false;
+}
+
+VMEmulator::Stop VMEmulator::run(uint64_t maxSteps)
+{
+  constexpr uint16_t mask{ memorySize - 1 };
+  constexpr uint16_t LCL{ 1 };
+  constexpr uint16_t ARG{ 2 };
+  constexpr uint16_t THIS{ 3 };
+  constexpr uint16_t THAT{ 4 };
+
+  m_maxSteps = maxSteps;
+  VMProfiler* const profiler{ m_profiler };
+  VMMemoryMonitor* const monitor{ m_monitor };
+  KeyboardLog* const keys{ m_keyboard };
+  const VMInstruction* code{ m_bytecode.code().data() };
+  const size_t codeSize{ m_bytecode.code().size() };
+  const VMBytecode::Function* functions{ m_bytecode.functions().data() };
+  int16_t* ram{ m_ram.data() };
+
+  // SP lives in a register and is written back to RAM[0] whenever RAM can
+  // be reached through a pointer (this/that) and on exit
+  uint32_t pc{ m_pc };
+  uint16_t sp{ static_cast<uint16_t>(ram[0]) };
+  uint64_t steps{ m_steps };
+  uint16_t peak{ m_stackPeak };
+  Stop stop{ Stop::STEPS };
+
+  // Steps run to the next key event, or to maxSteps
+  uint64_t limit{ keys ? std::min(maxSteps, keys->next()) : maxSteps };
+
+  // Halt detection, as in HackEmulator: the state at the last jump target,
+  // and the cells written since then with the values they had there
+  int64_t loopTarget{ -1 };
+  uint16_t loopSp{ 0 };
+  std::pair<uint16_t, int16_t> written[maxLoopWrites]{};
+  size_t nWritten{ 0 };
+
+  auto store = [&](uint16_t address, int16_t value)
+  {
+    address &= mask;
+    if (nWritten <= maxLoopWrites && ram[address] != value)
+    {
+      bool seen{ false };
+      for (size_t i = 0; i < nWritten && !seen; i++)
+        seen = written[i].first == address;
+      if (!seen && nWritten < maxLoopWrites)
+        written[nWritten] = { address, ram[address] };
+      if (!seen)
+        nWritten++;
+    }
+    ram[address] = value;
+  };
+
+  // The monitor hears of a new stack peak at the next call or return,
+  // made at instruction `at`; of one past the heap base right away, so
+  // that a collision is recorded at the step that causes it
+  uint16_t reportedPeak{ peak };
+  auto reportPeak = [&](uint32_t at)
+  {
+    if (peak > reportedPeak)
+    {
+      reportedPeak = peak;
+      monitor->stackPeak(peak, at, steps);
+    }
+  };
+
+  auto reportCollision = [&](uint32_t at)
+  {
+    if (monitor && peak > VMMemoryMonitor::heapBase)
+      reportPeak(at);
+  };
+
+  auto push = [&](int16_t value)
+  {
+    store(sp, value);
+    sp++;
+    peak = std::max(peak, sp);
+    reportCollision(pc - 1);
+  };
+
+  auto pop = [&]() -> int16_t
+  {
+    sp--;
+    return ram[sp & mask];
+  };
+
+  auto cell = [&](uint16_t pointer, int index) -> uint16_t
+  {
+    return static_cast<uint16_t>((static_cast<uint16_t>(ram[pointer]) + index) & mask);
+  };
+
+  // Same target, SP and memory as on the previous arrival: the loop will
+  // repeat forever. The target is that of the last backward jump, so that
+  // forward jumps inside the loop body (if/else) leave it be.
+  auto jump = [&](uint32_t target, bool backward) -> bool
+  {
+    pc = target;
+    if (target != loopTarget && !backward)
+      return false;
+    bool same{ target == loopTarget && sp == loopSp && nWritten <= maxLoopWrites };
+    for (size_t i = 0; i < nWritten && same; i++)
+      same = ram[written[i].first] == written[i].second;
+    loopTarget = target;
+    loopSp = sp;
+    nWritten = 0;
+    return same;
+  };
+
+  auto forgetLoop = [&]()
+  {
+    loopTarget = -1;
+    nWritten = 0;
+  };
+
+  // A backward jump has come to `pc`: once the loop there is hot it runs
+  // as a trace. Trace writes are not tracked for halt detection.
+  auto loop = [&]()
+  {
+    const uint32_t header{ pc };
+    m_stackPeak = peak;
+    if (m_traceAt[header] == -1 && ++m_heat[header] == hotLoop)
+    {
+      recordTrace(pc, sp, steps, limit);
+      forgetLoop();
+    }
+    if (m_traceAt[header] >= 0 && pc == header)
+    {
+      if (runTrace(m_traces[static_cast<size_t>(m_traceAt[header])], pc, sp, steps, limit))
+        stop = Stop::HALT;
+      forgetLoop();
+    }
+    peak = std::max(peak, m_stackPeak);
+    reportCollision(pc);
+  };
+
+  // Return with `value`: the frame of the translated code, popped
+  auto ret = [&](int16_t value)
+  {
+    const uint16_t frame{ static_cast<uint16_t>(ram[LCL]) };
+    const uint16_t returnAddress{ static_cast<uint16_t>(ram[(frame - 5) & mask]) };
+    const uint16_t arg{ static_cast<uint16_t>(ram[ARG]) };
+    if (monitor)
+      reportPeak(pc - 1);
+
+    store(arg, value);
+    sp = static_cast<uint16_t>(arg + 1);
+    store(THAT, ram[(frame - 1) & mask]);
+    store(THIS, ram[(frame - 2) & mask]);
+    store(ARG, ram[(frame - 3) & mask]);
+    store(LCL, ram[(frame - 4) & mask]);
+    pc = returnAddress;
+    if (profiler)
+      profiler->leave(steps);
+    if (monitor)
+      monitor->leave(value, sp, steps);
+  };
+
+  auto compare = [&](auto holds)
+  {
+    int16_t y{ pop() };
+    uint16_t top{ static_cast<uint16_t>((sp - 1) & mask) };
+    store(top, holds(ram[top], y) ? -1 : 0);
+  };
+
+  auto binary = [&](auto op)
+  {
+    int16_t y{ pop() };
+    uint16_t top{ static_cast<uint16_t>((sp - 1) & mask) };
+    store(top, static_cast<int16_t>(op(ram[top], y)));
+  };
+
+  while (true)
+  {
+    if (steps >= limit)
+    {
+      if (steps >= maxSteps)
+        break;
+      ram[keyboard] = keys->deliver();
+      forgetLoop();
+      limit = std::min(maxSteps, keys->next());
+      continue;
+    }
+    if (pc >= codeSize)
+    {
+      stop = Stop::END;
+      break;
+    }
+
+    const VMInstruction& instruction{ code[pc] };
+    steps++;
+    pc++;
+
+    switch (instruction.op)
+    {
+    case VMOpcode::PUSH_CONSTANT:
+      push(static_cast<int16_t>(instruction.b));
+      break;
+    case VMOpcode::PUSH_LOCAL:
+      push(ram[cell(LCL, instruction.a)]);
+      break;
+    case VMOpcode::PUSH_ARGUMENT:
+      push(ram[cell(ARG, instruction.a)]);
+      break;
+    case VMOpcode::PUSH_THIS:
+      ram[0] = static_cast<int16_t>(sp);
+      push(ram[cell(THIS, instruction.a)]);
+      break;
+    case VMOpcode::PUSH_THAT:
+      ram[0] = static_cast<int16_t>(sp);
+      push(ram[cell(THAT, instruction.a)]);
+      break;
+    case VMOpcode::PUSH_FIXED:
+      push(ram[instruction.b]);
+      break;
+    case VMOpcode::POP_LOCAL:
+    {
+      int16_t value{ pop() };
+      store(cell(LCL, instruction.a), value);
+      break;
+    }
+    case VMOpcode::POP_ARGUMENT:
+    {
+      int16_t value{ pop() };
+      store(cell(ARG, instruction.a), value);
+      break;
+    }
+    case VMOpcode::POP_THIS:
+    case VMOpcode::POP_THAT:
+    {
+      int16_t value{ pop() };
+      ram[0] = static_cast<int16_t>(sp);
+      store(cell(instruction.op == VMOpcode::POP_THIS ? THIS : THAT, instruction.a), value);
+      sp = static_cast<uint16_t>(ram[0]);
+      break;
+    }
+    case VMOpcode::POP_FIXED:
+    {
+      int16_t value{ pop() };
+      store(static_cast<uint16_t>(instruction.b), value);
+      break;
+    }
+    case VMOpcode::ADD:
+      binary([](int16_t x, int16_t y) { return x + y; });
+      break;
+    case VMOpcode::SUB:
+      binary([](int16_t x, int16_t y) { return x - y; });
+      break;
+    case VMOpcode::AND:
+      binary([](int16_t x, int16_t y) { return x & y; });
+      break;
+    case VMOpcode::OR:
+      binary([](int16_t x, int16_t y) { return x | y; });
+      break;
+    case VMOpcode::EQ:
+      compare([](int16_t x, int16_t y) { return x == y; });
+      break;
+    case VMOpcode::GT:
+      compare([](int16_t x, int16_t y) { return x > y; });
+      break;
+    case VMOpcode::LT:
+      compare([](int16_t x, int16_t y) { return x < y; });
+      break;
+    case VMOpcode::NEG:
+    {
+      uint16_t top{ static_cast<uint16_t>((sp - 1) & mask) };
+      store(top, static_cast<int16_t>(-ram[top]));
+      break;
+    }
+    case VMOpcode::NOT:
+    {
+      uint16_t top{ static_cast<uint16_t>((sp - 1) & mask) };
+      store(top, static_cast<int16_t>(~ram[top]));
+      break;
+    }
+    case VMOpcode::GOTO:
+    {
+      const bool backward{ static_cast<uint32_t>(instruction.b) < pc };
+      if (jump(static_cast<uint32_t>(instruction.b), backward))
+        stop = Stop::HALT;
+      else if (backward && m_jit)
+        loop();
+      break;
+    }
+    case VMOpcode::IF_GOTO:
+      if (pop() != 0)
+      {
+        const bool backward{ static_cast<uint32_t>(instruction.b) < pc };
+        if (jump(static_cast<uint32_t>(instruction.b), backward))
+          stop = Stop::HALT;
+        else if (backward && m_jit)
+          loop();
+      }
+      break;
+    case VMOpcode::CALL:
+    {
+      // The frame the translated code pushes: return address, LCL, ARG,
+      // THIS, THAT; then ARG = SP - 5 - nArgs and LCL = SP
+      push(static_cast<int16_t>(pc));
+      push(ram[LCL]);
+      push(ram[ARG]);
+      push(ram[THIS]);
+      push(ram[THAT]);
+      store(ARG, static_cast<int16_t>(sp - 5 - instruction.a));
+      store(LCL, static_cast<int16_t>(sp));
+      if (monitor)
+        reportPeak(pc - 1);
+      pc = functions[instruction.b].entry;
+      if (profiler)
+        profiler->enter(instruction.b, steps);
+      if (monitor)
+        monitor->enter(instruction.b, ram + cell(ARG, 0), sp, steps);
+      if (m_callStop && m_depth == 0)
+        stop = Stop::CALL;
+      break;
+    }
+    case VMOpcode::FUNCTION:
+      for (int i = 0; i < instruction.a; i++)
+        push(0);
+      break;
+    case VMOpcode::RETURN:
+      ret(ram[(sp - 1) & mask]);
+      break;
+    case VMOpcode::NATIVE:
+    {
+      // Called like a VM function: arguments and frame are on the stack
+      const size_t native{ static_cast<size_t>(instruction.b) };
+      int16_t args[NativeOS::maxArgs]{};
+      for (int i = 0; i < m_natives->nArgs(native); i++)
+        args[i] = ram[cell(ARG, i)];
+
+      ram[0] = static_cast<int16_t>(sp);
+      m_pc = pc - 1;
+      m_steps = steps;
+      m_stackPeak = peak;
+      m_nativeWrote = false;
+      std::optional<int16_t> value{};
+      try
+      {
+        value = m_natives->run(native, *this, args);
+      }
+      catch (const Interrupt& interrupt)
+      {
+        pc = m_pc;
+        sp = static_cast<uint16_t>(ram[0]);
+        steps = m_steps;
+        peak = m_stackPeak;
+        stop = interrupt.stop;
+        break;
+      }
+      sp = static_cast<uint16_t>(ram[0]);
+      steps = m_steps;
+      peak = m_stackPeak;
+
+      // Native writes are not tracked: a loop around them is no halt. A
+      // native waiting for the keyboard runs again, as a jump to itself.
+      if (value)
+      {
+        if (m_nativeWrote)
+          forgetLoop();
+        ret(*value);
+      }
+      else if (m_nativeWrote)
+      {
+        pc--;
+        forgetLoop();
+      }
+      else if (jump(pc - 1, true))
+      {
+        stop = Stop::HALT;
+      }
+      break;
+    }
+    case VMOpcode::RESUME:
+      if (m_depth == 0)
+        throw std::runtime_error("A native function stopped by the step limit cannot be resumed");
+      pc--;
+      m_resumed = true;
+      stop = Stop::END;
+      break;
+    case VMOpcode::SET_SP:
+      sp = static_cast<uint16_t>(instruction.b);
+      break;
+    case VMOpcode::END:
+      pc--;
+      stop = Stop::END;
+      break;
+    }
+
+    // Waiting for a key that is still to come is no halt
+    if (stop == Stop::HALT && keys && keys->wait(steps))
+    {
+      stop = Stop::STEPS;
+      limit = steps;
+    }
+    if (stop != Stop::STEPS)
+      break;
+  }
+
+  ram[0] = static_cast<int16_t>(sp);
+  m_pc = pc;
+  m_steps = steps;
+  m_stackPeak = peak;
+  if (profiler)
+    profiler->stop(steps);
+  if (monitor)
+    reportPeak(pc);
+  if (monitor && m_depth == 0)
+    monitor->stop(sp, steps);
+  return stop;
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "VMMemoryMonitor.h"
+#include "VMBytecode.h"
+
+VMMemoryMonitor::VMMemoryMonitor(const VMBytecode& bytecode, uint64_t interval)
+  : m_bytecode(bytecode)
+  , m_alloc(bytecode.functionIndex("Memory.alloc"))
+  , m_deAlloc(bytecode.functionIndex("Memory.deAlloc"))
+  , m_interval(std::max<uint64_t>(interval, 1))
+{
+}
+
+void VMMemoryMonitor::sample(uint16_t sp, uint64_t steps)
+{
+  m_now.steps = steps;
+  m_now.sp = sp;
+  m_samples.push_back(m_now);
+  m_nextSample = steps + m_interval;
+}
+
+void VMMemoryMonitor::enter(int function, const int16_t* args, uint16_t sp, uint64_t steps)
+{
+  if (function == m_alloc)
+  {
+    m_pending.push_back({ m_depth, static_cast<uint16_t>(args[0]) });
+  }
+  else if (function == m_deAlloc)
+  {
+    auto block{ m_blocks.find(static_cast<uint16_t>(args[0])) };
+    if (block != m_blocks.end())
+    {
+      m_now.liveWords -= block->second;
+      m_blocks.erase(block);
+    }
+    m_now.deAllocs++;
+    m_now.liveBlocks = static_cast<uint32_t>(m_blocks.size());
+    sample(sp, steps);
+  }
+  else if (steps >= m_nextSample)
+  {
+    sample(sp, steps);
+  }
+  m_depth++;
+}
+
+void VMMemoryMonitor::leave(int16_t value, uint16_t sp, uint64_t steps)
+{
+  if (m_depth > 0)
+    m_depth--;
+  if (m_pending.empty() || m_pending.back().depth != m_depth)
+  {
+    if (steps >= m_nextSample)
+      sample(sp, steps);
+    return;
+  }
+
+  const uint16_t address{ static_cast<uint16_t>(value) };
+  const uint16_t size{ m_pending.back().size };
+  const uint32_t end{ uint32_t{ address } + size };
+  m_pending.pop_back();
+
+  if (address < heapBase || end > heapEnd)
+  {
+    m_collisions.push_back({ steps, "Memory.alloc(" + std::to_string(size) + ") returned " +
+                                    std::to_string(address) + ".." + std::to_string(end - 1) +
+                                    ", outside the heap" });
+  }
+  m_blocks[address] = size;
+  m_now.allocs++;
+  m_now.liveBlocks = static_cast<uint32_t>(m_blocks.size());
+  m_now.liveWords += size;
+  m_now.heapTop = static_cast<uint16_t>(std::max<uint32_t>(m_now.heapTop, end));
+  sample(sp, steps);
+}
+
+void VMMemoryMonitor::stackPeak(uint16_t sp, uint32_t pc, uint64_t steps)
+{
+  m_now.stackPeak = std::max(m_now.stackPeak, sp);
+  if (sp > heapBase && !m_stackCollided)
+  {
+    m_stackCollided = true;
+    m_collisions.push_back({ steps, "the stack reached the heap (SP " + std::to_string(sp) + ") at " +
+                                    m_bytecode.location(pc) });
+  }
+}
+
+void VMMemoryMonitor::stop(uint16_t sp, uint64_t steps)
+{
+  sample(sp, steps);
+}
+
+void VMMemoryMonitor::writeReport(std::ostream& output) const
+{
+  const int stackBase{ VMBytecode::stackBase };
+  output << "Stack: peak SP " << m_now.stackPeak << " ("
+         << std::max(0, m_now.stackPeak - stackBase) << " of " << heapBase - stackBase << " words)\n";
+  output << "Heap: high-water " << m_now.heapTop << ", " << m_now.allocs << " allocs, " << m_now.deAllocs
+         << " deAllocs, " << m_now.liveBlocks << " blocks (" << m_now.liveWords << " words) still allocated\n";
+  if (m_alloc < 0)
+    output << "Heap: no Memory.alloc in the program\n";
+  if (m_collisions.empty())
+    output << "Collisions: none\n";
+  for (const Collision& collision : m_collisions)
+    output << "Collision at step " << collision.steps << ": " << collision.what << '\n';
+}
+
+void VMMemoryMonitor::writeSeries(std::ostream& output) const
+{
+  output << "steps,sp,stack_peak,heap_top,allocs,deallocs,live_blocks,live_words\n";
+  for (const Sample& s : m_samples)
+  {
+    output << s.steps << ',' << s.sp << ',' << s.stackPeak << ',' << s.heapTop << ',' << s.allocs << ','
+           << s.deAllocs << ',' << s.liveBlocks << ',' << s.liveWords << '\n';
+  }
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "VMProfiler.h"
+#include "VMBytecode.h"
+
+VMProfiler::VMProfiler(const VMBytecode& bytecode)
+  : m_bytecode(bytecode)
+{
+}
+
+void VMProfiler::account(uint64_t steps)
+{
+  if (steps > m_lastSteps)
+    m_nodes[m_current].self += steps - m_lastSteps;
+  m_lastSteps = steps;
+}
+
+std::string VMProfiler::name(int function) const
+{
+  return function < 0 ? "(top)" : m_bytecode.functions()[static_cast<size_t>(function)].name;
+}
+
+void VMProfiler::enter(int function, uint64_t steps)
+{
+  account(steps);
+
+  uint32_t child{ 0 };
+  for (uint32_t c : m_nodes[m_current].children)
+  {
+    if (m_nodes[c].function == function)
+    {
+      child = c;
+      break;
+    }
+  }
+  if (child == 0)
+  {
+    child = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.push_back({ function, m_current, 0, 0, {} });
+    m_nodes[m_current].children.push_back(child);
+  }
+
+  m_current = child;
+  m_nodes[child].calls++;
+}
+
+// A return from the root (a test script that set up a frame by hand)
+// stays there
+void VMProfiler::leave(uint64_t steps)
+{
+  account(steps);
+  m_current = m_nodes[m_current].parent;
+}
+
+void VMProfiler::stop(uint64_t steps)
+{
+  account(steps);
+}
+
+void VMProfiler::writeReport(std::ostream& output) const
+{
+  struct Totals
+  {
+    int function{ -1 };
+    uint64_t calls{ 0 };
+    uint64_t exclusive{ 0 };
+    uint64_t inclusive{ 0 };
+  };
+
+  const size_t nFunctions{ m_bytecode.functions().size() };
+  std::vector<Totals> totals(nFunctions + 1);
+  std::vector<uint64_t> inclusive(m_nodes.size(), 0);
+  std::vector<int> active(nFunctions + 1, 0);
+  auto slot = [&](int function) { return function < 0 ? nFunctions : static_cast<size_t>(function); };
+
+  // Children are always created after their parent: inclusive counts
+  // bottom-up, then a walk down the tree adds each node to its function
+  // unless the function is already active above it
+  for (size_t n = m_nodes.size(); n-- > 0; )
+  {
+    inclusive[n] += m_nodes[n].self;
+    if (n > 0)
+      inclusive[m_nodes[n].parent] += inclusive[n];
+  }
+
+  std::vector<std::pair<uint32_t, bool>> pending{ { 0, false } };
+  while (!pending.empty())
+  {
+    auto [n, done] = pending.back();
+    pending.pop_back();
+    const Node& node{ m_nodes[n] };
+    Totals& total{ totals[slot(node.function)] };
+    if (done)
+    {
+      active[slot(node.function)]--;
+      continue;
+    }
+
+    total.function = node.function;
+    total.calls += node.calls;
+    total.exclusive += node.self;
+    if (active[slot(node.function)]++ == 0)
+      total.inclusive += inclusive[n];
+
+    pending.push_back({ n, true });
+    for (uint32_t c : node.children)
+      pending.push_back({ c, false });
+  }
+
+  totals.erase(std::remove_if(totals.begin(), totals.end(),
+                              [](const Totals& t) { return t.calls == 0 && t.exclusive == 0; }),
+               totals.end());
+  std::sort(totals.begin(), totals.end(),
+            [](const Totals& a, const Totals& b) { return a.exclusive > b.exclusive; });
+
+  const double all{ static_cast<double>(std::max<uint64_t>(inclusive[0], 1)) };
+  output << std::left << std::setw(32) << "Function" << std::right
+         << std::setw(12) << "Calls" << std::setw(16) << "Exclusive" << std::setw(8) << "%"
+         << std::setw(16) << "Inclusive" << std::setw(8) << "%" << '\n';
+  output << std::fixed << std::setprecision(1);
+  for (const Totals& t : totals)
+  {
+    output << std::left << std::setw(32) << name(t.function) << std::right
+           << std::setw(12) << t.calls
+           << std::setw(16) << t.exclusive << std::setw(7) << 100.0 * static_cast<double>(t.exclusive) / all << '%'
+           << std::setw(16) << t.inclusive << std::setw(7) << 100.0 * static_cast<double>(t.inclusive) / all << '%'
+           << '\n';
+  }
+}
+
+void VMProfiler::writeFolded(std::ostream& output) const
+{
+  std::vector<std::string> paths(m_nodes.size());
+  for (size_t n = 0; n < m_nodes.size(); n++)
+  {
+    const Node& node{ m_nodes[n] };
+    paths[n] = (n == 0) ? name(node.function) : paths[node.parent] + ";" + name(node.function);
+    if (node.self > 0)
+      output << paths[n] << ' ' << node.self << '\n';
+  }
+}
\ No newline at end of file
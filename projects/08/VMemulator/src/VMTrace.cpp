@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "VMTrace.h"
+#include "VMBytecode.h"
+
+namespace
+{
+  // Segment base pointer in RAM of a PUSH_x / POP_x opcode
+  int basePointer(VMOpcode op)
+  {
+    switch (op)
+    {
+    case VMOpcode::PUSH_LOCAL: case VMOpcode::POP_LOCAL: return 1;
+    case VMOpcode::PUSH_ARGUMENT: case VMOpcode::POP_ARGUMENT: return 2;
+    case VMOpcode::PUSH_THIS: case VMOpcode::POP_THIS: return 3;
+    default: return 4;
+    }
+  }
+
+  // Stack slots an instruction reads
+  int operands(VMOpcode op)
+  {
+    switch (op)
+    {
+    case VMOpcode::ADD: case VMOpcode::SUB: case VMOpcode::AND: case VMOpcode::OR:
+    case VMOpcode::EQ: case VMOpcode::GT: case VMOpcode::LT:
+      return 2;
+    case VMOpcode::POP_LOCAL: case VMOpcode::POP_ARGUMENT: case VMOpcode::POP_THIS: case VMOpcode::POP_THAT:
+    case VMOpcode::POP_FIXED: case VMOpcode::NEG: case VMOpcode::NOT: case VMOpcode::IF_GOTO:
+      return 1;
+    default:
+      return 0;
+    }
+  }
+
+  int16_t fold(VMOpcode op, int16_t x, int16_t y)
+  {
+    switch (op)
+    {
+    case VMOpcode::ADD: return static_cast<int16_t>(x + y);
+    case VMOpcode::SUB: return static_cast<int16_t>(x - y);
+    case VMOpcode::AND: return static_cast<int16_t>(x & y);
+    case VMOpcode::OR:  return static_cast<int16_t>(x | y);
+    case VMOpcode::EQ:  return x == y ? -1 : 0;
+    case VMOpcode::GT:  return x > y ? -1 : 0;
+    default:            return x < y ? -1 : 0;
+    }
+  }
+
+  TraceOpcode registerForm(VMOpcode op)
+  {
+    switch (op)
+    {
+    case VMOpcode::ADD: return TraceOpcode::ADD;
+    case VMOpcode::SUB: return TraceOpcode::SUB;
+    case VMOpcode::AND: return TraceOpcode::AND;
+    case VMOpcode::OR:  return TraceOpcode::OR;
+    case VMOpcode::EQ:  return TraceOpcode::EQ;
+    case VMOpcode::GT:  return TraceOpcode::GT;
+    default:            return TraceOpcode::LT;
+    }
+  }
+
+  // x op c, with the constant on the right; SUB has none (x - c is an ADD)
+  TraceOpcode immediateForm(VMOpcode op)
+  {
+    switch (op)
+    {
+    case VMOpcode::ADD: case VMOpcode::SUB: return TraceOpcode::ADD_IMM;
+    case VMOpcode::AND: return TraceOpcode::AND_IMM;
+    case VMOpcode::OR:  return TraceOpcode::OR_IMM;
+    case VMOpcode::EQ:  return TraceOpcode::EQ_IMM;
+    case VMOpcode::GT:  return TraceOpcode::GT_IMM;
+    default:            return TraceOpcode::LT_IMM;
+    }
+  }
+}
+
+TraceRecorder::TraceRecorder(uint32_t header)
+  : m_constants(maxRegisters)
+{
+  m_trace.header = header;
+}
+
+void TraceRecorder::emit(TraceOpcode op, int d, int a, int b, int imm)
+{
+  m_trace.ops.push_back({ op, static_cast<uint8_t>(d), static_cast<uint8_t>(a), static_cast<uint8_t>(b),
+                          static_cast<int16_t>(imm), 0 });
+}
+
+uint16_t TraceRecorder::exit(uint32_t pc, uint16_t depth, uint16_t steps)
+{
+  TraceExit exit{ pc, depth, steps, m_trace.registers, {} };
+  for (uint16_t slot = 0; slot < depth; slot++)
+    if (m_constants[slot])
+      exit.constants.push_back({ slot, *m_constants[slot] });
+  m_trace.exits.push_back(std::move(exit));
+  return static_cast<uint16_t>(m_trace.exits.size() - 1);
+}
+
+// A constant slot that must be in its register: stored, or on the left of
+// a SUB
+void TraceRecorder::materialize(uint16_t slot)
+{
+  if (m_constants[slot])
+    emit(TraceOpcode::CONST, slot, 0, 0, *m_constants[slot]);
+}
+
+int16_t TraceRecorder::value(uint16_t slot, const int16_t* registers) const
+{
+  return m_constants[slot] ? *m_constants[slot] : registers[slot];
+}
+
+bool TraceRecorder::add(const VMInstruction& instruction, uint32_t pc, bool taken)
+{
+  const VMOpcode op{ instruction.op };
+  if (m_depth < operands(op) || (op <= VMOpcode::PUSH_FIXED && m_depth + 1u >= maxRegisters))
+    return false;
+
+  // LOAD and STORE leave before the instruction, guards after it
+  const uint16_t before{ m_trace.length++ };
+  const uint16_t top{ static_cast<uint16_t>(m_depth - 1) };
+
+  switch (op)
+  {
+  case VMOpcode::PUSH_CONSTANT:
+    m_constants[m_depth++] = static_cast<int16_t>(instruction.b);
+    break;
+  case VMOpcode::PUSH_LOCAL:
+  case VMOpcode::PUSH_ARGUMENT:
+  case VMOpcode::PUSH_THIS:
+  case VMOpcode::PUSH_THAT:
+    m_constants[m_depth] = std::nullopt;
+    emit(TraceOpcode::LOAD, m_depth, 0, basePointer(op), instruction.a);
+    m_trace.ops.back().exit = exit(pc, m_depth++, before);
+    break;
+  case VMOpcode::PUSH_FIXED:
+    m_constants[m_depth] = std::nullopt;
+    emit(TraceOpcode::LOAD_FIXED, m_depth++, 0, 0, instruction.b);
+    break;
+  case VMOpcode::POP_LOCAL:
+  case VMOpcode::POP_ARGUMENT:
+  case VMOpcode::POP_THIS:
+  case VMOpcode::POP_THAT:
+    materialize(top);
+    emit(TraceOpcode::STORE, 0, top, basePointer(op), instruction.a);
+    m_trace.ops.back().exit = exit(pc, m_depth--, before);
+    break;
+  case VMOpcode::POP_FIXED:
+    materialize(top);
+    emit(TraceOpcode::STORE_FIXED, 0, top, 0, instruction.b);
+    m_depth--;
+    break;
+  case VMOpcode::ADD:
+  case VMOpcode::SUB:
+  case VMOpcode::AND:
+  case VMOpcode::OR:
+  case VMOpcode::EQ:
+  case VMOpcode::GT:
+  case VMOpcode::LT:
+  {
+    const uint16_t x{ static_cast<uint16_t>(m_depth - 2) };
+    const uint16_t y{ top };
+    const std::optional<int16_t> cx{ m_constants[x] };
+    const std::optional<int16_t> cy{ m_constants[y] };
+    const bool commutative{ op == VMOpcode::ADD || op == VMOpcode::AND || op == VMOpcode::OR || op == VMOpcode::EQ };
+
+    if (cx && cy)
+    {
+      m_constants[x] = fold(op, *cx, *cy);
+    }
+    else if (cy)
+    {
+      emit(immediateForm(op), x, x, 0, op == VMOpcode::SUB ? -*cy : *cy);
+      m_constants[x] = std::nullopt;
+    }
+    else if (cx && (commutative || op == VMOpcode::GT || op == VMOpcode::LT))
+    {
+      // c > y is y < c, c < y is y > c
+      TraceOpcode form{ op == VMOpcode::GT ? TraceOpcode::LT_IMM :
+                        op == VMOpcode::LT ? TraceOpcode::GT_IMM : immediateForm(op) };
+      emit(form, x, y, 0, *cx);
+      m_constants[x] = std::nullopt;
+    }
+    else
+    {
+      materialize(x);
+      emit(registerForm(op), x, x, y, 0);
+      m_constants[x] = std::nullopt;
+    }
+    m_depth--;
+    break;
+  }
+  case VMOpcode::NEG:
+  case VMOpcode::NOT:
+    if (m_constants[top])
+      m_constants[top] = static_cast<int16_t>(op == VMOpcode::NEG ? -*m_constants[top] : ~*m_constants[top]);
+    else
+      emit(op == VMOpcode::NEG ? TraceOpcode::NEG : TraceOpcode::NOT, top, top, 0, 0);
+    break;
+  case VMOpcode::GOTO:
+    break;
+  case VMOpcode::IF_GOTO:
+  {
+    m_depth--;
+    if (m_constants[top])
+      break;
+    emit(taken ? TraceOpcode::GUARD_TRUE : TraceOpcode::GUARD_FALSE, 0, top, 0, 0);
+    m_trace.ops.back().exit = exit(taken ? pc + 1 : static_cast<uint32_t>(instruction.b), m_depth, m_trace.length);
+    break;
+  }
+  default:
+    m_trace.length--;
+    return false;
+  }
+  m_trace.registers = std::max(m_trace.registers, m_depth);
+  return true;
+}
\ No newline at end of file
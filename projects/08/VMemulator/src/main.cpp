@@ -0,0 +1,359 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <optional>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include "InputFiles.h"
+#include "Translator.h"
+#include "VMBytecode.h"
+#include "VMEmulator.h"
+#include "NativeOS.h"
+#include "VMProfiler.h"
+#include "KeyboardLog.h"
+#include "VMMemoryMonitor.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  struct Range
+  {
+    int first{ 0 };
+    int last{ 0 };
+  };
+
+  // "a=b" or "a-b": two integers around the separator
+  bool parsePair(const std::string& text, char separator, int& first, int& second)
+  {
+    size_t position{ text.find(separator, 1) };
+    if (position == std::string::npos)
+      return false;
+    try
+    {
+      size_t end{ 0 };
+      first = std::stoi(text.substr(0, position), &end);
+      if (end != position)
+        return false;
+      std::string rest{ text.substr(position + 1) };
+      second = std::stoi(rest, &end);
+      return end == rest.size();
+    }
+    catch (const std::exception&)
+    {
+      return false;
+    }
+  }
+
+  bool isAddress(int address)
+  {
+    return address >= 0 && address < static_cast<int>(VMEmulator::memorySize);
+  }
+
+  const char* stopName(VMEmulator::Stop stop)
+  {
+    switch (stop)
+    {
+    case VMEmulator::Stop::STEPS: return "step limit";
+    case VMEmulator::Stop::HALT:  return "halt";
+    case VMEmulator::Stop::END:   return "end";
+    case VMEmulator::Stop::CALL:  return "call";
+    }
+    return "";
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  // --max-steps N: stop after N VM commands (default 1e9)
+  // --set addr=value: RAM contents before the run, e.g. the keyboard
+  // --dump from-to: RAM cells to print after the run
+  // --native all|Class,...: run those OS classes as C++ instead of VM code
+  // --profile: calls and instructions per function after the run
+  // --folded file: instructions per call path, for flame graphs
+  // --no-jit: interpret hot loops too, instead of running them as traces
+  // --keys file: keyboard events to replay, "step key" per line
+  // --record file: when the program waits for input, characters typed on
+  //   stdin are pressed and released; every event is written to file
+  // --memory: peak stack, heap use and stack/heap collisions after the run
+  // --memory-series file: the same counters over time, as CSV
+  // --cache dir: compiled programs kept in dir, keyed by the .vm contents
+  uint64_t maxSteps{ 1000000000 };
+  std::vector<std::pair<int, int>> settings{};
+  std::vector<Range> dumps{};
+  std::optional<std::vector<std::string>> nativeClasses{};
+  bool profile{ false };
+  bool jit{ true };
+  std::string foldedPath{};
+  std::string keysPath{};
+  std::string recordPath{};
+  std::string cacheDir{};
+  bool memory{ false };
+  std::string seriesPath{};
+  std::string inputPath{};
+  bool usage{ false };
+
+  for (int i = 1; i < argc && !usage; i++)
+  {
+    std::string arg{ argv[i] };
+    if ((arg == "--max-steps" || arg == "--set" || arg == "--dump" || arg == "--native" ||
+         arg == "--folded" || arg == "--keys" || arg == "--record" ||
+         arg == "--cache" || arg == "--memory-series") && i + 1 == argc)
+    {
+      usage = true;
+    }
+    else if (arg == "--max-steps")
+    {
+      std::string value{ argv[++i] };
+      usage = value.empty() || !std::all_of(value.begin(), value.end(), ::isdigit);
+      if (!usage)
+        maxSteps = std::stoull(value);
+    }
+    else if (arg == "--set")
+    {
+      int address{ 0 }, value{ 0 };
+      usage = !parsePair(argv[++i], '=', address, value) || !isAddress(address) ||
+              value < -32768 || value > 65535;
+      settings.push_back({ address, value });
+    }
+    else if (arg == "--dump")
+    {
+      Range range{};
+      usage = !parsePair(argv[++i], '-', range.first, range.last) ||
+              !isAddress(range.first) || !isAddress(range.last) || range.first > range.last;
+      dumps.push_back(range);
+    }
+    else if (arg == "--profile")
+    {
+      profile = true;
+    }
+    else if (arg == "--no-jit")
+    {
+      jit = false;
+    }
+    else if (arg == "--folded")
+    {
+      foldedPath = argv[++i];
+    }
+    else if (arg == "--keys")
+    {
+      keysPath = argv[++i];
+    }
+    else if (arg == "--record")
+    {
+      recordPath = argv[++i];
+    }
+    else if (arg == "--cache")
+    {
+      cacheDir = argv[++i];
+    }
+    else if (arg == "--memory")
+    {
+      memory = true;
+    }
+    else if (arg == "--memory-series")
+    {
+      seriesPath = argv[++i];
+    }
+    else if (arg == "--native")
+    {
+      std::string list{ argv[++i] };
+      nativeClasses = std::vector<std::string>{};
+      if (list == "all")
+        *nativeClasses = NativeOS::classNames();
+      for (size_t start = 0; list != "all" && start <= list.size(); )
+      {
+        size_t end{ std::min(list.find(',', start), list.size()) };
+        nativeClasses->push_back(list.substr(start, end - start));
+        start = end + 1;
+      }
+    }
+    else if (arg.starts_with("-"))
+    {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return 1;
+    }
+    else if (inputPath.empty())
+    {
+      inputPath = arg;
+    }
+    else
+    {
+      usage = true;
+    }
+  }
+
+  if (usage || inputPath.empty())
+  {
+    std::cerr << "Usage: VMemulator [--max-steps N] [--set addr=value]... [--dump from-to]... [--native all|Class,...]\n"
+              << "                  [--profile] [--folded file] [--no-jit]\n"
+              << "                  [--keys file] [--record file] [--cache dir]\n"
+              << "                  [--memory] [--memory-series file] <file.vm | directory>" << std::endl;
+    return 1;
+  }
+
+  fs::path inPath(inputPath);
+  std::vector<fs::path> vmFiles;
+  if (fs::is_directory(inPath))
+  {
+    // stessi file, nello stesso ordine, del VMtranslator
+    for (const auto& entry :
+         fs::recursive_directory_iterator(inPath, fs::directory_options::skip_permission_denied))
+    {
+      if (entry.is_regular_file() && entry.path().extension() == ".vm")
+        vmFiles.push_back(entry.path());
+    }
+    std::sort(vmFiles.begin(), vmFiles.end(),
+              [](const fs::path& a, const fs::path& b){
+                return a.generic_string() < b.generic_string();
+              });
+  }
+  else if (fs::is_regular_file(inPath) && inPath.extension() == ".vm")
+  {
+    vmFiles.push_back(inPath);
+  }
+  else
+  {
+    std::cerr << "Unable to access " << inPath << " as a .vm file or directory" << std::endl;
+    return 1;
+  }
+
+  if (vmFiles.empty())
+  {
+    std::cerr << "No .vm files in directory (recursively): " << inPath << std::endl;
+    return 1;
+  }
+
+  try
+  {
+    std::optional<NativeOS> natives{};
+    if (nativeClasses)
+      natives.emplace(*nativeClasses);
+    const std::vector<std::string> nativeNames{ natives ? natives->functionNames() : std::vector<std::string>{} };
+
+    // Parsed and compiled only when the cache does not have it already
+    std::optional<VMBytecode> loaded{};
+    fs::path cachePath{};
+    uint64_t cacheKey{ 0 };
+    if (!cacheDir.empty())
+    {
+      cacheKey = VMBytecode::cacheKey(vmFiles, nativeNames);
+      std::ostringstream name{};
+      name << std::hex << std::setw(16) << std::setfill('0') << cacheKey << ".vmbc";
+      cachePath = fs::path(cacheDir) / name.str();
+      loaded = VMBytecode::load(cachePath, cacheKey);
+    }
+    if (!loaded)
+    {
+      VMProgram program{};
+      for (const auto& p : vmFiles)
+      {
+        InputFile inputFile{ p.stem().string(), std::ifstream(p) };
+        if (!inputFile.file)
+        {
+          std::cerr << "Unable to open file: " << p << std::endl;
+          return 1;
+        }
+        program.push_back(Translator::parseFile(inputFile));
+      }
+      loaded.emplace(program, nativeNames);
+      if (!cacheDir.empty())
+      {
+        fs::create_directories(cacheDir);
+        loaded->save(cachePath, cacheKey);
+      }
+    }
+    const VMBytecode& bytecode{ *loaded };
+    VMEmulator emulator(bytecode, natives ? &*natives : nullptr);
+    emulator.setJit(jit);
+    VMProfiler profiler(bytecode);
+    if (profile || !foldedPath.empty())
+      emulator.setProfiler(&profiler);
+    VMMemoryMonitor monitor(bytecode);
+    if (memory || !seriesPath.empty())
+      emulator.setMonitor(&monitor);
+    for (const auto& [address, value] : settings)
+      emulator.ram(static_cast<uint16_t>(address)) = static_cast<int16_t>(value);
+
+    std::optional<KeyboardLog> keys{};
+    if (!keysPath.empty())
+    {
+      std::ifstream in(keysPath);
+      if (!in)
+      {
+        std::cerr << "Unable to open keyboard log: " << keysPath << std::endl;
+        return 1;
+      }
+      keys.emplace(in);
+    }
+    else if (!recordPath.empty())
+    {
+      keys.emplace();
+    }
+    if (!recordPath.empty())
+      keys->type(std::cin);
+    if (keys)
+      emulator.setKeyboard(&*keys);
+
+    auto start{ std::chrono::steady_clock::now() };
+    VMEmulator::Stop stop{ emulator.run(maxSteps) };
+    std::chrono::duration<double, std::milli> elapsed{ std::chrono::steady_clock::now() - start };
+
+    std::cout << "Stopped: " << stopName(stop) << " after " << emulator.steps()
+              << " steps (" << elapsed.count() << " ms) at " << bytecode.location(emulator.pc())
+              << std::endl;
+    if (profile)
+      profiler.writeReport(std::cout);
+    if (!foldedPath.empty())
+    {
+      std::ofstream folded(foldedPath);
+      if (!folded)
+      {
+        std::cerr << "Unable to create output file: " << foldedPath << std::endl;
+        return 1;
+      }
+      profiler.writeFolded(folded);
+    }
+    if (memory)
+      monitor.writeReport(std::cout);
+    if (!seriesPath.empty())
+    {
+      std::ofstream series(seriesPath);
+      if (!series)
+      {
+        std::cerr << "Unable to create output file: " << seriesPath << std::endl;
+        return 1;
+      }
+      monitor.writeSeries(series);
+    }
+    if (!recordPath.empty())
+    {
+      std::ofstream record(recordPath);
+      if (!record)
+      {
+        std::cerr << "Unable to create output file: " << recordPath << std::endl;
+        return 1;
+      }
+      keys->write(record);
+    }
+
+    for (const Range& range : dumps)
+    {
+      for (int address = range.first; address <= range.last; address++)
+        std::cout << "RAM[" << address << "] = " << emulator.ram(static_cast<uint16_t>(address)) << std::endl;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
\ No newline at end of file
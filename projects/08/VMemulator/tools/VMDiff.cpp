@@ -0,0 +1,721 @@
+// Differential test of the translator against the VM emulator.
+//
+//   VMDiff [-O0] [-O1] [-O2] [--max-steps N] [--max-cycles N]
+//          [--set addr=value]... [--cmp file.cmp] <file.vm | directory>
+//
+// The program runs on the VMEmulator and, in lockstep, as Hack code from the
+// translator at each level (all three by default) on the HackEmulator. Both
+// stop at every function entry: the Hack run at the label of the function,
+// the VM run at its next call of the same function. RAM is compared there,
+// and the first difference is reported with the call it was found at.
+//
+// Below -O2 every call arrives in the Hack code, in the same order, with the
+// same frames. At -O2 a leaf function may have been inlined at some of its
+// calls and a multiplication folded into shifts, which never arrive, and
+// the register allocator moves locals and arguments to temp and static
+// cells: there VM calls of leaf functions and of Math.multiply (with all
+// the calls it makes) are skipped until one matches, and only the callee's
+// arguments are compared on the stack; temp is left out, and statics are
+// compared by name. Functions that start with a loop are no stopping
+// point: a jump back to the loop reaches the same address as a call. Return addresses are
+// never compared (instruction indices on one side, ROM addresses on the
+// other), nor R13-R15 and the cells above SP.
+// Halts are found within the code between two calls only, so a program that
+// waits for the keyboard in a loop that calls runs to the limits.
+//
+// With --cmp the final RAM of every run is also checked against the cells
+// of the first output line of a reference comparison file.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <optional>
+#include <filesystem>
+#include <algorithm>
+#include <regex>
+#include <unistd.h>
+#include "InputFiles.h"
+#include "Translator.h"
+#include "StaticLayout.h"
+#include "VMBytecode.h"
+#include "VMEmulator.h"
+#include "HackAssembler.h"
+#include "HackEmulator.h"
+#include "OutputBuffer.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  constexpr uint16_t SP{ 0 }, LCL{ 1 }, ARG{ 2 };
+  constexpr uint16_t stackBase{ 256 };
+  constexpr uint16_t heapBase{ 2048 };
+
+  struct Limits
+  {
+    uint64_t maxSteps{ 100000000 };
+    uint64_t maxCycles{ 1000000000 };
+  };
+
+  struct Difference
+  {
+    uint16_t address{ 0 };      // on the VM side
+    int16_t vmValue{ 0 };
+    int16_t hackValue{ 0 };
+    std::string region{};
+    size_t count{ 0 };          // differing cells in the same region
+  };
+
+  struct StaticCell
+  {
+    std::string name{};
+    uint16_t vmAddress{ 0 };
+    uint16_t hackAddress{ 0 };
+  };
+
+  // Translated code of one level: the function whose label is at every ROM
+  // address (-1: none), the ROM addresses to stop at, and where each static
+  // variable of the VM program ended up
+  struct HackProgram
+  {
+    std::vector<uint16_t> rom{};
+    std::vector<int> functionAt{};
+    std::vector<bool> entries{};
+    std::vector<StaticCell> statics{};
+  };
+
+  const char* levelName(OptimizationLevel level)
+  {
+    switch (level)
+    {
+    case OptimizationLevel::O0: return "-O0";
+    case OptimizationLevel::O1: return "-O1";
+    case OptimizationLevel::O2: return "-O2";
+    }
+    return "";
+  }
+
+  bool parseCount(const std::string& value, uint64_t& count)
+  {
+    if (value.empty() || !std::all_of(value.begin(), value.end(), ::isdigit))
+      return false;
+    count = std::stoull(value);
+    return true;
+  }
+
+  // "File.i address" lines, as written by StaticLayout::writeMap
+  std::map<std::string, uint16_t> readStaticMap(std::istream& in)
+  {
+    std::map<std::string, uint16_t> cells{};
+    std::string name{};
+    int address{ 0 };
+    while (in >> name >> address)
+      cells[name] = static_cast<uint16_t>(address);
+    return cells;
+  }
+
+  // Per function: whether it calls nothing but Math.multiply (a leaf once
+  // -O2 has folded those calls, which may then be inlined), and whether a
+  // jump goes back to its first command
+  void analyze(const VMBytecode& bytecode, std::vector<bool>& leaf, std::vector<bool>& loopAtEntry)
+  {
+    const auto code{ bytecode.code() };
+    const auto& functions{ bytecode.functions() };
+    const int multiply{ bytecode.functionIndex("Math.multiply") };
+    leaf.assign(functions.size(), true);
+    loopAtEntry.assign(functions.size(), false);
+
+    for (uint32_t pc = 0; pc < code.size(); pc++)
+    {
+      const int function{ bytecode.functionAt(pc) };
+      if (code[pc].op == VMOpcode::CALL && code[pc].b != multiply && function >= 0)
+        leaf[static_cast<size_t>(function)] = false;
+      if (code[pc].op == VMOpcode::GOTO || code[pc].op == VMOpcode::IF_GOTO)
+      {
+        const uint32_t target{ static_cast<uint32_t>(code[pc].b) };
+        const int targetFunction{ bytecode.functionAt(target) };
+        if (targetFunction >= 0 && functions[static_cast<size_t>(targetFunction)].entry + 1 == target)
+          loopAtEntry[static_cast<size_t>(targetFunction)] = true;
+      }
+    }
+  }
+
+  HackProgram translate(const std::vector<fs::path>& vmFiles, const VMBytecode& bytecode,
+                        const std::map<std::string, uint16_t>& vmStatics, const std::vector<bool>& loopAtEntry,
+                        OptimizationLevel level)
+  {
+    InputFiles inputFiles{};
+    for (const auto& p : vmFiles)
+    {
+      inputFiles.push_back({ p.stem().string(), std::ifstream(p) });
+      if (!inputFiles.back().file)
+        throw std::runtime_error("Unable to open file: " + p.string());
+    }
+
+    // The translator writes its static map to a file only
+    const fs::path mapPath{ fs::temp_directory_path() / ("VMDiff." + std::to_string(getpid()) + ".map") };
+    std::ostringstream text{};
+    TranslatorOptions options{};
+    options.level = level;
+    options.staticMap = mapPath.string();
+    Translator(inputFiles, text, options).translate();
+
+    std::ifstream mapFile(mapPath);
+    const std::map<std::string, uint16_t> hackStatics{ readStaticMap(mapFile) };
+    mapFile.close();
+    fs::remove(mapPath);
+
+    OutputBuffer code{};
+    code << text.str();
+    std::vector<HackAssembler::Object> objects{ HackAssembler::assemble(code) };
+    HackAssembler::SymbolTable symbols{};
+
+    HackProgram program{};
+    program.rom = HackAssembler::link(objects, symbols);
+    program.functionAt.assign(program.rom.size(), -1);
+    program.entries.assign(program.rom.size(), false);
+    const auto& functions{ bytecode.functions() };
+    for (size_t i = 0; i < functions.size(); i++)
+    {
+      auto symbol{ symbols.find(functions[i].name) };
+      if (symbol != symbols.end() && symbol->second < program.rom.size() && !loopAtEntry[i])
+      {
+        program.functionAt[symbol->second] = static_cast<int>(i);
+        program.entries[symbol->second] = true;
+      }
+    }
+
+    for (const auto& [name, address] : vmStatics)
+    {
+      auto hackCell{ hackStatics.find(name) };
+      if (hackCell != hackStatics.end())
+        program.statics.push_back({ name, address, hackCell->second });
+    }
+    return program;
+  }
+
+  // Cells holding return addresses: LCL - 5 of every frame on the VM
+  // stack, which may have grown past the heap base
+  std::vector<bool> returnAddresses(const VMEmulator& vm)
+  {
+    constexpr int maxFrames{ VMEmulator::memorySize / 5 };
+    std::vector<bool> cells(VMEmulator::memorySize, false);
+    int frame{ vm.ram(LCL) };
+    for (int depth = 0; frame >= stackBase + 5 && frame < vm.ram(SP) + 1 && depth < maxFrames; depth++)
+    {
+      cells[static_cast<size_t>(frame - 5)] = true;
+      frame = vm.ram(static_cast<uint16_t>(frame - 4));
+    }
+    return cells;
+  }
+
+  void compareRange(const VMEmulator& vm, const HackEmulator& hack, int first, int last, const char* region,
+                    std::optional<Difference>& difference, const std::vector<bool>* skip = nullptr)
+  {
+    // Most calls change nothing here: one block comparison first
+    const auto vmCells{ vm.memory().subspan(static_cast<size_t>(first), static_cast<size_t>(last - first)) };
+    if (!skip && std::equal(vmCells.begin(), vmCells.end(), hack.memory().begin() + first))
+      return;
+
+    std::optional<Difference> found{};
+    for (int address = first; address < last; address++)
+    {
+      const uint16_t cell{ static_cast<uint16_t>(address) };
+      if ((skip && (*skip)[cell]) || vm.ram(cell) == hack.ram(cell))
+        continue;
+      if (!found)
+        found = Difference{ cell, vm.ram(cell), hack.ram(cell), region, 0 };
+      found->count++;
+    }
+    if (found && !difference)
+      difference = found;
+  }
+
+  void compareStatics(const VMEmulator& vm, const HackEmulator& hack, const std::vector<StaticCell>& statics,
+                      std::optional<Difference>& difference)
+  {
+    std::optional<Difference> found{};
+    for (const auto& cell : statics)
+    {
+      if (vm.ram(cell.vmAddress) == hack.ram(cell.hackAddress))
+        continue;
+      if (!found)
+        found = Difference{ cell.vmAddress, vm.ram(cell.vmAddress), hack.ram(cell.hackAddress), "static " + cell.name, 0 };
+      found->count++;
+    }
+    if (found && !difference)
+      difference = found;
+  }
+
+  // Heap and screen, from above the stack of either side if it has grown
+  // that far
+  void compareHeap(const VMEmulator& vm, const HackEmulator& hack, std::optional<Difference>& difference)
+  {
+    const int first{ std::max({ static_cast<int>(heapBase), static_cast<int>(vm.ram(SP)), static_cast<int>(hack.ram(SP)) }) };
+    compareRange(vm, hack, first, HackEmulator::keyboard, "heap and screen", difference);
+  }
+
+  // At the entry of a function; `sameFrames` says whether the stack and
+  // temp must be the same, otherwise only the arguments are compared
+  std::optional<Difference> compareAtEntry(const VMEmulator& vm, const HackEmulator& hack,
+                                           const HackProgram& program, bool sameFrames)
+  {
+    std::optional<Difference> difference{};
+    if (sameFrames)
+    {
+      compareRange(vm, hack, SP, ARG + 1, "SP, LCL, ARG", difference);
+      if (!difference)
+      {
+        const std::vector<bool> skip{ returnAddresses(vm) };
+        compareRange(vm, hack, stackBase, vm.ram(SP), "stack", difference, &skip);
+      }
+      compareRange(vm, hack, 5, 13, "temp", difference);
+    }
+    else
+    {
+      // Wherever each side has put them
+      const int nArgs{ vm.ram(LCL) - 5 - vm.ram(ARG) };
+      for (int i = 0; i < nArgs && !difference; i++)
+      {
+        const uint16_t vmCell{ static_cast<uint16_t>(vm.ram(ARG) + i) };
+        const uint16_t hackCell{ static_cast<uint16_t>(hack.ram(ARG) + i) };
+        if (vm.ram(vmCell) != hack.ram(hackCell))
+          difference = Difference{ vmCell, vm.ram(vmCell), hack.ram(hackCell), "argument " + std::to_string(i), 1 };
+      }
+    }
+    compareRange(vm, hack, 3, 5, "THIS, THAT", difference);
+    compareStatics(vm, hack, program.statics, difference);
+    compareHeap(vm, hack, difference);
+    return difference;
+  }
+
+  // Everything but the stack, once both runs are over
+  std::optional<Difference> compareAtEnd(const VMEmulator& vm, const HackEmulator& hack,
+                                         const HackProgram& program, bool sameFrames)
+  {
+    std::optional<Difference> difference{};
+    if (sameFrames)
+      compareRange(vm, hack, 5, 13, "temp", difference);
+    compareRange(vm, hack, 3, 5, "THIS, THAT", difference);
+    compareStatics(vm, hack, program.statics, difference);
+    compareHeap(vm, hack, difference);
+    return difference;
+  }
+
+  std::string describe(const Difference& difference)
+  {
+    std::ostringstream out{};
+    out << "  RAM[" << difference.address << "] (" << difference.region << "): VM " << difference.vmValue
+        << ", Hack " << difference.hackValue;
+    if (difference.count > 1)
+      out << " (" << difference.count << " cells differ)";
+    out << "\n";
+    return out.str();
+  }
+
+  // The cells between the '|' of a .cmp line, trimmed
+  std::vector<std::string> splitColumns(const std::string& line)
+  {
+    std::vector<std::string> columns{};
+    std::istringstream in{ line };
+    std::string cell{};
+    std::getline(in, cell, '|');    // before the first '|'
+    while (std::getline(in, cell, '|'))
+    {
+      const size_t first{ cell.find_first_not_of(" \t\r") };
+      columns.push_back(first == std::string::npos ? "" : cell.substr(first, cell.find_last_not_of(" \t\r") - first + 1));
+    }
+    if (!columns.empty() && columns.back().empty())
+      columns.pop_back();
+    return columns;
+  }
+
+  // Reference cells: the RAM[n] columns of the first output line. Columns
+  // are as wide as their values, so the official files cut the header of a
+  // four-digit address to "RAM[3006"; any other column is an error.
+  std::vector<std::pair<uint16_t, int16_t>> readComparison(const std::string& path)
+  {
+    std::ifstream in(path);
+    if (!in)
+      throw std::runtime_error("Unable to open comparison file: " + path);
+
+    std::string header{}, values{};
+    std::getline(in, header);
+    std::getline(in, values);
+    const std::vector<std::string> names{ splitColumns(header) };
+    const std::vector<std::string> cells{ splitColumns(values) };
+    if (names.empty() || names.size() != cells.size())
+      throw std::runtime_error("Header and values do not match in comparison file: " + path);
+
+    const std::regex ram(R"(RAM\[(\d+)\]?)");
+    const std::regex number(R"(-?\d+)");
+    std::vector<std::pair<uint16_t, int16_t>> reference{};
+    for (size_t i = 0; i < names.size(); i++)
+    {
+      std::smatch match{};
+      if (!std::regex_match(names[i], match, ram) || !std::regex_match(cells[i], number))
+        throw std::runtime_error("Unsupported column \"" + names[i] + "\" in comparison file: " + path);
+      reference.push_back({ static_cast<uint16_t>(std::stoi(match[1])), static_cast<int16_t>(std::stoi(cells[i])) });
+    }
+    return reference;
+  }
+
+  bool checkComparison(const std::vector<std::pair<uint16_t, int16_t>>& cells, const char* side,
+                       auto ram, std::ostream& out)
+  {
+    bool same{ true };
+    for (const auto& [address, value] : cells)
+    {
+      if (ram(address) == value)
+        continue;
+      if (same)
+        out << "  " << side << " differs from the comparison file:\n";
+      out << "    RAM[" << address << "]: " << ram(address) << ", expected " << value << "\n";
+      same = false;
+    }
+    return same;
+  }
+
+  // Runs both in lockstep; true if no difference was found
+  bool runLevel(const VMBytecode& bytecode, const HackProgram& program, const std::vector<bool>& leaf,
+                OptimizationLevel level, const Limits& limits, const std::vector<std::pair<int, int>>& settings,
+                const std::vector<std::pair<uint16_t, int16_t>>& reference)
+  {
+    const auto& functions{ bytecode.functions() };
+    const bool optimized{ level == OptimizationLevel::O2 };
+    std::cout << levelName(level) << ": ";
+
+    VMEmulator vm(bytecode);
+    vm.setCallStop(true);
+    HackEmulator hack(program.rom);
+    for (const auto& [address, value] : settings)
+    {
+      vm.ram(static_cast<uint16_t>(address)) = static_cast<int16_t>(value);
+      hack.ram(static_cast<uint16_t>(address)) = static_cast<int16_t>(value);
+    }
+
+    // VM calls the Hack code need not arrive at: functions it does not stop
+    // in, and at -O2 leaf functions and Math.multiply
+    std::vector<bool> stops(functions.size(), false);
+    for (int function : program.functionAt)
+    {
+      if (function >= 0)
+        stops[static_cast<size_t>(function)] = true;
+    }
+    const int multiply{ bytecode.functionIndex("Math.multiply") };
+    auto removable = [&](int function)
+    {
+      return optimized && (leaf[static_cast<size_t>(function)] || function == multiply);
+    };
+    auto mayMiss = [&](int function)
+    {
+      return !stops[static_cast<size_t>(function)] || removable(function);
+    };
+    auto nameOf = [&](int function) -> const std::string& { return functions[static_cast<size_t>(function)].name; };
+
+    uint64_t matched{ 0 }, skipped{ 0 };
+
+    // The frame of the last call skipped as removed by -O2: the calls it
+    // makes are skipped too, as long as it is on the VM stack below the
+    // new frame
+    int skippedFrame{ -1 };
+    auto insideSkipped = [&]()
+    {
+      int frame{ vm.ram(static_cast<uint16_t>(vm.ram(LCL) - 4)) };
+      for (int depth = 0; frame > skippedFrame && frame < heapBase && depth < heapBase; depth++)
+        frame = vm.ram(static_cast<uint16_t>(frame - 4));
+      if (skippedFrame >= 0 && frame == skippedFrame)
+        return true;
+      skippedFrame = -1;
+      return false;
+    };
+    auto skip = [&](int function)
+    {
+      skippedFrame = removable(function) ? vm.ram(LCL) : -1;
+      skipped++;
+    };
+
+    int previous{ -1 };
+    auto diverged = [&](const std::string& report)
+    {
+      std::cout << "divergence " << report;
+      if (previous >= 0)
+        std::cout << "  last agreement: call " << matched << ", of " << nameOf(previous) << "\n";
+      return false;
+    };
+    auto limitReached = [&](const char* limit)
+    {
+      std::cout << limit << " limit after " << matched << " calls, no divergence so far\n";
+      return true;
+    };
+
+    HackEmulator::Stop hackStop{};
+    while (true)
+    {
+      // Off the entry it stopped at, then to the next one
+      if (program.entries[hack.pc()])
+        hack.run(hack.cycles() + 1);
+      hackStop = hack.run(limits.maxCycles, program.entries);
+      if (hackStop != HackEmulator::Stop::BREAKPOINT)
+        break;
+      const int function{ program.functionAt[hack.pc()] };
+
+      // Without a bootstrap the code may start with a function, not called
+      if (vm.steps() == 0 && functions[static_cast<size_t>(function)].entry == bytecode.start())
+        continue;
+
+      // The VM call this arrival stands for. At -O2 a call of a leaf
+      // function that does not match may have been inlined: the first such
+      // difference is reported only if no later call of it matches.
+      std::optional<std::string> firstDifference{};
+      while (true)
+      {
+        const VMEmulator::Stop vmStop{ vm.run(limits.maxSteps) };
+        if (vmStop == VMEmulator::Stop::STEPS)
+          return limitReached("step");
+        const std::string at{ "at call " + std::to_string(matched + 1) + ": " };
+        if (vmStop != VMEmulator::Stop::CALL)
+          return diverged(firstDifference.value_or(at + "the Hack code entered " + nameOf(function) +
+                                                   ", the VM ended without calling it\n"));
+
+        const int called{ bytecode.functionAt(vm.pc()) };
+        if (insideSkipped())
+        {
+          skipped++;
+          continue;
+        }
+        if (called != function)
+        {
+          if (mayMiss(called))
+          {
+            skip(called);
+            continue;
+          }
+          return diverged(firstDifference.value_or(at + "the Hack code entered " + nameOf(function) +
+                                                   ", the VM called " + nameOf(called) + "\n"));
+        }
+
+        std::optional<Difference> difference{ compareAtEntry(vm, hack, program, !optimized) };
+        if (!difference)
+          break;
+
+        const uint16_t returnAddress{ static_cast<uint16_t>(vm.ram(static_cast<uint16_t>(vm.ram(LCL) - 5))) };
+        std::string report{ at + nameOf(function) + " (VM step " + std::to_string(vm.steps()) + ", Hack cycle " +
+                            std::to_string(hack.cycles()) + "), called from " +
+                            bytecode.location(returnAddress - 1u) + "\n" + describe(*difference) };
+        if (!mayMiss(function))
+          return diverged(report);
+        if (!firstDifference)
+          firstDifference = report;
+        skip(function);
+      }
+
+      matched++;
+      previous = function;
+    }
+
+    if (hackStop == HackEmulator::Stop::CYCLES)
+      return limitReached("cycle");
+
+    // The Hack code is over: the VM must finish without further calls
+    // that the Hack code would have stopped at
+    VMEmulator::Stop vmStop{};
+    while ((vmStop = vm.run(limits.maxSteps)) == VMEmulator::Stop::CALL)
+    {
+      const int called{ bytecode.functionAt(vm.pc()) };
+      if (insideSkipped())
+        skipped++;
+      else if (mayMiss(called))
+        skip(called);
+      else
+        return diverged("after call " + std::to_string(matched) + ": the Hack code ended, the VM called " +
+                        nameOf(called) + "\n");
+    }
+    if (vmStop == VMEmulator::Stop::STEPS)
+      return limitReached("step");
+
+    // Both are over: what is left to compare, and the reference values
+    std::optional<Difference> difference{ compareAtEnd(vm, hack, program, !optimized) };
+    if (difference)
+    {
+      std::cout << "divergence at the end (VM step " << vm.steps() << ", Hack cycle " << hack.cycles() << ")\n"
+                << describe(*difference);
+    }
+    else
+    {
+      std::cout << matched << " calls matched";
+      if (skipped > 0)
+        std::cout << " (" << skipped << " more not stopped at)";
+      std::cout << ", " << vm.steps() << " VM steps, " << hack.cycles() << " Hack cycles: no divergence\n";
+    }
+
+    bool same{ !difference };
+    same &= checkComparison(reference, "VM", [&](uint16_t address) { return vm.ram(address); }, std::cout);
+    same &= checkComparison(reference, "Hack", [&](uint16_t address) { return hack.ram(address); }, std::cout);
+    return same;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  // -O0 / -O1 / -O2: levels to test, all of them if none is given
+  // --max-steps N, --max-cycles N: limits of the VM and the Hack runs
+  // --set addr=value: RAM contents before the runs
+  // --cmp file: reference values of the final RAM
+  std::vector<OptimizationLevel> levels{};
+  Limits limits{};
+  std::vector<std::pair<int, int>> settings{};
+  std::string comparisonPath{};
+  std::string inputPath{};
+  bool usage{ false };
+
+  for (int i = 1; i < argc && !usage; i++)
+  {
+    std::string arg{ argv[i] };
+    if ((arg == "--max-steps" || arg == "--max-cycles" || arg == "--set" || arg == "--cmp") && i + 1 == argc)
+    {
+      usage = true;
+    }
+    else if (arg == "-O0" || arg == "-O1" || arg == "-O2")
+    {
+      levels.push_back((arg == "-O0") ? OptimizationLevel::O0 :
+                       (arg == "-O1") ? OptimizationLevel::O1 : OptimizationLevel::O2);
+    }
+    else if (arg == "--max-steps")
+    {
+      usage = !parseCount(argv[++i], limits.maxSteps);
+    }
+    else if (arg == "--max-cycles")
+    {
+      usage = !parseCount(argv[++i], limits.maxCycles);
+    }
+    else if (arg == "--set")
+    {
+      std::string setting{ argv[++i] };
+      size_t position{ setting.find('=') };
+      try
+      {
+        int address{ std::stoi(setting.substr(0, position)) };
+        int value{ std::stoi(setting.substr(position + 1)) };
+        usage = position == std::string::npos || address < 0 || address >= static_cast<int>(VMEmulator::memorySize) ||
+                value < -32768 || value > 65535;
+        settings.push_back({ address, value });
+      }
+      catch (const std::exception&)
+      {
+        usage = true;
+      }
+    }
+    else if (arg == "--cmp")
+    {
+      comparisonPath = argv[++i];
+    }
+    else if (arg.starts_with("-"))
+    {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return 1;
+    }
+    else if (inputPath.empty())
+    {
+      inputPath = arg;
+    }
+    else
+    {
+      usage = true;
+    }
+  }
+
+  if (usage || inputPath.empty())
+  {
+    std::cerr << "Usage: VMDiff [-O0] [-O1] [-O2] [--max-steps N] [--max-cycles N]\n"
+              << "              [--set addr=value]... [--cmp file.cmp] <file.vm | directory>" << std::endl;
+    return 1;
+  }
+  if (levels.empty())
+    levels = { OptimizationLevel::O0, OptimizationLevel::O1, OptimizationLevel::O2 };
+
+  fs::path inPath(inputPath);
+  std::vector<fs::path> vmFiles;
+  if (fs::is_directory(inPath))
+  {
+    // stessi file, nello stesso ordine, del VMtranslator
+    for (const auto& entry :
+         fs::recursive_directory_iterator(inPath, fs::directory_options::skip_permission_denied))
+    {
+      if (entry.is_regular_file() && entry.path().extension() == ".vm")
+        vmFiles.push_back(entry.path());
+    }
+    std::sort(vmFiles.begin(), vmFiles.end(),
+              [](const fs::path& a, const fs::path& b){
+                return a.generic_string() < b.generic_string();
+              });
+  }
+  else if (fs::is_regular_file(inPath) && inPath.extension() == ".vm")
+  {
+    vmFiles.push_back(inPath);
+  }
+  else
+  {
+    std::cerr << "Unable to access " << inPath << " as a .vm file or directory" << std::endl;
+    return 1;
+  }
+
+  if (vmFiles.empty())
+  {
+    std::cerr << "No .vm files in directory (recursively): " << inPath << std::endl;
+    return 1;
+  }
+
+  try
+  {
+    VMProgram vmProgram{};
+    for (const auto& p : vmFiles)
+    {
+      InputFile inputFile{ p.stem().string(), std::ifstream(p) };
+      if (!inputFile.file)
+      {
+        std::cerr << "Unable to open file: " << p << std::endl;
+        return 1;
+      }
+      vmProgram.push_back(Translator::parseFile(inputFile));
+    }
+    const VMBytecode bytecode(vmProgram);
+
+    // The statics as the VM emulator lays them out
+    std::stringstream vmMap{};
+    StaticLayout(vmProgram).writeMap(vmMap);
+    const std::map<std::string, uint16_t> vmStatics{ readStaticMap(vmMap) };
+
+    std::vector<bool> leaf{}, loopAtEntry{};
+    analyze(bytecode, leaf, loopAtEntry);
+
+    std::vector<std::pair<uint16_t, int16_t>> reference{};
+    if (!comparisonPath.empty())
+      reference = readComparison(comparisonPath);
+
+    bool same{ true };
+    for (OptimizationLevel level : levels)
+    {
+      // A level whose code does not fit in the ROM has nothing to compare
+      std::optional<HackProgram> program{};
+      try
+      {
+        program = translate(vmFiles, bytecode, vmStatics, loopAtEntry, level);
+      }
+      catch (const std::exception& e)
+      {
+        std::cout << levelName(level) << ": not run: " << e.what() << "\n";
+        continue;
+      }
+      same &= runLevel(bytecode, *program, leaf, level, limits, settings, reference);
+    }
+    return same ? 0 : 1;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+}
\ No newline at end of file
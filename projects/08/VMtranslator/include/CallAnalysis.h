@@ -0,0 +1,36 @@
+#ifndef CALLANALYSIS_H
+#define CALLANALYSIS_H
+
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+#include "VMProgram.h"
+
+// Whole-program facts used to pick the call and return stubs: the argument
+// counts that appear in call commands, the functions that write the
+// pointer segment or are never called in the program and therefore need
+// THIS/THAT restored on return, and the `call f n / return` pairs that can
+// reuse the caller's frame. With optimizeCalls false (below -O2) every
+// return restores THIS/THAT and no call is a tail call.
+class CallAnalysis
+{
+private:
+  std::set<int> m_callArities{};
+  std::unordered_set<std::string> m_definedFunctions{};
+  std::unordered_set<std::string> m_pointerWriters{};
+  std::unordered_map<std::string, int> m_arities{};   // -1 if called with different counts
+  std::set<int> m_tailCallArities{};
+  bool m_optimizeCalls{ true };
+
+public:
+  CallAnalysis(const VMProgram& program, bool optimizeCalls=true);
+
+  const std::set<int>& callArities() const noexcept;
+  const std::set<int>& tailCallArities() const noexcept;
+  bool isDefined(const std::string& functionName) const;
+  bool restoresPointers(const std::string& functionName) const;
+  bool canTailCall(const std::string& caller, const std::string& callee, int nArgs) const;
+};
+
+#endif
\ No newline at end of file
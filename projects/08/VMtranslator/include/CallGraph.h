@@ -0,0 +1,34 @@
+#ifndef CALLGRAPH_H
+#define CALLGRAPH_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "VMProgram.h"
+
+// Which function calls which, over the whole program. Functions that sit
+// on a cycle (a strongly connected component with more than one member, or
+// a function that calls itself) are recursive: more than one activation of
+// them can be alive at the same time. Names defined more than once and
+// names that are called but never defined are kept out of the graph, and
+// every query about them gets the conservative answer.
+class CallGraph
+{
+private:
+  std::unordered_map<std::string, size_t> m_index{};
+  std::vector<std::string> m_names{};
+  std::vector<std::vector<size_t>> m_callees{};
+  std::vector<bool> m_hasCalls{};
+  std::vector<bool> m_isRecursive{};
+
+  void findRecursion();
+
+public:
+  CallGraph(const VMProgram& program);
+
+  bool isDefined(const std::string& functionName) const;
+  bool isLeaf(const std::string& functionName) const;
+  bool isRecursive(const std::string& functionName) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef CODEGENERATOR_H
+#define CODEGENERATOR_H
+
+#include <set>
+#include <string>
+#include "CommandType.h"
+
+// Code generation strategy of an optimization level: lowers VM commands
+// to Hack assembly in the OutputBuffer the generator was built with. The
+// Translator drives every level through this interface; the commands that
+// only the optimization passes produce (moves, shifts, tail calls) have a
+// plain equivalent in every generator.
+class CodeGenerator
+{
+public:
+  virtual ~CodeGenerator() = default;
+
+  // fileIndex, the position of the file in the input, scopes the labels
+  // the generator makes up, since two files in different directories may
+  // share a name; with a negative index they are scoped by the file name
+  // (separate translation, where names are unique as statics use them)
+  virtual void setFileName(const std::string& fileName, int fileIndex) = 0;
+
+  // Address of static 0 of the current file (StaticLayout); with a negative
+  // base statics are left to the assembler as File.i symbols
+  virtual void setStaticBase(int base) = 0;
+
+  // Bootstrap: SP = 256 and call Sys.init if callSysInit, then any shared
+  // code the generator relies on (call stubs for the given arities)
+  virtual void writeInit(const std::set<int>& callArities, const std::set<int>& tailCallArities,
+                         bool callSysInit) = 0;
+
+  virtual void writeArithmetic(const std::string& command) = 0;
+  virtual void writeShiftLeft(int bits) = 0;
+  virtual void writePushPop(CommandType command, const std::string& segment, int index) = 0;
+  virtual void writeMove(const std::string& fromSegment, int fromIndex, const std::string& toSegment, int toIndex) = 0;
+  virtual void writeLabel(const std::string& label) = 0;
+  virtual void writeGoto(const std::string& label) = 0;
+  virtual void writeIf(const std::string& label) = 0;
+  virtual void writeCall(const std::string& functionName, int numArgs) = 0;
+  virtual void writeTailCall(const std::string& functionName, int numArgs) = 0;
+  virtual void writeFunction(const std::string& functionName, int nLocals) = 0;
+  virtual void writeReturn(bool restoresPointers) = 0;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef CODEWRITER_H
+#define CODEWRITER_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <map>
+#include <set>
+#include <unordered_set>
+#include "CommandType.h"
+#include "CodeGenerator.h"
+#include "HackCode.h"
+
+// -O1 and -O2: calls, returns and comparisons jump to stubs shared by the
+// whole program, emitted once by writeInit
+class CodeWriter : public CodeGenerator
+{
+public:
+  // Ways to reach a segment cell in a push or pop
+  enum class Addressing
+  {
+    FIXED,              // temp, pointer, static: a single @address
+    OFFSET_CHAIN,       // @BASE / A=M or A=M+1, then A=A+1 per further index (push up to 3, pop up to 4)
+    INDEX_ADD,          // @index / D=A / @BASE / A=D+M
+    ADDRESS_IN_R13,     // pop: address parked in R13 while the value is popped
+    VALUE_ADDRESS_SUM   // pop: D = address + value, split again with A=D-M / M=D-A
+  };
+
+  struct AddressingChoice
+  {
+    Addressing mode;
+    int cost;           // instructions of the whole push/pop
+  };
+
+private:
+  HackCode& m_code;
+  std::string m_fileName{};
+  std::string m_labelScope{};
+  int m_staticBase{ -1 };
+
+  // Every generated label is prefixed with m_labelScope and numbered by the
+  // counters below, so files can be lowered independently and concatenated
+  // afterwards, or lowered one after the other by the same CodeWriter.
+  std::unordered_set<std::string> m_emittedCalls{};
+
+  int m_eqLabelId{ 0 };
+  int m_gtLabelId{ 0 };
+  int m_ltLabelId{ 0 };
+  int m_returnAddressId{ 0 };
+
+  int emitUniqueJmpLabel(const std::string& jmp);
+  int emitUniqueRetAddressLabel();
+  void emitBinary(char op);
+  void emitUnary(char op);
+  void emitCompare(const std::string& jmp);
+  void emitNegativeConstant(int value);
+  void emitStoreAluConstant(int value);
+  void emitMemorySegment(const std::string& segment, int index);
+  void emitOffsetChain(std::string_view base, int index);
+
+  static std::string_view segmentBase(const std::string& segment) noexcept;
+  
+public:
+  CodeWriter(HackCode& code);
+
+  // temp, pointer and static live at addresses known at translation time
+  static bool isFixedSegment(const std::string& segment) noexcept;
+
+  // Cost model of the addressing modes: the length of push/pop segment index
+  // with the given mode (-1 if it does not apply), and the cheapest mode
+  static int addressingCost(CommandType command, const std::string& segment, int index, Addressing mode);
+  static AddressingChoice selectAddressing(CommandType command, const std::string& segment, int index);
+
+  void setFileName(const std::string& fileName, int fileIndex) override;
+  void setStaticBase(int base) noexcept override;
+  void writeInit(const std::set<int>& callArities, const std::set<int>& tailCallArities,
+                 bool callSysInit=true) override;
+  void writeInitSubroutines(const std::set<int>& callArities, const std::set<int>& tailCallArities);
+  void writeArithmetic(const std::string& command) override;
+  void writeShiftLeft(int bits) override;
+  void writePushPop(CommandType command, const std::string& segment, int index) override;
+  void writeMove(const std::string& fromSegment, int fromIndex, const std::string& toSegment, int toIndex) override;
+  void writeLabel(const std::string& label) override;
+  void writeGoto(const std::string& label) override;
+  void writeIf(const std::string& label) override;
+  void writeCall(const std::string& functionName, int numArgs) override;
+  void writeTailCall(const std::string& functionName, int numArgs) override;
+  void writeFunction(const std::string& functionName, int nLocals) override;
+  void writeReturn(bool restoresPointers=true) override;
+};
+
+#endif
\ No newline at end of file
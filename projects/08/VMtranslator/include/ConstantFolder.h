@@ -0,0 +1,30 @@
+#ifndef CONSTANTFOLDER_H
+#define CONSTANTFOLDER_H
+
+#include <vector>
+#include "VMProgram.h"
+
+// Peephole pass over a single file:
+// - arithmetic on constant operands is evaluated at translation time, with
+//   the 16-bit wrap-around of the Hack ALU (comparisons, like the $GT$/$LT$
+//   routines, test the sign of x - y). Results may be negative constants.
+// - `call Math.multiply 2` by a constant power of two becomes a `shl`
+//   arithmetic command (arg2 = shift amount), lowered as repeated doublings.
+class ConstantFolder
+{
+private:
+  VMFile& m_file;
+
+  static bool isConstant(const std::vector<VMCommand>& output, size_t fromTop);
+  static int constantAt(const std::vector<VMCommand>& output, size_t fromTop);
+  static int powerOfTwo(int value);
+  static bool foldArithmetic(const VMCommand& command, std::vector<VMCommand>& output);
+  static bool foldMultiply(const VMCommand& command, std::vector<VMCommand>& output);
+
+public:
+  ConstantFolder(VMFile& file);
+
+  void run();
+};
+
+#endif
\ No newline at end of file
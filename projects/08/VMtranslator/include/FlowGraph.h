@@ -0,0 +1,89 @@
+#ifndef FLOWGRAPH_H
+#define FLOWGRAPH_H
+
+#include <bitset>
+#include <string>
+#include <vector>
+#include "VMProgram.h"
+
+// Position of a function inside VMFile::commands: commands[begin] is its
+// `function` command (unless the file has code before its first function,
+// which is reported as a range with an empty name) and `end` is one past
+// its last command.
+struct FunctionRange
+{
+  std::string name{};
+  int nLocals{ 0 };
+  size_t begin{ 0 };
+  size_t end{ 0 };
+};
+
+// Control-flow graph of one function, with the analyses the optimization
+// passes share:
+// - basic blocks, split at label/goto/if-goto/call/return;
+// - operand stack depth before every command, relative to the depth right
+//   after the locals have been pushed;
+// - liveness of the local and temp slots. Slot i < nLocals is `local i`,
+//   slot nLocals + t is `temp t`. Temps are global, so calls are assumed to
+//   read all of them and returns to leave all of them live.
+// Everything is computed once in the constructor, in time linear in the
+// size of the function for all the reducible graphs the Jack compiler emits.
+class FlowGraph
+{
+public:
+  static constexpr int tempSize{ 8 };
+
+  typedef std::vector<bool> SlotSet;
+
+  struct Block
+  {
+    size_t begin{ 0 };                    // index of the first command
+    size_t end{ 0 };                      // one past the last command
+    std::vector<size_t> successors{};
+    std::vector<size_t> predecessors{};
+    SlotSet liveIn{};
+    SlotSet liveOut{};
+  };
+
+private:
+  const std::vector<VMCommand>& m_commands;
+  FunctionRange m_range{};
+  size_t m_bodyBegin{ 0 };
+  std::vector<Block> m_blocks{};
+  std::vector<int> m_depth{};             // per command, -1 when unreachable
+  std::vector<size_t> m_returns{};
+  int m_maxDepth{ 0 };
+  bool m_isWellFormed{ true };
+
+  void buildBlocks();
+  void computeStackDepth();
+  void computeLiveness();
+  int stackEffect(const VMCommand& command, int depth) const;
+  int slotOf(const VMCommand& command) const;
+
+public:
+  FlowGraph(const std::vector<VMCommand>& commands, const FunctionRange& range);
+
+  static std::vector<FunctionRange> functions(const VMFile& file);
+
+  // Temps that some value crosses a call in, anywhere in the program, or
+  // that a function reads from its caller; code that runs between two uses
+  // of another function (a leaf, an inlined body) may overwrite the others
+  static std::bitset<tempSize> sharedTemps(const VMProgram& program);
+
+  const FunctionRange& range() const noexcept;
+  const std::vector<Block>& blocks() const noexcept;
+  size_t nSlots() const noexcept;
+
+  // Stack analysis
+  bool isWellFormed() const noexcept;
+  int maxStackDepth() const noexcept;
+  int depthBefore(size_t command) const;
+  const std::vector<size_t>& returns() const noexcept;
+
+  // Liveness
+  SlotSet liveBefore(size_t command) const;
+  bool isLocalLiveAtEntry(int index) const;
+};
+
+#endif
\ No newline at end of file
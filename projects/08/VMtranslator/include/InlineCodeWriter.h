@@ -0,0 +1,55 @@
+#ifndef INLINECODEWRITER_H
+#define INLINECODEWRITER_H
+
+#include <set>
+#include <string>
+#include <string_view>
+#include "CommandType.h"
+#include "CodeGenerator.h"
+#include "HackCode.h"
+
+// -O0: every command is expanded in place, calls and returns included, as
+// in the reference implementation of the course. Labels are prefixed with
+// the index of the file so files can be lowered independently.
+class InlineCodeWriter : public CodeGenerator
+{
+private:
+  HackCode& m_code;
+  std::string m_fileName{};
+  std::string m_labelScope{};
+  int m_staticBase{ -1 };
+
+  int m_eqLabelId{ 0 };
+  int m_gtLabelId{ 0 };
+  int m_ltLabelId{ 0 };
+  int m_returnAddressId{ 0 };
+
+  int uniqueLabelJmp(const std::string& jmp);
+  int uniqueLabelRetAddress();
+  void emitBinary(char op);
+  void emitUnary(char op);
+  void emitCompare(const std::string& jmp);
+  void emitPush(std::string_view value, bool pushAddress=false);
+  void emitMemorySegment(const std::string& segment, int index);
+  
+public:
+  InlineCodeWriter(HackCode& code);
+
+  void setFileName(const std::string& fileName, int fileIndex) override;
+  void setStaticBase(int base) noexcept override;
+  void writeInit(const std::set<int>& callArities, const std::set<int>& tailCallArities,
+                 bool callSysInit) override;
+  void writeArithmetic(const std::string& command) override;
+  void writeShiftLeft(int bits) override;
+  void writePushPop(CommandType command, const std::string& segment, int index) override;
+  void writeMove(const std::string& fromSegment, int fromIndex, const std::string& toSegment, int toIndex) override;
+  void writeLabel(const std::string& label) override;
+  void writeGoto(const std::string& label) override;
+  void writeIf(const std::string& label) override;
+  void writeCall(const std::string& functionName, int numArgs) override;
+  void writeTailCall(const std::string& functionName, int numArgs) override;
+  void writeFunction(const std::string& functionName, int nLocals) override;
+  void writeReturn(bool restoresPointers=true) override;
+};
+
+#endif
\ No newline at end of file
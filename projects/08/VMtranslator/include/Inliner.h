@@ -0,0 +1,53 @@
+#ifndef INLINER_H
+#define INLINER_H
+
+#include <string>
+#include <vector>
+#include <bitset>
+#include <unordered_map>
+#include "VMProgram.h"
+#include "FlowGraph.h"
+
+// Replaces calls to small leaf functions with a copy of their body.
+// The callee's arguments and locals are moved to temp slots that neither the
+// caller nor the callee use and that no function keeps a value in across a
+// call (FlowGraph::sharedTemps), its labels are renamed, and THIS/THAT are saved
+// and restored around the body when the callee writes the pointer segment, so
+// the caller observes the same state the $RETURN$ routine would leave.
+// Only functions without calls are inlined: they cannot be recursive and
+// cannot clobber the temp slots while the inlined body is running.
+class Inliner
+{
+private:
+  static constexpr size_t maxInlineSize{ 8 };  // commands, final return excluded
+  static constexpr int tempSize{ FlowGraph::tempSize };
+
+  struct Callee
+  {
+    size_t fileIndex{ 0 };
+    int nLocals{ 0 };
+    int nArguments{ 0 };                  // highest argument index used + 1
+    std::vector<VMCommand> body{};        // `function` excluded, `return`s included
+    std::bitset<tempSize> temps{};        // temp slots used by the body
+    bool writesPointer[2]{ false, false };
+    bool usesStatic{ false };
+  };
+
+  VMProgram& m_program;
+  std::unordered_map<std::string, Callee> m_callees{};
+  std::bitset<tempSize> m_sharedTemps{};
+  int m_inlineId{ 0 };
+
+  void collectCallees();
+  bool isInlinable(const std::vector<VMCommand>& commands, const FunctionRange& range, Callee& callee) const;
+  bool expandCall(const VMCommand& call, size_t fileIndex, std::bitset<tempSize> callerTemps,
+                  std::vector<VMCommand>& output);
+  void inlineFile(size_t fileIndex);
+
+public:
+  Inliner(VMProgram& program);
+
+  void run();
+};
+
+#endif
\ No newline at end of file
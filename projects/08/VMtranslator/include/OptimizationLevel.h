@@ -0,0 +1,12 @@
+#ifndef OPTIMIZATIONLEVEL_H
+#define OPTIMIZATIONLEVEL_H
+
+enum class OptimizationLevel
+{
+  O0,   // InlineCodeWriter: calls and returns expanded in place
+  O1,   // CodeWriter: shared call, return and comparison stubs
+  O2    // CodeWriter after folding, inlining and register allocation, with
+        // fused moves, tail calls and leaf returns
+};
+
+#endif
\ No newline at end of file
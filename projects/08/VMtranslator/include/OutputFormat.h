@@ -0,0 +1,11 @@
+#ifndef OUTPUTFORMAT_H
+#define OUTPUTFORMAT_H
+
+enum class OutputFormat
+{
+  ASM,          // Hack assembly text (.asm)
+  HACK,         // machine code, one 16-character binary string per line (.hack)
+  HACK_BINARY   // machine code, raw big-endian 16-bit words (.bin)
+};
+
+#endif
\ No newline at end of file
@@ -2,23 +2,25 @@
 #define PARSER_H
 
 #include <vector>
-#include <fstream>
+#include <istream>
 #include <string>
 #include "CommandType.h"
 
+// Reads one command at a time: only the current and the next command are
+// held in memory, so the input can be a pipe as well as a file.
 class Parser
 {
 private:
-  std::vector<std::string> m_cleanedFile{};
+  std::istream& m_input;
   bool m_hasMoreCommands{ false };
-  int m_currentCommandIndex{ -1 };
   std::string m_currentCommand{};
+  std::string m_nextCommand{};
 
-  std::vector<std::string> cleanFile(std::ifstream& file) const;
+  bool readCommand(std::string& command);
   std::vector<std::string> getCurrentCommandTokens() const;
   
 public:
-  Parser(std::ifstream& inputFile);
+  Parser(std::istream& input);
 
   bool hasMoreCommands() const noexcept;
   void advance();
@@ -0,0 +1,57 @@
+#ifndef REGISTERALLOCATOR_H
+#define REGISTERALLOCATOR_H
+
+#include <string>
+#include <vector>
+#include <bitset>
+#include <unordered_map>
+#include "VMProgram.h"
+#include "FlowGraph.h"
+#include "CallGraph.h"
+#include "StaticLayout.h"
+
+// Moves the hottest `local` and `argument` slots of a function to fixed
+// RAM cells, so that every access is a single @address instead of the
+// @i / D=A / @LCL / A=D+M walk through the frame:
+// - leaf functions get temp cells that no value ever crosses a call in;
+// - other non-recursive functions get static cells of their own file,
+//   past the indexes the file already uses and within the 16..255 range.
+// Recursive functions keep their frame, since two of their activations may
+// be alive at once. Promoted arguments are copied from the frame on entry,
+// promoted locals are zeroed on entry only when liveness says they may be
+// read before being written, and the remaining locals are renumbered so
+// that the frame only holds what is left in it.
+class RegisterAllocator
+{
+private:
+  static constexpr int tempSize{ FlowGraph::tempSize };
+  static constexpr int staticCells{ StaticLayout::lastAddress - StaticLayout::firstAddress + 1 };
+  static constexpr int loopWeight{ 8 };
+
+  struct Candidate
+  {
+    size_t fileIndex{ 0 };
+    size_t functionBegin{ 0 };
+    bool isArgument{ false };
+    int index{ 0 };
+    bool needsInit{ false };
+    int benefit{ 0 };
+    std::string segment{};     // assigned cell: "temp" or "static"
+    int cell{ -1 };
+  };
+
+  VMProgram& m_program;
+  const CallGraph m_callGraph;
+  std::bitset<tempSize> m_sharedTemps{};   // temps some value crosses a call in
+
+  int countStatics(std::unordered_map<std::string, int>& nextStatic) const;
+  void collectCandidates(size_t fileIndex, const FunctionRange& range, std::vector<Candidate>& candidates) const;
+  void rewriteFile(size_t fileIndex, const std::vector<Candidate>& assigned);
+
+public:
+  RegisterAllocator(VMProgram& program);
+
+  void run();
+};
+
+#endif
\ No newline at end of file
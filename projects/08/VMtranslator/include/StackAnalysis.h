@@ -0,0 +1,70 @@
+#ifndef STACKANALYSIS_H
+#define STACKANALYSIS_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "VMProgram.h"
+#include "CallAnalysis.h"
+#include "CallGraph.h"
+
+// Worst-case stack usage of the translated program, in words above the
+// SP a function is entered with. For every function:
+// - frame:     the locals pushed on entry;
+// - operand:   the highest operand stack depth of its body (FlowGraph);
+// - worst:     the most the stack grows while it runs, its callees included.
+//              A call adds the 5 saved words plus the callee's worst case on
+//              top of the depth at the call site, a tail call reuses the frame.
+// The worst cases are propagated over the call graph until they stop
+// growing: a function that keeps growing sits on (or reaches) a recursive
+// cycle with at least one regular call in it, and is reported as unbounded.
+// Cycles made only of tail calls stay bounded. Functions that only reach a
+// recursive one are unbounded too, but only those on the cycle are marked
+// as recursive in the report.
+class StackAnalysis
+{
+public:
+  static constexpr int stackBase{ 256 };
+  static constexpr int heapBase{ 2048 };
+  static constexpr int savedFrame{ 5 };
+
+  struct CallSite
+  {
+    std::string callee{};
+    int base{ 0 };          // words in use when the callee is entered
+    bool isTail{ false };
+  };
+
+  struct Function
+  {
+    std::string name{};
+    int frame{ 0 };
+    int operand{ 0 };
+    bool isWellFormed{ true };
+    bool callsUndefined{ false };
+    bool isRecursive{ false };        // on a call cycle itself
+    std::vector<CallSite> calls{};
+    int worst{ 0 };
+    bool isUnbounded{ false };
+  };
+
+private:
+  std::vector<Function> m_functions{};
+  std::unordered_map<std::string, size_t> m_index{};
+
+  void collect(const VMProgram& program, const CallAnalysis& callAnalysis, const CallGraph& callGraph);
+  void propagate();
+
+public:
+  StackAnalysis(const VMProgram& program, const CallAnalysis& callAnalysis);
+
+  const std::vector<Function>& functions() const noexcept;
+
+  // Highest address the stack can reach from the bootstrap, -1 if unbounded
+  int programPeak() const;
+
+  void writeReport(std::ostream& out) const;
+};
+
+#endif
\ No newline at end of file
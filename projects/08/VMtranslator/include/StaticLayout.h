@@ -0,0 +1,44 @@
+#ifndef STATICLAYOUT_H
+#define STATICLAYOUT_H
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "VMProgram.h"
+
+// Addresses of the static segment, chosen by the translator instead of the
+// assembler: every file (class) gets a contiguous block from RAM[16] on, in
+// program order, as long as its highest static index + 1. Files with the
+// same name share one block, as they shared the File.i symbols.
+class StaticLayout
+{
+public:
+  static constexpr int firstAddress{ 16 };
+  static constexpr int lastAddress{ 255 };
+
+private:
+  struct Block
+  {
+    std::string fileName{};
+    int base{ 0 };
+    int size{ 0 };
+  };
+
+  std::vector<Block> m_blocks{};
+  std::map<std::string, size_t> m_index{};
+
+public:
+  StaticLayout(const VMProgram& program);
+
+  // First address of the file's block
+  int base(const std::string& fileName) const;
+
+  // Cells in use, from firstAddress
+  int size() const noexcept;
+
+  // One "File.i address" line per static variable
+  void writeMap(std::ostream& out) const;
+};
+
+#endif
\ No newline at end of file
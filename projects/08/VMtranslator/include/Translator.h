@@ -0,0 +1,84 @@
+#ifndef TRANSLATOR_H
+#define TRANSLATOR_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <functional>
+#include <memory>
+#include <set>
+#include <vector>
+#include "InputFiles.h"
+#include "VMProgram.h"
+#include "CallAnalysis.h"
+#include "CodeGenerator.h"
+#include "HackAssembler.h"
+#include "HackCode.h"
+#include "OutputBuffer.h"
+#include "Parser.h"
+#include "TranslatorOptions.h"
+
+class Translator
+{
+private:
+  InputFiles& m_inputFiles;
+  std::ostream& m_outputFile;
+  TranslatorOptions m_options;
+
+  static bool isValidName(const std::string& name)
+  {
+    bool isValid{ 
+      name.size() > 0 &&
+      !std::isdigit(name[0]) && 
+      std::all_of(name.begin(), name.end(), [](char c) {
+        return std::isdigit(c) || std::isalpha(c) || c == '.' || c == ':' || c == '_';
+      })
+    };
+
+    return isValid;
+  }
+
+  static void forEachFile(size_t nFiles, const std::function<void(size_t)>& task);
+  static VMCommand parseCommand(const Parser& parser);
+  std::unique_ptr<CodeGenerator> makeCodeGenerator(HackCode& code) const;
+  void writeBootstrap(const CallAnalysis& callAnalysis, HackCode& code) const;
+  void lowerFile(const VMFile& vmFile, int fileIndex, const CallAnalysis& callAnalysis, int staticBase,
+                 CodeGenerator& codeWriter) const;
+  void generate(VMProgram& program, std::vector<uint16_t>* words=nullptr);
+  void streamFunctions(std::istream& input);
+
+public:
+  // Version of the code the translator emits: build tools keep translated
+  // classes by it, and a class must be linked with the bootstrap and stubs
+  // it was made for. Bump it whenever the generated code changes.
+  static constexpr int codeVersion{ 1 };
+
+  Translator(InputFiles& inputFiles, std::ostream& outputFile, const TranslatorOptions& options={});
+
+  void translate();
+
+  // VM code of any number of classes read from a stream such as stdin.
+  // Statics and labels are scoped by the class of the current function.
+  // Below -O2 with assembly output each function is written as soon as it
+  // has been read; otherwise the whole program is read first.
+  void translate(std::istream& input);
+
+  // The same, linked into machine words in memory instead of written out,
+  // for build tools that translate the whole program at any level
+  std::vector<uint16_t> translateToWords(std::istream& input);
+
+  // Separate translation below -O2, for build tools that keep the code of
+  // each class: the file on its own, encoded into an object with its
+  // statics left to the linker as File.i symbols, and the argument counts
+  // of its calls added to callArities. The bootstrap, linked first, needs
+  // those of every file.
+  void translateFile(const VMFile& vmFile, HackAssembler::Object& object, std::set<int>& callArities) const;
+  void writeSeparateBootstrap(const std::set<int>& callArities, bool callSysInit, HackAssembler::Object& object) const;
+
+  // Parsing and validation only, shared with the other VM tools
+  static VMFile parseFile(InputFile& inputFile);
+  static VMProgram parseStream(std::istream& input);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef TRANSLATOROPTIONS_H
+#define TRANSLATOROPTIONS_H
+
+#include <string>
+#include "OutputFormat.h"
+#include "OptimizationLevel.h"
+
+struct TranslatorOptions
+{
+  OutputFormat outputFormat{ OutputFormat::ASM };
+  OptimizationLevel level{ OptimizationLevel::O2 };
+  bool stackReport{ false };    // print the StackAnalysis report on stdout
+  std::string staticMap{};      // file for the StaticLayout map, none if empty
+};
+
+#endif
\ No newline at end of file
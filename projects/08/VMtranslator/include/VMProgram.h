@@ -0,0 +1,27 @@
+#ifndef VMPROGRAM_H
+#define VMPROGRAM_H
+
+#include <string>
+#include <vector>
+#include "CommandType.h"
+
+// In-memory form of a parsed VM command. Labels are kept as written in the
+// source file: they are made unique per function only when lowered.
+// Optimization passes may also produce negative `push constant` values and
+// the `shl` arithmetic command (shift left by arg2 bits).
+struct VMCommand
+{
+  CommandType type{ CommandType::C_ARITHMETIC };
+  std::string arg1{};
+  int arg2{ 0 };
+};
+
+struct VMFile
+{
+  std::string fileName{};
+  std::vector<VMCommand> commands{};
+};
+
+typedef std::vector<VMFile> VMProgram;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+#include "CallAnalysis.h"
+#include "VMProgram.h"
+#include "CommandType.h"
+
+CallAnalysis::CallAnalysis(const VMProgram& program, bool optimizeCalls)
+  : m_optimizeCalls(optimizeCalls)
+{
+  // The bootstrap calls Sys.init with no arguments
+  m_arities["Sys.init"] = 0;
+
+  for (const auto& vmFile : program)
+  {
+    std::string currentFunctionName{};
+
+    for (const auto& [type, arg1, arg2] : vmFile.commands)
+    {
+      if (type == CommandType::C_FUNCTION)
+      {
+        currentFunctionName = arg1;
+        m_definedFunctions.insert(arg1);
+      }
+      else if (type == CommandType::C_CALL)
+      {
+        m_callArities.insert(arg2);
+
+        auto [it, isNew]{ m_arities.emplace(arg1, arg2) };
+        if (!isNew && it->second != arg2)
+          it->second = -1;
+      }
+      else if (type == CommandType::C_POP && arg1 == "pointer")
+      {
+        m_pointerWriters.insert(currentFunctionName);
+      }
+    }
+  }
+
+  // Tail calls can be decided only once every arity and pointer writer is known
+  for (const auto& vmFile : program)
+  {
+    std::string currentFunctionName{};
+    const auto& commands{ vmFile.commands };
+
+    for (size_t i = 0; i + 1 < commands.size(); i++)
+    {
+      if (commands[i].type == CommandType::C_FUNCTION)
+        currentFunctionName = commands[i].arg1;
+      else if (commands[i].type == CommandType::C_CALL && commands[i + 1].type == CommandType::C_RETURN &&
+               canTailCall(currentFunctionName, commands[i].arg1, commands[i].arg2))
+        m_tailCallArities.insert(commands[i].arg2);
+    }
+  }
+}
+
+const std::set<int>& CallAnalysis::callArities() const noexcept
+{
+  return m_callArities;
+}
+
+const std::set<int>& CallAnalysis::tailCallArities() const noexcept
+{
+  return m_tailCallArities;
+}
+
+bool CallAnalysis::isDefined(const std::string& functionName) const
+{
+  return m_definedFunctions.contains(functionName);
+}
+
+bool CallAnalysis::restoresPointers(const std::string& functionName) const
+{
+  // Code outside a known function gets the full return sequence, and so
+  // does a function no call in the program reaches: its frame was built by
+  // someone else (a test script), with THIS/THAT of their own
+  return !m_optimizeCalls || !m_definedFunctions.contains(functionName) || !m_arities.contains(functionName) ||
+         m_pointerWriters.contains(functionName);
+}
+
+bool CallAnalysis::canTailCall(const std::string& caller, const std::string& callee, int nArgs) const
+{
+  // The frame is reused as it is, so the caller must have been called with
+  // the same number of arguments at every call site. If the callee returns
+  // through $RETURN$LEAF$ the caller's own THIS/THAT must still be in place.
+  if (!m_optimizeCalls || !m_definedFunctions.contains(caller))
+    return false;
+
+  auto it{ m_arities.find(caller) };
+  if (it == m_arities.end() || it->second != nArgs)
+    return false;
+
+  return !m_pointerWriters.contains(caller) || restoresPointers(callee);
+}
\ No newline at end of file
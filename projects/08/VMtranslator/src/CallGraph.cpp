@@ -0,0 +1,145 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include "CallGraph.h"
+#include "VMProgram.h"
+#include "CommandType.h"
+
+CallGraph::CallGraph(const VMProgram& program)
+{
+  // 1. Nodes: every function defined exactly once
+  std::unordered_set<std::string> ambiguous{};
+  for (const auto& vmFile : program)
+  {
+    for (const auto& [type, arg1, arg2] : vmFile.commands)
+    {
+      if (type != CommandType::C_FUNCTION)
+        continue;
+
+      if (!m_index.emplace(arg1, m_names.size()).second)
+        ambiguous.insert(arg1);
+      else
+        m_names.push_back(arg1);
+    }
+  }
+  for (const auto& name : ambiguous)
+    m_index.erase(name);
+
+  // 2. Edges, one per distinct callee
+  m_callees.resize(m_names.size());
+  m_hasCalls.assign(m_names.size(), false);
+  for (const auto& vmFile : program)
+  {
+    auto caller{ m_index.end() };
+    for (const auto& [type, arg1, arg2] : vmFile.commands)
+    {
+      if (type == CommandType::C_FUNCTION)
+        caller = m_index.find(arg1);
+      if (type != CommandType::C_CALL || caller == m_index.end())
+        continue;
+
+      m_hasCalls[caller->second] = true;
+      auto callee{ m_index.find(arg1) };
+      if (callee != m_index.end())
+        m_callees[caller->second].push_back(callee->second);
+    }
+  }
+  for (auto& callees : m_callees)
+  {
+    std::sort(callees.begin(), callees.end());
+    callees.erase(std::unique(callees.begin(), callees.end()), callees.end());
+  }
+
+  findRecursion();
+}
+
+void CallGraph::findRecursion()
+{
+  // Tarjan's strongly connected components, with an explicit stack so that
+  // long call chains do not exhaust the native one
+  const size_t n{ m_names.size() };
+  constexpr size_t unvisited{ static_cast<size_t>(-1) };
+
+  std::vector<size_t> order(n, unvisited);
+  std::vector<size_t> lowLink(n, 0);
+  std::vector<bool> onStack(n, false);
+  std::vector<size_t> stack{};
+  std::vector<std::pair<size_t, size_t>> work{};   // (node, next callee to visit)
+  size_t counter{ 0 };
+
+  m_isRecursive.assign(n, false);
+
+  for (size_t root = 0; root < n; root++)
+  {
+    if (order[root] != unvisited)
+      continue;
+
+    work.push_back({ root, 0 });
+    while (!work.empty())
+    {
+      auto& [node, next] = work.back();
+      if (next == 0 && order[node] == unvisited)
+      {
+        order[node] = lowLink[node] = counter++;
+        stack.push_back(node);
+        onStack[node] = true;
+      }
+
+      if (next < m_callees[node].size())
+      {
+        size_t callee{ m_callees[node][next++] };
+        if (callee == node)
+          m_isRecursive[node] = true;
+        if (order[callee] == unvisited)
+          work.push_back({ callee, 0 });
+        else if (onStack[callee])
+          lowLink[node] = std::min(lowLink[node], order[callee]);
+        continue;
+      }
+
+      // All callees visited: close the component rooted here, if any
+      size_t done{ node };
+      work.pop_back();
+      if (!work.empty())
+        lowLink[work.back().first] = std::min(lowLink[work.back().first], lowLink[done]);
+
+      if (lowLink[done] == order[done])
+      {
+        std::vector<size_t> component{};
+        size_t member{};
+        do
+        {
+          member = stack.back();
+          stack.pop_back();
+          onStack[member] = false;
+          component.push_back(member);
+        } while (member != done);
+
+        if (component.size() > 1)
+        {
+          for (size_t m : component)
+            m_isRecursive[m] = true;
+        }
+      }
+    }
+  }
+}
+
+bool CallGraph::isDefined(const std::string& functionName) const
+{
+  return m_index.contains(functionName);
+}
+
+bool CallGraph::isLeaf(const std::string& functionName) const
+{
+  auto it{ m_index.find(functionName) };
+  return it != m_index.end() && !m_hasCalls[it->second];
+}
+
+bool CallGraph::isRecursive(const std::string& functionName) const
+{
+  auto it{ m_index.find(functionName) };
+  return it == m_index.end() || m_isRecursive[it->second];
+}
\ No newline at end of file
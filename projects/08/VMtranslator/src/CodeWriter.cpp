@@ -0,0 +1,851 @@
+#include <vector>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <algorithm>
+#include "CommandType.h"
+#include "CodeWriter.h"
+#include "HackCode.h"
+
+CodeWriter::CodeWriter(HackCode& code)
+  : m_code(code)
+{
+}
+
+int CodeWriter::emitUniqueJmpLabel(const std::string& jmp) 
+{
+  int* ctr =
+    (jmp == "EQ") ? &m_eqLabelId :
+    (jmp == "GT") ? &m_gtLabelId :
+    (jmp == "LT") ? &m_ltLabelId : nullptr;
+
+  if (!ctr)
+    throw std::invalid_argument("Unknown jump type: " + jmp);
+
+  return (*ctr)++;
+}
+
+int CodeWriter::emitUniqueRetAddressLabel() 
+{
+  return m_returnAddressId++;
+}
+
+void CodeWriter::emitBinary(char op)
+{
+  // pop y in D, point to x and apply: x = x op y
+  m_code <<
+    "@SP\n"
+    "AM=M-1\n"
+    "D=M\n"
+    "A=A-1\n"_hack;
+
+  switch (op)
+  {
+  case '+': m_code << "M=D+M\n"_hack; break;
+  case '-': m_code << "M=M-D\n"_hack; break;
+  case '&': m_code << "M=D&M\n"_hack; break;
+  case '|': m_code << "M=D|M\n"_hack; break;
+  default: throw std::invalid_argument(std::string("Unknown binary operator: ") + op);
+  }
+}
+
+void CodeWriter::emitUnary(char op)
+{
+  // point to top end apply : x = op x
+  m_code <<
+    "@SP\n"
+    "A=M-1\n"_hack;
+
+  if (op == '-')
+    m_code << "M=-M\n"_hack;
+  else
+    m_code << "M=!M\n"_hack;
+}
+
+void CodeWriter::emitCompare(const std::string& which)
+{
+  // which ∈ {"GT","LT","EQ"}
+  const int id{ emitUniqueJmpLabel(which) };   // es: $GT_END_Main$42
+  m_code.at("$", which, "_END_", m_labelScope, "$", id);
+  m_code << "D=A\n"_hack;
+  m_code.at("$", which, "$");
+  m_code << "0;JMP\n"_hack;
+  m_code.label("$", which, "_END_", m_labelScope, "$", id);
+}
+
+void CodeWriter::emitNegativeConstant(int value)
+{
+  // Folded constants can be negative: @n only loads 0..32767, so D = -n
+  if (value == -32768)
+  {
+    m_code <<
+      "@32767\n"
+      "D=-A\n"
+      "D=D-1\n"_hack;
+    return;
+  }
+
+  m_code.at(-value);
+  m_code << "D=-A\n"_hack;
+}
+
+void CodeWriter::emitMemorySegment(const std::string& segment, int index)
+{
+  if (segment == "temp" && (index < 0 || index > 7))
+    throw std::invalid_argument("temp index out of range");
+  if (segment == "pointer" && (index < 0 || index > 1))
+    throw std::invalid_argument("pointer index out of range");
+  if (index < 0)
+    throw std::invalid_argument("negative index");
+
+  if (segment == "constant") 
+  {
+    m_code.at(index);
+    return;
+  } 
+  else if (segment == "temp" || segment == "pointer") 
+  {
+    int location{ (segment == "pointer") ? 3 + index : 5 + index };
+
+    m_code.at(location);
+    return;
+  } 
+  else if (segment == "static") 
+  {
+    if (m_staticBase >= 0)
+      m_code.at(m_staticBase + index);
+    else
+      m_code.at(m_fileName, ".", index);
+    return;
+  }
+
+  std::string_view base{ segmentBase(segment) };
+  if (base.empty()) 
+    throw std::invalid_argument("Unknown memory segment: " + segment);
+
+  if (selectAddressing(CommandType::C_PUSH, segment, index).mode == Addressing::OFFSET_CHAIN)
+  {
+    emitOffsetChain(base, index);
+    return;
+  }
+
+  m_code.at(index);
+  m_code << "D=A\n"_hack;
+  m_code.at(base);
+  m_code << "A=D+M\n"_hack;
+}
+
+void CodeWriter::emitOffsetChain(std::string_view base, int index)
+{
+  // A = base + index, one increment at a time
+  m_code.at(base);
+  if (index == 0)
+  {
+    m_code << "A=M\n"_hack;
+    return;
+  }
+
+  m_code << "A=M+1\n"_hack;
+  for (int i = 1; i < index; i++)
+  {
+    m_code << "A=A+1\n"_hack;
+  }
+}
+
+std::string_view CodeWriter::segmentBase(const std::string& segment) noexcept
+{
+  return
+    (segment == "local")    ? "LCL"  :
+    (segment == "argument") ? "ARG"  :
+    (segment == "this")     ? "THIS" :
+    (segment == "that")     ? "THAT" : "";
+}
+
+int CodeWriter::addressingCost(CommandType command, const std::string& segment, int index, Addressing mode)
+{
+  // Length of the whole push (address, load, 4 to push D) or pop (3 to pop
+  // in D, address, store) sequence, or -1 where the mode does not apply
+  constexpr int pushD{ 4 };
+  constexpr int popD{ 3 };
+  const bool isPush{ command == CommandType::C_PUSH };
+  const bool isFrame{ !segmentBase(segment).empty() };
+
+  switch (mode)
+  {
+  case Addressing::FIXED:
+    if (isFrame || segment == "constant")
+      return -1;
+    return isPush ? 1 + 1 + pushD : popD + 1 + 1;
+  case Addressing::OFFSET_CHAIN:
+    if (!isFrame)
+      return -1;
+    return isPush ? 1 + std::max(index, 1) + 1 + pushD : popD + 1 + std::max(index, 1) + 1;
+  case Addressing::INDEX_ADD:
+    if (!isFrame || !isPush)
+      return -1;
+    return 4 + 1 + pushD;
+  case Addressing::ADDRESS_IN_R13:
+    if (!isFrame || isPush)
+      return -1;
+    return 4 + 3 + popD + 3;
+  case Addressing::VALUE_ADDRESS_SUM:
+    if (!isFrame || isPush)
+      return -1;
+    return (index <= 1 ? 2 : 4) + popD + 2;
+  }
+
+  return -1;
+}
+
+CodeWriter::AddressingChoice CodeWriter::selectAddressing(CommandType command, const std::string& segment, int index)
+{
+  // Ties go to the mode listed first, so at equal length an offset chain
+  // wins over the index and sum forms, which are harder to follow in the
+  // output. Chains are therefore used up to index 3 for push (3 + 6 = 9,
+  // as INDEX_ADD) and up to index 4 for pop (4 + 5 = 9, as
+  // VALUE_ADDRESS_SUM).
+  AddressingChoice best{ Addressing::FIXED, -1 };
+  for (Addressing mode : { Addressing::FIXED, Addressing::OFFSET_CHAIN, Addressing::VALUE_ADDRESS_SUM,
+                           Addressing::INDEX_ADD, Addressing::ADDRESS_IN_R13 })
+  {
+    int cost{ addressingCost(command, segment, index, mode) };
+    if (cost != -1 && (best.cost == -1 || cost < best.cost))
+      best = { mode, cost };
+  }
+
+  return best;
+}
+
+bool CodeWriter::isFixedSegment(const std::string& segment) noexcept
+{
+  return segment == "temp" || segment == "pointer" || segment == "static";
+}
+
+void CodeWriter::setFileName(const std::string& fileName, int fileIndex)
+{
+  m_fileName = fileName;
+  m_labelScope = fileIndex >= 0 ? std::to_string(fileIndex) : fileName;
+}
+
+void CodeWriter::setStaticBase(int base) noexcept
+{
+  m_staticBase = base;
+}
+
+void CodeWriter::writeInit(const std::set<int>& callArities, const std::set<int>& tailCallArities, bool callSysInit)
+{
+  if (!callSysInit)
+  {
+    // Without Sys.init the program starts with the first file: skip the stubs
+    m_code <<
+      "@$START$\n"
+      "0;JMP\n"_hack;
+    writeInitSubroutines(callArities, tailCallArities);
+    m_code << "($START$)\n"_hack;
+    return;
+  }
+
+  m_code <<
+    // SP = 256
+    "@256\n"
+    "D=A\n"
+    "@SP\n"
+    "M=D\n"_hack;
+
+  // call Sys.init
+  writeCall("Sys.init", 0);
+
+  std::set<int> arities{ callArities };
+  arities.insert(0);
+  writeInitSubroutines(arities, tailCallArities);
+}
+
+void CodeWriter::writeInitSubroutines(const std::set<int>& callArities, const std::set<int>& tailCallArities) 
+{
+// ---------- GT ----------
+  // Known bug, as in the course's reference translator: GT and LT test
+  // the sign of x - y, which is wrong when the subtraction overflows
+  // (20000 > -20000 is false). The VM emulator compares the values.
+  m_code <<
+    "($GT$)\n"
+    "@R13\n"
+    "M=D\n"                // R13 = return address
+    "@SP\n"
+    "AM=M-1\n"             // SP-- ; A=SP ; M= y
+    "D=M\n"                // D = y
+    "A=A-1\n"              // A = SP-1 ; M = x
+    "D=M-D\n"              // D = x - y
+    "@SP\n"
+    "A=M-1\n"
+    "M=-1\n"               // preset true
+    "@R13\n"
+    "A=M\n"                // A = return address
+    "D;JGT\n"              // if x>y, jump (-1)
+    "@SP\n"
+    "A=M-1\n"
+    "M=0\n"                // else false (0)
+    "@R13\n"
+    "A=M\n"
+    "0;JMP\n"_hack;
+
+// ---------- LT ----------
+  m_code <<
+    "($LT$)\n"
+    "@R13\n"
+    "M=D\n"
+    "@SP\n"
+    "AM=M-1\n"
+    "D=M\n"
+    "A=A-1\n"
+    "D=M-D\n"              // D = x - y
+    "@SP\n"
+    "A=M-1\n"
+    "M=-1\n"               // preset true
+    "@R13\n"
+    "A=M\n"
+    "D;JLT\n"              // if x<y, jump
+    "@SP\n"
+    "A=M-1\n"
+    "M=0\n"
+    "@R13\n"
+    "A=M\n"
+    "0;JMP\n"_hack;
+
+// ---------- EQ ----------
+  m_code <<
+    "($EQ$)\n"
+    "@R13\n"
+    "M=D\n"
+    "@SP\n"
+    "AM=M-1\n"
+    "D=M\n"
+    "A=A-1\n"
+    "D=M-D\n"              // D = x - y
+    "@SP\n"
+    "A=M-1\n"
+    "M=-1\n"               // preset true
+    "@R13\n"
+    "A=M\n"
+    "D;JEQ\n"              // if x==y, jump
+    "@SP\n"
+    "A=M-1\n"
+    "M=0\n"
+    "@R13\n"
+    "A=M\n"
+    "0;JMP\n"_hack;
+
+// ---------- RETURN ----------
+  auto emitReturn = [this](std::string_view label, bool restoresPointers)
+  {
+    m_code.label(label);
+    m_code <<
+      // 1. Pop the return address 
+      "@LCL\n"
+      "D=M\n"
+      "@5\n"    // The return address is stored at LCL - 5
+      "A=D-A\n"
+      "D=M\n"   // D = return address (the value stored at LCL-5)
+      "@R14\n"  // RET
+      "M=D\n"
+
+      // 2. Pop the return value
+      "@SP\n"
+      "AM=M-1\n"
+      "D=M\n"
+      "@ARG\n"
+      "A=M\n"
+      "M=D\n"
+
+      // 3. Restore the stack pointer (SP = ARG + 1)
+      "@ARG\n"
+      "D=M+1\n"
+      "@SP\n"
+      "M=D\n"_hack;
+
+    // 4. Restore THAT, THIS, ARG walking LCL down the saved frame, then LCL
+    if (restoresPointers)
+    {
+      m_code <<
+        "@LCL\n"
+        "AM=M-1\n"
+        "D=M\n"
+        "@THAT\n" // THAT is stored at LCL - 1
+        "M=D\n"
+        "@LCL\n"
+        "AM=M-1\n"
+        "D=M\n"
+        "@THIS\n" // THIS is stored at LCL - 2
+        "M=D\n"
+        "@LCL\n"
+        "AM=M-1\n"_hack;
+    }
+    else
+    {
+      m_code <<
+        "@3\n"
+        "D=A\n"
+        "@LCL\n"
+        "AM=M-D\n"_hack;
+    }
+
+    m_code <<
+      "D=M\n"
+      "@ARG\n"    // ARG is stored at LCL - 3
+      "M=D\n"
+      "@LCL\n"
+      "A=M-1\n"
+      "D=M\n"
+      "@LCL\n"    // LCL is stored at LCL - 4
+      "M=D\n"
+
+      // 5. Return the saved return address
+      "@R14\n"
+      "A=M\n"
+      "0;JMP\n"_hack;
+  };
+
+  emitReturn("$RETURN$", true);
+
+  // For functions that never write the pointer segment THIS and THAT still
+  // hold the caller's values on return
+  emitReturn("$RETURN$LEAF$", false);
+
+// ---------- CALL ----------
+  // One stub per number of arguments. On entry the return address is
+  // already stored at *SP and D holds the address of the function.
+  for (int nArgs : callArities)
+  {
+    m_code.label("$CALL$", nArgs, "$");
+    m_code <<
+      "@R14\n"
+      "M=D\n"
+      // save LCL, ARG, THIS, THAT above the return address
+      "@LCL\n"
+      "D=M\n"
+      "@SP\n"
+      "AM=M+1\n"
+      "M=D\n"
+      "@ARG\n"
+      "D=M\n"
+      "@SP\n"
+      "AM=M+1\n"
+      "M=D\n"
+      "@THIS\n"
+      "D=M\n"
+      "@SP\n"
+      "AM=M+1\n"
+      "M=D\n"
+      "@THAT\n"
+      "D=M\n"
+      "@SP\n"
+      "AM=M+1\n"
+      "M=D\n"
+
+      // LCL = SP
+      "@SP\n"
+      "MD=M+1\n"
+      "@LCL\n"
+      "M=D\n"_hack;
+
+    // ARG = SP - 5 - nArgs
+    m_code.at(5 + nArgs);
+    m_code <<
+      "D=D-A\n"
+      "@ARG\n"
+      "M=D\n"
+
+      // goto function (address in R14)
+      "@R14\n"
+      "A=M\n"
+      "0;JMP\n"_hack;
+  }
+
+// ---------- TAIL CALL ----------
+  // One stub per number of arguments, for `call f n / return` in a function
+  // that was itself called with n arguments: the saved frame at LCL-5 and
+  // ARG stay as they are, the new arguments replace the current ones and the
+  // stack is cut back to LCL. On entry D holds the address of the function.
+  for (int nArgs : tailCallArities)
+  {
+    m_code.label("$TAIL$", nArgs, "$");
+    m_code <<
+      "@R14\n"
+      "M=D\n"_hack;
+
+    // argument i = *(SP - nArgs + i), in increasing order: the targets are
+    // all below LCL, the sources all above it
+    for (int i = 0; i < nArgs; i++)
+    {
+      if (i > 3)
+      {
+        m_code.at(i);
+        m_code <<
+          "D=A\n"
+          "@ARG\n"
+          "D=D+M\n"
+          "@R13\n"
+          "M=D\n"_hack;
+      }
+
+      if (nArgs - i == 1)
+        m_code <<
+          "@SP\n"
+          "A=M-1\n"
+          "D=M\n"_hack;
+      else
+      {
+        m_code <<
+          "@SP\n"
+          "D=M\n"_hack;
+        m_code.at(nArgs - i);
+        m_code <<
+          "A=D-A\n"
+          "D=M\n"_hack;
+      }
+
+      if (i > 3)
+        m_code <<
+          "@R13\n"
+          "A=M\n"_hack;
+      else
+        emitOffsetChain("ARG", i);
+      m_code << "M=D\n"_hack;
+    }
+
+    m_code <<
+      // SP = LCL
+      "@LCL\n"
+      "D=M\n"
+      "@SP\n"
+      "M=D\n"
+
+      // goto function (address in R14)
+      "@R14\n"
+      "A=M\n"
+      "0;JMP\n"_hack;
+  }
+}
+
+void CodeWriter::writeArithmetic(const std::string& command)
+{
+  if      (command == "add") emitBinary('+');
+  else if (command == "sub") emitBinary('-');
+  else if (command == "and") emitBinary('&');
+  else if (command == "or" ) emitBinary('|');
+
+  else if (command == "neg") emitUnary('-');  
+  else if (command == "not") emitUnary('!');
+
+  else if (command == "eq")  emitCompare("EQ");
+  else if (command == "gt")  emitCompare("GT");
+  else if (command == "lt")  emitCompare("LT");
+
+  else throw std::invalid_argument("Unknown arithmetic command: " + command);
+}
+
+void CodeWriter::writeShiftLeft(int bits)
+{
+  // x = x * 2^bits: the ALU has no D+D, so double the top of the stack in
+  // place with M=D+M after reloading it in D
+  m_code <<
+    "@SP\n"
+    "A=M-1\n"_hack;
+  for (int i = 0; i < bits; i++)
+  {
+    m_code <<
+      "D=M\n"
+      "M=D+M\n"_hack;
+  }
+}
+
+void CodeWriter::emitStoreAluConstant(int value)
+{
+  // M = -1, 0 or 1, the constants the ALU computes without D
+  if (value == -1)
+    m_code << "M=-1\n"_hack;
+  else if (value == 0)
+    m_code << "M=0\n"_hack;
+  else
+    m_code << "M=1\n"_hack;
+}
+
+void CodeWriter::writePushPop(CommandType command, const std::string& segment, int index) 
+{
+  if (command == CommandType::C_PUSH && segment == "constant" && index >= -1 && index <= 1)
+  {
+    // 0, 1 and -1 are ALU constants: store them without going through D
+    m_code <<
+      "@SP\n"
+      "AM=M+1\n"
+      "A=A-1\n"_hack;
+    emitStoreAluConstant(index);
+  }
+  else if (command == CommandType::C_PUSH)
+  {
+    if (segment == "constant" && index < 0)
+      emitNegativeConstant(index);
+    else if (segment == "constant") 
+    {
+      emitMemorySegment(segment, index);
+      m_code << "D=A\n"_hack;
+    }
+    else
+    {
+      emitMemorySegment(segment, index);
+      m_code << "D=M\n"_hack;
+    }
+
+    m_code <<
+      "@SP\n"
+      "AM=M+1\n"
+      "A=A-1\n"
+      "M=D\n"_hack;
+  }
+  else if (command == CommandType::C_POP )
+  {
+    if (segment == "constant")
+      throw std::invalid_argument("Cannot pop to constant");
+
+    if (isFixedSegment(segment))
+    {
+      // The address is a constant: no need to park it in R13
+      m_code <<
+        "@SP\n"
+        "AM=M-1\n"
+        "D=M\n"_hack;
+      emitMemorySegment(segment, index);
+      m_code << "M=D\n"_hack;
+      return;
+    }
+
+    std::string_view base{ segmentBase(segment) };
+    if (base.empty()) 
+      throw std::invalid_argument("Unknown memory segment: " + segment);
+    if (index < 0)
+      throw std::invalid_argument("negative index");
+
+    switch (selectAddressing(command, segment, index).mode)
+    {
+    case Addressing::OFFSET_CHAIN:
+      // Pop in D, then walk A up to the target: D is never needed for it
+      m_code <<
+        "@SP\n"
+        "AM=M-1\n"
+        "D=M\n"_hack;
+      emitOffsetChain(base, index);
+      m_code << "M=D\n"_hack;
+      break;
+
+    case Addressing::VALUE_ADDRESS_SUM:
+      // D = address, then D = address + value: with A on the popped cell
+      // A=D-M recovers the address and M=D-A the value (mod 2^16)
+      if (index == 0)
+      {
+        m_code.at(base);
+        m_code << "D=M\n"_hack;
+      }
+      else if (index == 1)
+      {
+        m_code.at(base);
+        m_code << "D=M+1\n"_hack;
+      }
+      else
+      {
+        m_code.at(index);
+        m_code << "D=A\n"_hack;
+        m_code.at(base);
+        m_code << "D=D+M\n"_hack;
+      }
+
+      m_code <<
+        "@SP\n"
+        "AM=M-1\n"
+        "D=D+M\n"
+        "A=D-M\n"
+        "M=D-A\n"_hack;
+      break;
+
+    default:
+      // Calculate the target address and save it to R13
+      emitMemorySegment(segment, index);
+      m_code <<
+        "D=A\n"
+        "@R13\n"
+        "M=D\n"
+
+        // Pop of the stack in D
+        "@SP\n"
+        "AM=M-1\n"
+        "D=M\n"
+
+        // Write the pop (D) in *R13 
+        "@R13\n"
+        "A=M\n"
+        "M=D\n"_hack;
+      break;
+    }
+  }
+
+  else throw std::invalid_argument("writePushPop called with a command that is not C_PUSH or C_POP");
+}
+
+void CodeWriter::writeMove(const std::string& fromSegment, int fromIndex, const std::string& toSegment, int toIndex)
+{
+  // push fromSegment fromIndex / pop toSegment toIndex, without touching the
+  // stack: only for fixed targets, whose address does not need D
+  if (!isFixedSegment(toSegment))
+    throw std::invalid_argument("writeMove target must be temp, pointer or static: " + toSegment);
+
+  if (fromSegment == "constant" && fromIndex >= -1 && fromIndex <= 1)
+  {
+    emitMemorySegment(toSegment, toIndex);
+    emitStoreAluConstant(fromIndex);
+    return;
+  }
+
+  if (fromSegment == "constant" && fromIndex < 0)
+    emitNegativeConstant(fromIndex);
+  else if (fromSegment == "constant")
+  {
+    emitMemorySegment(fromSegment, fromIndex);
+    m_code << "D=A\n"_hack;
+  }
+  else
+  {
+    emitMemorySegment(fromSegment, fromIndex);
+    m_code << "D=M\n"_hack;
+  }
+
+  emitMemorySegment(toSegment, toIndex);
+  m_code << "M=D\n"_hack;
+}
+
+void CodeWriter::writeLabel(const std::string& label)
+{
+  m_code.label(label);
+}
+
+void CodeWriter::writeGoto(const std::string& label)
+{
+  m_code.at(label);
+  m_code << "0;JMP\n"_hack;
+}
+
+void CodeWriter::writeIf(const std::string& label)
+{
+  m_code <<
+    // pop dello stack in D
+    "@SP\n"
+    "AM=M-1\n"
+    "D=M\n"_hack;
+
+  // jump se il valore != 0
+  m_code.at(label);
+  m_code << "D;JNE\n"_hack;
+}
+
+void CodeWriter::writeCall(const std::string& functionName, int numArgs)
+{
+  const int retId{ emitUniqueRetAddressLabel() };
+
+  // Always: set D = return address
+  m_code.at("RETURN_ADDRESS_", m_labelScope, "$", retId);
+  m_code << "D=A\n"_hack;
+
+  // If this is the FIRST time for (functionName, numArgs), emit the callLabel
+  if (m_emittedCalls.insert(m_labelScope + "$" + functionName + "$" + std::to_string(numArgs)).second) 
+  {
+    m_code.label("$CALL$", m_labelScope, "$", functionName, "$", numArgs, "$");
+    m_code <<
+      // Store the return address where the frame starts
+      "@SP\n"
+      "A=M\n"
+      "M=D\n"_hack;
+    // D = address(functionName)
+    m_code.at(functionName);
+    m_code << "D=A\n"_hack;
+    // Jump to the stub for numArgs arguments
+    m_code.at("$CALL$", numArgs, "$");
+    m_code << "0;JMP\n"_hack;
+  } 
+  // callLabel already defined: jump directly to it
+  else 
+  {
+    m_code.at("$CALL$", m_labelScope, "$", functionName, "$", numArgs, "$");
+    m_code << "0;JMP\n"_hack;
+  }
+
+  // Emit the return label
+  m_code.label("RETURN_ADDRESS_", m_labelScope, "$", retId);
+}
+
+void CodeWriter::writeTailCall(const std::string& functionName, int numArgs)
+{
+  // call + return in one jump: the frame of the current function is reused
+  m_code.at(functionName);
+  m_code << "D=A\n"_hack;
+  m_code.at("$TAIL$", numArgs, "$");
+  m_code << "0;JMP\n"_hack;
+}
+
+void CodeWriter::writeFunction(const std::string& functionName, int nLocals)
+{
+  // declare a label for the function entry
+  m_code.label(functionName);
+  
+  // initialize all local variables to 0
+
+  // if nLocals > 4 use an assembly loop
+  if (nLocals > 4) 
+  {
+    m_code.at(nLocals);  // counter = nLocals
+    m_code <<
+      "D=A\n"
+      "@R13\n"
+      "M=D\n"_hack;
+
+    m_code.label(functionName, "$initLocals");
+    m_code <<
+      "@R13\n"
+      "D=M\n"_hack;
+    m_code.at(functionName, "$endInit");
+    m_code <<
+      "D;JEQ\n"             // if counter == 0 -> end
+
+      // push 0
+      "@SP\n"
+      "A=M\n"
+      "M=0\n"
+      "@SP\n"
+      "M=M+1\n"
+
+      // counter--
+      "@R13\n"
+      "M=M-1\n"_hack;
+    m_code.at(functionName, "$initLocals");
+    m_code << "0;JMP\n"_hack;
+
+    m_code.label(functionName, "$endInit");
+  }
+  // else print the code n times
+  else 
+  {
+    for (int i = 0; i < nLocals; i++)
+    {
+      m_code <<
+        "@SP\n"
+        "A=M\n"
+        "M=0\n"
+        "@SP\n"
+        "M=M+1\n"_hack;
+    }
+  }
+}
+
+void CodeWriter::writeReturn(bool restoresPointers)
+{
+  if (restoresPointers)
+    m_code << "@$RETURN$\n0;JMP\n"_hack;
+  else
+    m_code << "@$RETURN$LEAF$\n0;JMP\n"_hack;
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include <vector>
+#include <cstdint>
+#include "ConstantFolder.h"
+#include "VMProgram.h"
+#include "CommandType.h"
+
+ConstantFolder::ConstantFolder(VMFile& file)
+  : m_file(file)
+{
+}
+
+bool ConstantFolder::isConstant(const std::vector<VMCommand>& output, size_t fromTop)
+{
+  if (output.size() <= fromTop)
+    return false;
+
+  const VMCommand& command{ output[output.size() - 1 - fromTop] };
+  return command.type == CommandType::C_PUSH && command.arg1 == "constant";
+}
+
+int ConstantFolder::constantAt(const std::vector<VMCommand>& output, size_t fromTop)
+{
+  return output[output.size() - 1 - fromTop].arg2;
+}
+
+int ConstantFolder::powerOfTwo(int value)
+{
+  // Returns k if value == 2^k (k < 15), -1 otherwise
+  for (int k = 0; k < 15; k++)
+  {
+    if (value == (1 << k))
+      return k;
+  }
+  return -1;
+}
+
+bool ConstantFolder::foldArithmetic(const VMCommand& command, std::vector<VMCommand>& output)
+{
+  const std::string& op{ command.arg1 };
+
+  if (op == "neg" || op == "not")
+  {
+    if (!isConstant(output, 0))
+      return false;
+
+    int16_t y{ static_cast<int16_t>(constantAt(output, 0)) };
+    output.back().arg2 = static_cast<int16_t>(op == "neg" ? -y : ~y);
+    return true;
+  }
+
+  if (!isConstant(output, 0) || !isConstant(output, 1))
+    return false;
+
+  int16_t y{ static_cast<int16_t>(constantAt(output, 0)) };
+  int16_t x{ static_cast<int16_t>(constantAt(output, 1)) };
+  int16_t diff{ static_cast<int16_t>(x - y) };
+  int16_t result{ 0 };
+
+  if      (op == "add") result = static_cast<int16_t>(x + y);
+  else if (op == "sub") result = diff;
+  else if (op == "and") result = static_cast<int16_t>(x & y);
+  else if (op == "or" ) result = static_cast<int16_t>(x | y);
+  else if (op == "eq" ) result = (diff == 0) ? -1 : 0;
+  else if (op == "gt" ) result = (diff >  0) ? -1 : 0;
+  else if (op == "lt" ) result = (diff <  0) ? -1 : 0;
+  else return false;
+
+  output.pop_back();
+  output.back().arg2 = result;
+  return true;
+}
+
+bool ConstantFolder::foldMultiply(const VMCommand& command, std::vector<VMCommand>& output)
+{
+  if (command.arg1 != "Math.multiply" || command.arg2 != 2)
+    return false;
+
+  if (isConstant(output, 0) && isConstant(output, 1))
+  {
+    int16_t y{ static_cast<int16_t>(constantAt(output, 0)) };
+    int16_t x{ static_cast<int16_t>(constantAt(output, 1)) };
+    output.pop_back();
+    output.back().arg2 = static_cast<int16_t>(x * y);
+    return true;
+  }
+
+  int shift{ -1 };
+  if (isConstant(output, 0))
+  {
+    shift = powerOfTwo(constantAt(output, 0));
+    if (shift == -1)
+      return false;
+    output.pop_back();
+  }
+  // constant * x, with x pushed by a single side-effect free command
+  else if (isConstant(output, 1) && output.back().type == CommandType::C_PUSH)
+  {
+    shift = powerOfTwo(constantAt(output, 1));
+    if (shift == -1)
+      return false;
+    output.erase(output.end() - 2);
+  }
+  else return false;
+
+  if (shift > 0)
+    output.push_back({ CommandType::C_ARITHMETIC, "shl", shift });
+  return true;
+}
+
+void ConstantFolder::run()
+{
+  std::vector<VMCommand> output{};
+  output.reserve(m_file.commands.size());
+
+  for (auto& command : m_file.commands)
+  {
+    bool folded{
+      (command.type == CommandType::C_ARITHMETIC && foldArithmetic(command, output)) ||
+      (command.type == CommandType::C_CALL && foldMultiply(command, output))
+    };
+
+    if (!folded)
+      output.push_back(std::move(command));
+  }
+
+  m_file.commands = std::move(output);
+}
\ No newline at end of file
@@ -0,0 +1,448 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <bitset>
+#include <unordered_map>
+#include "FlowGraph.h"
+#include "VMProgram.h"
+#include "CommandType.h"
+
+namespace
+{
+  bool isTemp(const VMCommand& command)
+  {
+    return (command.type == CommandType::C_PUSH || command.type == CommandType::C_POP) &&
+           command.arg1 == "temp" && command.arg2 >= 0 && command.arg2 < FlowGraph::tempSize;
+  }
+}
+
+FlowGraph::FlowGraph(const std::vector<VMCommand>& commands, const FunctionRange& range)
+  : m_commands(commands)
+  , m_range(range)
+  , m_bodyBegin(range.begin)
+{
+  if (m_range.begin < m_range.end && commands[m_range.begin].type == CommandType::C_FUNCTION)
+    m_bodyBegin++;
+
+  buildBlocks();
+  computeStackDepth();
+  computeLiveness();
+}
+
+std::vector<FunctionRange> FlowGraph::functions(const VMFile& file)
+{
+  const auto& commands{ file.commands };
+  std::vector<FunctionRange> ranges{};
+
+  size_t begin{ 0 };
+  while (begin < commands.size())
+  {
+    size_t end{ begin + 1 };
+    while (end < commands.size() && commands[end].type != CommandType::C_FUNCTION)
+      end++;
+
+    if (commands[begin].type == CommandType::C_FUNCTION)
+      ranges.push_back({ commands[begin].arg1, commands[begin].arg2, begin, end });
+    else
+      ranges.push_back({ "", 0, begin, end });
+
+    begin = end;
+  }
+
+  return ranges;
+}
+
+std::bitset<FlowGraph::tempSize> FlowGraph::sharedTemps(const VMProgram& program)
+{
+  // Temp liveness with calls treated as transparent: a temp is shared when
+  // a value written before a call is read after it, or when a function reads
+  // a value its caller left there. A leaf function may overwrite any other
+  // temp without anyone noticing.
+  std::bitset<tempSize> shared{};
+  for (const auto& vmFile : program)
+  {
+    for (const auto& range : functions(vmFile))
+    {
+      if (range.name.empty())
+      {
+        for (size_t i = range.begin; i < range.end; i++)
+        {
+          if (isTemp(vmFile.commands[i]))
+            shared.set(static_cast<size_t>(vmFile.commands[i].arg2));
+        }
+        continue;
+      }
+
+      const FlowGraph graph(vmFile.commands, range);
+      const auto& blocks{ graph.blocks() };
+
+      auto transfer = [&](size_t i, std::bitset<tempSize>& live)
+      {
+        const VMCommand& command{ vmFile.commands[i] };
+        if (!isTemp(command))
+          return;
+        if (command.type == CommandType::C_PUSH)
+          live.set(static_cast<size_t>(command.arg2));
+        else
+          live.reset(static_cast<size_t>(command.arg2));
+      };
+
+      std::vector<std::bitset<tempSize>> liveIn(blocks.size());
+      for (bool changed = true; changed; )
+      {
+        changed = false;
+        for (size_t b = blocks.size(); b-- > 0; )
+        {
+          std::bitset<tempSize> live{};
+          for (size_t s : blocks[b].successors)
+            live |= liveIn[s];
+          for (size_t i = blocks[b].end; i-- > blocks[b].begin; )
+            transfer(i, live);
+
+          if (live != liveIn[b])
+          {
+            liveIn[b] = live;
+            changed = true;
+          }
+        }
+      }
+
+      if (!blocks.empty())
+        shared |= liveIn.front();
+
+      for (const auto& block : blocks)
+      {
+        std::bitset<tempSize> live{};
+        for (size_t s : block.successors)
+          live |= liveIn[s];
+        for (size_t i = block.end; i-- > block.begin; )
+        {
+          if (vmFile.commands[i].type == CommandType::C_CALL)
+            shared |= live;
+          transfer(i, live);
+        }
+      }
+    }
+  }
+
+  return shared;
+}
+
+void FlowGraph::buildBlocks()
+{
+  const size_t size{ m_range.end - m_bodyBegin };
+  if (size == 0)
+    return;
+
+  // 1. Leaders: the entry, every label and every command after a jump,
+  //    a call or a return
+  std::vector<bool> isLeader(size, false);
+  isLeader[0] = true;
+  for (size_t i = 0; i < size; i++)
+  {
+    CommandType type{ m_commands[m_bodyBegin + i].type };
+    if (type == CommandType::C_LABEL)
+      isLeader[i] = true;
+    if ((type == CommandType::C_GOTO || type == CommandType::C_IF ||
+         type == CommandType::C_CALL || type == CommandType::C_RETURN) && i + 1 < size)
+      isLeader[i + 1] = true;
+  }
+
+  std::unordered_map<std::string, size_t> labelBlocks{};
+  for (size_t i = 0; i < size; i++)
+  {
+    if (isLeader[i])
+    {
+      if (!m_blocks.empty())
+        m_blocks.back().end = m_bodyBegin + i;
+      m_blocks.push_back({});
+      m_blocks.back().begin = m_bodyBegin + i;
+    }
+
+    const VMCommand& command{ m_commands[m_bodyBegin + i] };
+    if (command.type == CommandType::C_LABEL && !labelBlocks.emplace(command.arg1, m_blocks.size() - 1).second)
+      m_isWellFormed = false;   // duplicated label
+  }
+  m_blocks.back().end = m_range.end;
+
+  // 2. Edges
+  for (size_t b = 0; b < m_blocks.size(); b++)
+  {
+    const VMCommand& last{ m_commands[m_blocks[b].end - 1] };
+    bool fallsThrough{ last.type != CommandType::C_GOTO && last.type != CommandType::C_RETURN };
+
+    if (last.type == CommandType::C_GOTO || last.type == CommandType::C_IF)
+    {
+      auto target{ labelBlocks.find(last.arg1) };
+      if (target == labelBlocks.end())
+        m_isWellFormed = false;
+      else
+        m_blocks[b].successors.push_back(target->second);
+    }
+
+    if (fallsThrough)
+    {
+      // Running off the end of a function would execute the next one
+      if (b + 1 < m_blocks.size())
+        m_blocks[b].successors.push_back(b + 1);
+      else
+        m_isWellFormed = false;
+    }
+
+    for (size_t s : m_blocks[b].successors)
+    {
+      m_blocks[s].predecessors.push_back(b);
+    }
+  }
+}
+
+int FlowGraph::stackEffect(const VMCommand& command, int depth) const
+{
+  // Returns the depth after the command, or -1 on underflow
+  int needed{ 0 };
+  int pushed{ 0 };
+
+  switch (command.type)
+  {
+  case CommandType::C_PUSH:
+    pushed = 1;
+    break;
+  case CommandType::C_POP:
+  case CommandType::C_IF:
+  case CommandType::C_RETURN:
+    needed = 1;
+    break;
+  case CommandType::C_ARITHMETIC:
+    needed = (command.arg1 == "neg" || command.arg1 == "not" || command.arg1 == "shl") ? 1 : 2;
+    pushed = 1;
+    break;
+  case CommandType::C_CALL:
+    needed = command.arg2;
+    pushed = 1;
+    break;
+  default:
+    break;
+  }
+
+  return (depth < needed) ? -1 : depth - needed + pushed;
+}
+
+void FlowGraph::computeStackDepth()
+{
+  m_depth.assign(m_range.end - m_bodyBegin, -1);
+  if (m_blocks.empty())
+    return;
+
+  std::vector<size_t> worklist{ 0 };
+  m_depth[0] = 0;
+
+  while (!worklist.empty())
+  {
+    const Block& block{ m_blocks[worklist.back()] };
+    worklist.pop_back();
+
+    int depth{ m_depth[block.begin - m_bodyBegin] };
+    for (size_t i = block.begin; i < block.end; i++)
+    {
+      m_depth[i - m_bodyBegin] = depth;
+      m_maxDepth = std::max(m_maxDepth, depth);
+
+      const VMCommand& command{ m_commands[i] };
+      if (command.type == CommandType::C_RETURN)
+        m_returns.push_back(i);
+
+      depth = stackEffect(command, depth);
+      if (depth < 0)
+      {
+        m_isWellFormed = false;
+        return;
+      }
+      m_maxDepth = std::max(m_maxDepth, depth);
+    }
+
+    for (size_t s : block.successors)
+    {
+      int& entry{ m_depth[m_blocks[s].begin - m_bodyBegin] };
+      if (entry == -1)
+      {
+        entry = depth;
+        worklist.push_back(s);
+      }
+      else if (entry != depth)
+      {
+        m_isWellFormed = false;   // the same label reached with different depths
+      }
+    }
+  }
+
+  std::sort(m_returns.begin(), m_returns.end());
+}
+
+int FlowGraph::slotOf(const VMCommand& command) const
+{
+  if (command.type != CommandType::C_PUSH && command.type != CommandType::C_POP)
+    return -1;
+  if (command.arg1 == "local" && command.arg2 < m_range.nLocals)
+    return command.arg2;
+  if (command.arg1 == "temp" && command.arg2 < tempSize)
+    return m_range.nLocals + command.arg2;
+  return -1;
+}
+
+void FlowGraph::computeLiveness()
+{
+  const size_t slots{ nSlots() };
+  const size_t nBlocks{ m_blocks.size() };
+
+  // Upward-exposed uses and definitions of every block
+  std::vector<SlotSet> uses(nBlocks, SlotSet(slots, false));
+  std::vector<SlotSet> defs(nBlocks, SlotSet(slots, false));
+
+  for (size_t b = 0; b < nBlocks; b++)
+  {
+    for (size_t i = m_blocks[b].begin; i < m_blocks[b].end; i++)
+    {
+      const VMCommand& command{ m_commands[i] };
+      int slot{ slotOf(command) };
+
+      if (command.type == CommandType::C_CALL || command.type == CommandType::C_RETURN)
+      {
+        for (size_t t = static_cast<size_t>(m_range.nLocals); t < slots; t++)
+        {
+          if (!defs[b][t])
+            uses[b][t] = true;
+        }
+      }
+      else if (slot != -1 && command.type == CommandType::C_PUSH && !defs[b][static_cast<size_t>(slot)])
+      {
+        uses[b][static_cast<size_t>(slot)] = true;
+      }
+      else if (slot != -1 && command.type == CommandType::C_POP)
+      {
+        defs[b][static_cast<size_t>(slot)] = true;
+      }
+    }
+
+    m_blocks[b].liveIn = uses[b];
+    m_blocks[b].liveOut.assign(slots, false);
+  }
+
+  // Backward dataflow, visiting blocks in reverse order first
+  std::vector<size_t> worklist(nBlocks);
+  std::vector<bool> queued(nBlocks, true);
+  for (size_t b = 0; b < nBlocks; b++)
+    worklist[b] = b;
+
+  while (!worklist.empty())
+  {
+    size_t b{ worklist.back() };
+    worklist.pop_back();
+    queued[b] = false;
+
+    Block& block{ m_blocks[b] };
+    for (size_t s : block.successors)
+    {
+      for (size_t k = 0; k < slots; k++)
+      {
+        if (m_blocks[s].liveIn[k])
+          block.liveOut[k] = true;
+      }
+    }
+
+    bool changed{ false };
+    for (size_t k = 0; k < slots; k++)
+    {
+      bool live{ uses[b][k] || (block.liveOut[k] && !defs[b][k]) };
+      if (live && !block.liveIn[k])
+      {
+        block.liveIn[k] = true;
+        changed = true;
+      }
+    }
+
+    if (changed)
+    {
+      for (size_t p : block.predecessors)
+      {
+        if (!queued[p])
+        {
+          queued[p] = true;
+          worklist.push_back(p);
+        }
+      }
+    }
+  }
+}
+
+const FunctionRange& FlowGraph::range() const noexcept
+{
+  return m_range;
+}
+
+const std::vector<FlowGraph::Block>& FlowGraph::blocks() const noexcept
+{
+  return m_blocks;
+}
+
+size_t FlowGraph::nSlots() const noexcept
+{
+  return static_cast<size_t>(m_range.nLocals + tempSize);
+}
+
+bool FlowGraph::isWellFormed() const noexcept
+{
+  return m_isWellFormed;
+}
+
+int FlowGraph::maxStackDepth() const noexcept
+{
+  return m_maxDepth;
+}
+
+int FlowGraph::depthBefore(size_t command) const
+{
+  if (command < m_bodyBegin || command >= m_range.end)
+    return -1;
+  return m_depth[command - m_bodyBegin];
+}
+
+const std::vector<size_t>& FlowGraph::returns() const noexcept
+{
+  return m_returns;
+}
+
+FlowGraph::SlotSet FlowGraph::liveBefore(size_t command) const
+{
+  auto it{ std::upper_bound(m_blocks.begin(), m_blocks.end(), command,
+                            [](size_t c, const Block& block) { return c < block.begin; }) };
+  if (it == m_blocks.begin() || command >= m_range.end)
+    return SlotSet(nSlots(), false);
+
+  const Block& block{ *(it - 1) };
+  SlotSet live{ block.liveOut };
+
+  for (size_t i = block.end; i-- > command; )
+  {
+    const VMCommand& c{ m_commands[i] };
+    int slot{ slotOf(c) };
+
+    if (c.type == CommandType::C_CALL || c.type == CommandType::C_RETURN)
+    {
+      for (size_t t = static_cast<size_t>(m_range.nLocals); t < live.size(); t++)
+        live[t] = true;
+    }
+    else if (slot != -1)
+    {
+      live[static_cast<size_t>(slot)] = (c.type == CommandType::C_PUSH);
+    }
+  }
+
+  return live;
+}
+
+bool FlowGraph::isLocalLiveAtEntry(int index) const
+{
+  if (m_blocks.empty() || index < 0 || index >= m_range.nLocals)
+    return false;
+  return m_blocks.front().liveIn[static_cast<size_t>(index)];
+}
\ No newline at end of file
@@ -0,0 +1,399 @@
+#include <set>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <algorithm>
+#include "CommandType.h"
+#include "InlineCodeWriter.h"
+#include "HackCode.h"
+
+InlineCodeWriter::InlineCodeWriter(HackCode& code)
+  : m_code(code)
+{
+}
+
+int InlineCodeWriter::uniqueLabelJmp(const std::string& jmp) 
+{
+  int* ctr =
+    (jmp == "EQ") ? &m_eqLabelId :
+    (jmp == "GT") ? &m_gtLabelId :
+    (jmp == "LT") ? &m_ltLabelId : nullptr;
+
+  if (!ctr)
+    throw std::invalid_argument("Unknown jump type: " + jmp);
+
+  return (*ctr)++;
+}
+
+int InlineCodeWriter::uniqueLabelRetAddress() 
+{
+  return m_returnAddressId++;
+}
+
+void InlineCodeWriter::emitBinary(char op) 
+{
+  // pop y in D, punta a x e applica: x = x op y
+  m_code <<
+    "@SP\n"
+    "AM=M-1\n"
+    "D=M\n"
+    "A=A-1\n"_hack;
+
+  switch (op)
+  {
+  case '+': m_code << "M=D+M\n"_hack; break;
+  case '-': m_code << "M=M-D\n"_hack; break;
+  case '&': m_code << "M=D&M\n"_hack; break;
+  case '|': m_code << "M=D|M\n"_hack; break;
+  default: throw std::invalid_argument(std::string("Unknown binary operator: ") + op);
+  }
+}
+
+void InlineCodeWriter::emitUnary(char op) 
+{
+  // punta a top e applica: x = op x
+  m_code <<
+    "@SP\n"
+    "A=M-1\n"_hack;
+
+  if (op == '-')
+    m_code << "M=-M\n"_hack;
+  else
+    m_code << "M=!M\n"_hack;
+}
+
+void InlineCodeWriter::emitCompare(const std::string& jmp) 
+{
+  const int id{ uniqueLabelJmp(jmp) };
+  m_code <<
+    "@SP\n"
+    "AM=M-1\n"
+    "D=M\n"
+    "A=A-1\n"
+    "D=M-D\n"          // D = x - y, wrong sign on overflow (see CodeWriter)
+    "@SP\n"
+    "A=M-1\n"
+    "M=-1\n"_hack;     // preset true (-1)
+  m_code.at(jmp, "_END_", m_labelScope, "$", id);
+
+  // se condizione soddisfatta, salta: resta -1
+  if (jmp == "EQ")
+    m_code << "D;JEQ\n"_hack;
+  else if (jmp == "GT")
+    m_code << "D;JGT\n"_hack;
+  else
+    m_code << "D;JLT\n"_hack;
+
+  m_code <<
+    "@SP\n"
+    "A=M-1\n"
+    "M=0\n"_hack;      // altrimenti false (0)
+  m_code.label(jmp, "_END_", m_labelScope, "$", id);
+}
+
+void InlineCodeWriter::emitMemorySegment(const std::string& segment, int index)
+{
+  if (segment == "temp" && (index < 0 || index > 7))
+    throw std::invalid_argument("temp index out of range");
+  if (segment == "pointer" && (index < 0 || index > 1))
+    throw std::invalid_argument("pointer index out of range");
+  if (index < 0)
+    throw std::invalid_argument("negative index");
+
+  if (segment == "constant") 
+  {
+    m_code.at(index);
+    return;
+  } 
+  else if (segment == "temp" || segment == "pointer") 
+  {
+    int location = (segment == "pointer") ? 3 + index : 5 + index;
+
+    m_code.at(location);
+    return;
+  } 
+  else if (segment == "static") 
+  {
+    if (m_staticBase >= 0)
+      m_code.at(m_staticBase + index);
+    else
+      m_code.at(m_fileName, ".", index);
+    return;
+  }
+
+  std::string_view base =
+    (segment == "local")    ? "LCL" :
+    (segment == "argument") ? "ARG" :
+    (segment == "this")     ? "THIS" :
+    (segment == "that")     ? "THAT" :
+    "";
+  
+  if (base.empty()) 
+    throw std::invalid_argument("Unknown memory segment: " + segment);
+
+  m_code.at(index);
+  m_code << "D=A\n"_hack;
+  m_code.at(base);
+  m_code << "A=D+M\n"_hack;
+}
+
+void InlineCodeWriter::emitPush(std::string_view value, bool pushAddress)
+{
+  m_code.at(value);
+  if (pushAddress)
+    m_code << "D=A\n"_hack;
+  else
+    m_code << "D=M\n"_hack;
+  m_code <<
+    "@SP\n"
+    "AM=M+1\n"
+    "A=A-1\n"
+    "M=D\n"_hack;
+}
+
+void InlineCodeWriter::setFileName(const std::string& fileName, int fileIndex)
+{
+  m_fileName = fileName;
+  m_labelScope = fileIndex >= 0 ? std::to_string(fileIndex) : fileName;
+}
+
+void InlineCodeWriter::setStaticBase(int base) noexcept
+{
+  m_staticBase = base;
+}
+
+void InlineCodeWriter::writeInit(const std::set<int>&, const std::set<int>&, bool callSysInit)
+{
+  // No shared code: without Sys.init the first file starts at address 0
+  if (!callSysInit)
+    return;
+
+  m_code <<
+    // SP = 256
+    "@256\n"
+    "D=A\n"
+    "@SP\n"
+    "M=D\n"_hack;
+
+  // call Sys.init
+  writeCall("Sys.init", 0);
+}
+
+void InlineCodeWriter::writeArithmetic(const std::string& command)
+{
+  if      (command == "add") emitBinary('+');
+  else if (command == "sub") emitBinary('-');
+  else if (command == "and") emitBinary('&');
+  else if (command == "or" ) emitBinary('|');
+
+  else if (command == "neg") emitUnary('-');  
+  else if (command == "not") emitUnary('!');
+
+  else if (command == "eq")  emitCompare("EQ");
+  else if (command == "gt")  emitCompare("GT");
+  else if (command == "lt")  emitCompare("LT");
+
+  else throw std::invalid_argument("Unknown arithmetic command: " + command);
+}
+
+void InlineCodeWriter::writeShiftLeft(int bits)
+{
+  // x = x + x, bits times
+  m_code <<
+    "@SP\n"
+    "A=M-1\n"
+    "D=M\n"_hack;
+  for (int i = 0; i < bits; i++)
+    m_code << "MD=D+M\n"_hack;
+}
+
+void InlineCodeWriter::writePushPop(CommandType command, const std::string& segment, int index) 
+{
+  if (command == CommandType::C_PUSH)
+  {
+    emitMemorySegment(segment, index);
+    if (segment == "constant") 
+      m_code << "D=A\n"_hack;
+    else
+      m_code << "D=M\n"_hack;
+
+    m_code <<
+      "@SP\n"
+      "AM=M+1\n"
+      "A=A-1\n"
+      "M=D\n"_hack;
+  }
+  else if (command == CommandType::C_POP )
+  {
+    if (segment == "constant")
+      throw std::invalid_argument("Cannot pop to constant");
+
+    // Calcola l’indirizzo target e lo salva in R13
+    emitMemorySegment(segment, index);
+    m_code <<
+      "D=A\n"
+      "@R13\n"
+      "M=D\n"
+
+      // Pop dello stack in D
+      "@SP\n"
+      "AM=M-1\n"
+      "D=M\n"
+
+      // Scrive il pop (D) in *R13 
+      "@R13\n"
+      "A=M\n"
+      "M=D\n"_hack;
+  }
+
+  else throw std::invalid_argument("writePushPop called with a command that is not C_PUSH or C_POP");
+}
+
+void InlineCodeWriter::writeMove(const std::string& fromSegment, int fromIndex, const std::string& toSegment, int toIndex)
+{
+  writePushPop(CommandType::C_PUSH, fromSegment, fromIndex);
+  writePushPop(CommandType::C_POP, toSegment, toIndex);
+}
+
+void InlineCodeWriter::writeLabel(const std::string& label)
+{
+  m_code.label(label);
+}
+
+void InlineCodeWriter::writeGoto(const std::string& label)
+{
+  m_code.at(label);
+  m_code << "0;JMP\n"_hack;
+}
+
+void InlineCodeWriter::writeIf(const std::string& label)
+{
+  m_code <<
+    // pop dello stack in D
+    "@SP\n"
+    "AM=M-1\n"
+    "D=M\n"_hack;
+
+  // jump se il valore != 0
+  m_code.at(label);
+  m_code << "D;JNE\n"_hack;
+}
+
+void InlineCodeWriter::writeCall(const std::string& functionName, int numArgs)
+{
+  const int returnAddressId{ uniqueLabelRetAddress() };
+
+  m_code.at("RETURN_ADDRESS_", m_labelScope, "$", returnAddressId);
+  m_code <<
+    "D=A\n"
+    "@SP\n"
+    "AM=M+1\n"
+    "A=A-1\n"
+    "M=D\n"_hack;
+  emitPush("LCL");
+  emitPush("ARG");
+  emitPush("THIS");
+  emitPush("THAT");
+
+  m_code <<
+    // ARG = SP - numArgs - 5
+    "@SP\n"
+    "D=M\n"
+    "@5\n"
+    "D=D-A\n"_hack;
+  m_code.at(numArgs);
+  m_code <<
+    "D=D-A\n"
+    "@ARG\n"
+    "M=D\n"
+
+    // LCL = SP
+    "@SP\n"
+    "D=M\n"
+    "@LCL\n"
+    "M=D\n"_hack;
+
+  // goto functionName
+  m_code.at(functionName);
+  m_code << "0;JMP\n"_hack;
+
+  // return-address label
+  m_code.label("RETURN_ADDRESS_", m_labelScope, "$", returnAddressId);
+}
+
+void InlineCodeWriter::writeTailCall(const std::string& functionName, int numArgs)
+{
+  writeCall(functionName, numArgs);
+  writeReturn();
+}
+
+void InlineCodeWriter::writeFunction(const std::string& functionName, int nLocals)
+{
+  // declare a label for the function entry
+  m_code.label(functionName);
+  
+  // initialize all local variables to 0
+  for (int i = 0; i < nLocals; i++)
+  {
+    m_code <<
+      "@SP\n"
+      "A=M\n"
+      "M=0\n"
+      "@SP\n"
+      "M=M+1\n"_hack;
+  }
+}
+
+void InlineCodeWriter::writeReturn(bool)
+{
+  // THIS and THAT are always restored
+  auto emitRestore = [this](int n, std::string_view symbol)
+  {
+    m_code.at(n);
+    m_code <<
+      "D=A\n"
+      "@LCL\n"
+      "A=M-D\n"
+      "D=M\n"_hack;
+    m_code.at(symbol);
+    m_code << "M=D\n"_hack;
+  };
+
+  m_code <<
+    // 1. Pop the return address 
+    "@LCL\n"
+    "D=M\n"
+    "@5\n"    // The return address is stored at LCL - 5
+    "A=D-A\n"
+    "D=M\n"   // D = return address (the value stored at LCL-5)
+    "@R14\n"  // RET
+    "M=D\n"
+
+    // 2. Pop the return value
+    "@SP\n"
+    "AM=M-1\n"
+    "D=M\n"
+    "@ARG\n"
+    "A=M\n"
+    "M=D\n"
+
+    // 3. Restore the stack pointer (SP = ARG + 1)
+    "@ARG\n"
+    "D=M+1\n"
+    "@SP\n"
+    "M=D\n"_hack;
+
+  // 4. Restore THAT, THIS, ARG, LCL
+  emitRestore(1, "THAT"); // THAT is stored at LCL - 1
+  emitRestore(2, "THIS"); // THIS is stored at LCL - 2
+  emitRestore(3, "ARG");  // ARG is stored at LCL - 3
+  emitRestore(4, "LCL");  // LCL is stored at LCL - 4
+
+  m_code <<
+    // 5. Return the saved return address
+    "@R14\n"
+    "A=M\n"
+    "0;JMP\n"_hack;
+}
+
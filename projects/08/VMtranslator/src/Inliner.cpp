@@ -0,0 +1,239 @@
+#include <string>
+#include <vector>
+#include <bitset>
+#include <unordered_map>
+#include <unordered_set>
+#include "Inliner.h"
+#include "VMProgram.h"
+#include "CommandType.h"
+#include "FlowGraph.h"
+
+Inliner::Inliner(VMProgram& program)
+  : m_program(program)
+{
+}
+
+bool Inliner::isInlinable(const std::vector<VMCommand>& commands, const FunctionRange& range, Callee& callee) const
+{
+  if (range.end - range.begin - 2 > maxInlineSize || commands[range.end - 1].type != CommandType::C_RETURN)
+    return false;
+
+  for (size_t i = range.begin + 1; i < range.end; i++)
+  {
+    const auto& [type, arg1, arg2] = commands[i];
+
+    if (type == CommandType::C_CALL)
+      return false;
+
+    if (type == CommandType::C_PUSH || type == CommandType::C_POP)
+    {
+      if (arg1 == "argument")
+        callee.nArguments = std::max(callee.nArguments, arg2 + 1);
+      else if (arg1 == "local" && arg2 >= range.nLocals)
+        return false;
+      else if (arg1 == "temp" && arg2 < tempSize)
+        callee.temps.set(static_cast<size_t>(arg2));
+      else if (arg1 == "pointer" && type == CommandType::C_POP && arg2 < 2)
+        callee.writesPointer[arg2] = true;
+      else if (arg1 == "static")
+        callee.usesStatic = true;
+    }
+  }
+
+  // The operand stack must never go below the callee's base, and every
+  // return must leave exactly the return value on it
+  const FlowGraph graph(commands, range);
+  if (!graph.isWellFormed())
+    return false;
+  for (size_t r : graph.returns())
+  {
+    if (graph.depthBefore(r) != 1)
+      return false;
+  }
+
+  callee.nLocals = range.nLocals;
+  callee.body.assign(commands.begin() + static_cast<long>(range.begin) + 1,
+                     commands.begin() + static_cast<long>(range.end));
+  return true;
+}
+
+void Inliner::collectCallees()
+{
+  std::unordered_set<std::string> defined{};
+
+  for (size_t f = 0; f < m_program.size(); f++)
+  {
+    for (const auto& range : FlowGraph::functions(m_program[f]))
+    {
+      if (range.name.empty())
+        continue;
+
+      // A name defined twice is ambiguous: leave its calls alone
+      if (!defined.insert(range.name).second)
+      {
+        m_callees.erase(range.name);
+        continue;
+      }
+
+      Callee callee{};
+      callee.fileIndex = f;
+      if (isInlinable(m_program[f].commands, range, callee))
+        m_callees[range.name] = std::move(callee);
+    }
+  }
+}
+
+bool Inliner::expandCall(const VMCommand& call, size_t fileIndex, std::bitset<tempSize> callerTemps,
+                         std::vector<VMCommand>& output)
+{
+  auto it{ m_callees.find(call.arg1) };
+  if (it == m_callees.end())
+    return false;
+
+  const Callee& callee{ it->second };
+  const int nArgs{ call.arg2 };
+
+  if (callee.usesStatic && callee.fileIndex != fileIndex)
+    return false;
+  if (callee.nArguments > nArgs)
+    return false;
+
+  int nSaved{ callee.writesPointer[0] + callee.writesPointer[1] };
+  int nSlots{ nArgs + callee.nLocals + nSaved };
+  if (nSaved > 0 && nArgs + callee.nLocals == 0)
+    nSlots++;   // slot for the return value while THIS/THAT are restored
+
+  // Free temp slots, from the highest one down. Temps are global: a
+  // function further up the call chain may be keeping a value in one
+  std::vector<int> slots{};
+  std::bitset<tempSize> used{ callerTemps | callee.temps | m_sharedTemps };
+  for (int t = tempSize - 1; t >= 0 && static_cast<int>(slots.size()) < nSlots; t--)
+  {
+    if (!used.test(static_cast<size_t>(t)))
+      slots.push_back(t);
+  }
+  if (static_cast<int>(slots.size()) < nSlots)
+    return false;
+
+  auto argSlot   = [&](int i) { return slots[static_cast<size_t>(i)]; };
+  auto localSlot = [&](int i) { return slots[static_cast<size_t>(nArgs + i)]; };
+  int savedSlot[2]{ -1, -1 };
+  for (int p = 0, next = nArgs + callee.nLocals; p < 2; p++)
+  {
+    if (callee.writesPointer[p])
+      savedSlot[p] = slots[static_cast<size_t>(next++)];
+  }
+  int resultSlot{ slots.empty() ? -1 : slots.front() };
+
+  // Move the arguments off the stack and initialise the locals
+  for (int i = nArgs - 1; i >= 0; i--)
+    output.push_back({ CommandType::C_POP, "temp", argSlot(i) });
+  for (int i = 0; i < callee.nLocals; i++)
+  {
+    output.push_back({ CommandType::C_PUSH, "constant", 0 });
+    output.push_back({ CommandType::C_POP, "temp", localSlot(i) });
+  }
+  for (int p = 0; p < 2; p++)
+  {
+    if (savedSlot[p] != -1)
+    {
+      output.push_back({ CommandType::C_PUSH, "pointer", p });
+      output.push_back({ CommandType::C_POP, "temp", savedSlot[p] });
+    }
+  }
+
+  const std::string prefix{ "$" + call.arg1 + "$" + std::to_string(m_inlineId++) + "$" };
+  bool needsEnd{ false };
+
+  for (size_t i = 0; i < callee.body.size(); i++)
+  {
+    VMCommand command{ callee.body[i] };
+
+    switch (command.type)
+    {
+    case CommandType::C_PUSH:
+    case CommandType::C_POP:
+      if (command.arg1 == "argument")
+        command = { command.type, "temp", argSlot(command.arg2) };
+      else if (command.arg1 == "local")
+        command = { command.type, "temp", localSlot(command.arg2) };
+      break;
+    case CommandType::C_LABEL:
+    case CommandType::C_GOTO:
+    case CommandType::C_IF:
+      command.arg1 = prefix + command.arg1;
+      break;
+    case CommandType::C_RETURN:
+      if (i + 1 == callee.body.size())
+        continue;
+      command = { CommandType::C_GOTO, prefix + "END", 0 };
+      needsEnd = true;
+      break;
+    default:
+      break;
+    }
+
+    output.push_back(std::move(command));
+  }
+
+  if (needsEnd)
+    output.push_back({ CommandType::C_LABEL, prefix + "END", 0 });
+
+  // Restore THIS/THAT below the return value, as $RETURN$ would
+  if (nSaved > 0)
+  {
+    output.push_back({ CommandType::C_POP, "temp", resultSlot });
+    for (int p = 0; p < 2; p++)
+    {
+      if (savedSlot[p] != -1)
+      {
+        output.push_back({ CommandType::C_PUSH, "temp", savedSlot[p] });
+        output.push_back({ CommandType::C_POP, "pointer", p });
+      }
+    }
+    output.push_back({ CommandType::C_PUSH, "temp", resultSlot });
+  }
+
+  return true;
+}
+
+void Inliner::inlineFile(size_t fileIndex)
+{
+  const auto& commands{ m_program[fileIndex].commands };
+  std::vector<VMCommand> output{};
+  output.reserve(commands.size());
+
+  for (const auto& [name, nLocals, begin, end] : FlowGraph::functions(m_program[fileIndex]))
+  {
+    // Temp slots the caller itself uses are never handed to a callee
+    std::bitset<tempSize> callerTemps{};
+    for (size_t i = begin; i < end; i++)
+    {
+      const auto& [type, arg1, arg2] = commands[i];
+      if ((type == CommandType::C_PUSH || type == CommandType::C_POP) && arg1 == "temp" && arg2 < tempSize)
+        callerTemps.set(static_cast<size_t>(arg2));
+    }
+
+    for (size_t i = begin; i < end; i++)
+    {
+      if (commands[i].type != CommandType::C_CALL || !expandCall(commands[i], fileIndex, callerTemps, output))
+        output.push_back(commands[i]);
+    }
+  }
+
+  m_program[fileIndex].commands = std::move(output);
+}
+
+void Inliner::run()
+{
+  collectCallees();
+  if (m_callees.empty())
+    return;
+
+  m_sharedTemps = FlowGraph::sharedTemps(m_program);
+
+  for (size_t f = 0; f < m_program.size(); f++)
+  {
+    inlineFile(f);
+  }
+}
\ No newline at end of file
@@ -1,22 +1,20 @@
 #include <vector>
-#include <fstream>
+#include <istream>
 #include <string>
 #include <algorithm>
 #include "Parser.h"
 #include "CommandType.h"
 
-Parser::Parser(std::ifstream& inputFile)
-  : m_cleanedFile(cleanFile(inputFile))
-  , m_hasMoreCommands(!m_cleanedFile.empty())
-  , m_currentCommandIndex(-1)
+Parser::Parser(std::istream& input)
+  : m_input(input)
 {
+  m_hasMoreCommands = readCommand(m_nextCommand);
 }
 
-std::vector<std::string> Parser::cleanFile(std::ifstream& file) const
+bool Parser::readCommand(std::string& command)
 {
-  std::vector<std::string> cleanedFile{};
   std::string line{};
-  while (std::getline(file, line)) {
+  while (std::getline(m_input, line)) {
     // Remove comments
     size_t commentPos = line.find("//");
     if (commentPos != std::string::npos) 
@@ -27,15 +25,12 @@ std::vector<std::string> Parser::cleanFile(std::ifstream& file) const
     size_t first{ line.find_first_not_of(" \t\r\n") };
     size_t last{ line.find_last_not_of(" \t\r\n") };
     if (first != std::string::npos && last != std::string::npos)
-     {
-      line = line.substr(first, last - first + 1);
-      if (!line.empty()) 
-      {
-        cleanedFile.push_back(line);
-      }
+    {
+      command = line.substr(first, last - first + 1);
+      return true;
     }
   }
-  return cleanedFile;
+  return false;
 }
 
 std::vector<std::string> Parser::getCurrentCommandTokens() const
@@ -69,14 +64,8 @@ void Parser::advance()
     return;
   }
 
-  m_currentCommandIndex ++;
-  size_t index{ static_cast<size_t>(m_currentCommandIndex) };
-  m_currentCommand = m_cleanedFile[index];
-
-  if (index == m_cleanedFile.size() - 1)
-  {
-    m_hasMoreCommands = false;
-  }
+  m_currentCommand.swap(m_nextCommand);
+  m_hasMoreCommands = readCommand(m_nextCommand);
 }
 
 CommandType Parser::commandType() const
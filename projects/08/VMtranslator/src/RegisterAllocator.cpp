@@ -0,0 +1,344 @@
+#include <string>
+#include <vector>
+#include <utility>
+#include <bitset>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include "RegisterAllocator.h"
+#include "VMProgram.h"
+#include "CommandType.h"
+#include "FlowGraph.h"
+#include "CallGraph.h"
+
+namespace
+{
+  // Instructions saved per execution when a frame access becomes a fixed
+  // address (push: 9 -> 6, pop: 13 -> 5) and paid on entry to set a cell up
+  constexpr int pushSaving{ 3 };
+  constexpr int popSaving{ 8 };
+  constexpr int argumentCopyCost{ 7 };
+  constexpr int localInitCost{ 2 };
+  constexpr int frameLocalCost{ 5 };   // the push of 0 that is no longer needed
+
+  bool isTemp(const VMCommand& command)
+  {
+    return (command.type == CommandType::C_PUSH || command.type == CommandType::C_POP) &&
+           command.arg1 == "temp" && command.arg2 >= 0 && command.arg2 < FlowGraph::tempSize;
+  }
+
+  // Blocks that are part of a loop: the back edges (to a block still on
+  // the DFS stack) are found in one pass, then each natural loop is walked
+  // backwards from its back edge to its header. For the reducible graphs
+  // the Jack compiler emits these are exactly the blocks on a cycle.
+  std::vector<bool> loopBlocks(const FlowGraph& graph)
+  {
+    const auto& blocks{ graph.blocks() };
+    const size_t nBlocks{ blocks.size() };
+    std::vector<bool> inLoop(nBlocks, false);
+
+    enum class State { NEW, OPEN, DONE };
+    std::vector<State> state(nBlocks, State::NEW);
+    std::vector<std::pair<size_t, size_t>> backEdges{};   // tail, header
+    std::vector<std::pair<size_t, size_t>> stack{};       // block, next successor
+
+    // Every block is a root, so that unreachable loops count as well
+    for (size_t root = 0; root < nBlocks; root++)
+    {
+      if (state[root] != State::NEW)
+        continue;
+      state[root] = State::OPEN;
+      stack.push_back({ root, 0 });
+      while (!stack.empty())
+      {
+        auto& [block, next] = stack.back();
+        if (next == blocks[block].successors.size())
+        {
+          state[block] = State::DONE;
+          stack.pop_back();
+          continue;
+        }
+        const size_t successor{ blocks[block].successors[next++] };
+        if (state[successor] == State::OPEN)
+          backEdges.push_back({ block, successor });
+        else if (state[successor] == State::NEW)
+        {
+          state[successor] = State::OPEN;
+          stack.push_back({ successor, 0 });
+        }
+      }
+    }
+
+    // seen[b] is the last loop b was reached in: nested loops are walked
+    // again by the loops around them, each block once per loop
+    std::vector<size_t> seen(nBlocks, backEdges.size());
+    std::vector<size_t> work{};
+    for (size_t loop = 0; loop < backEdges.size(); loop++)
+    {
+      const auto [tail, header] = backEdges[loop];
+      seen[header] = loop;
+      inLoop[header] = true;
+      work.assign(1, tail);
+      while (!work.empty())
+      {
+        const size_t block{ work.back() };
+        work.pop_back();
+        if (seen[block] == loop)
+          continue;
+        seen[block] = loop;
+        inLoop[block] = true;
+        work.insert(work.end(), blocks[block].predecessors.begin(), blocks[block].predecessors.end());
+      }
+    }
+
+    return inLoop;
+  }
+}
+
+RegisterAllocator::RegisterAllocator(VMProgram& program)
+  : m_program(program)
+  , m_callGraph(program)
+{
+}
+
+int RegisterAllocator::countStatics(std::unordered_map<std::string, int>& nextStatic) const
+{
+  // StaticLayout gives every file a block as long as its highest index + 1
+  for (const auto& vmFile : m_program)
+  {
+    int& fileNext{ nextStatic[vmFile.fileName] };
+    for (const auto& [type, arg1, arg2] : vmFile.commands)
+    {
+      if ((type == CommandType::C_PUSH || type == CommandType::C_POP) && arg1 == "static")
+        fileNext = std::max(fileNext, arg2 + 1);
+    }
+  }
+
+  int cells{ 0 };
+  for (const auto& [fileName, fileNext] : nextStatic)
+    cells += fileNext;
+  return cells;
+}
+
+void RegisterAllocator::collectCandidates(size_t fileIndex, const FunctionRange& range,
+                                          std::vector<Candidate>& candidates) const
+{
+  if (range.name.empty() || !m_callGraph.isDefined(range.name) || m_callGraph.isRecursive(range.name))
+    return;
+
+  const auto& commands{ m_program[fileIndex].commands };
+  const FlowGraph graph(commands, range);
+  if (!graph.isWellFormed())
+    return;
+
+  const auto& blocks{ graph.blocks() };
+  const std::vector<bool> inLoop{ loopBlocks(graph) };
+
+  std::vector<int> localBenefit(static_cast<size_t>(range.nLocals), 0);
+  std::vector<int> argumentBenefit{};
+
+  for (size_t b = 0; b < blocks.size(); b++)
+  {
+    const int weight{ inLoop[b] ? loopWeight : 1 };
+
+    for (size_t i = blocks[b].begin; i < blocks[b].end; i++)
+    {
+      const auto& [type, arg1, arg2] = commands[i];
+      if (type != CommandType::C_PUSH && type != CommandType::C_POP)
+        continue;
+
+      const int saving{ weight * (type == CommandType::C_PUSH ? pushSaving : popSaving) };
+      if (arg1 == "local")
+      {
+        // Accesses outside the declared locals: leave the function alone
+        if (arg2 < 0 || arg2 >= range.nLocals)
+          return;
+        localBenefit[static_cast<size_t>(arg2)] += saving;
+      }
+      else if (arg1 == "argument")
+      {
+        if (arg2 < 0)
+          return;
+        if (static_cast<size_t>(arg2) >= argumentBenefit.size())
+          argumentBenefit.resize(static_cast<size_t>(arg2) + 1, 0);
+        argumentBenefit[static_cast<size_t>(arg2)] += saving;
+      }
+    }
+  }
+
+  for (int i = 0; i < range.nLocals; i++)
+  {
+    int benefit{ localBenefit[static_cast<size_t>(i)] };
+    if (benefit == 0)
+      continue;
+
+    bool needsInit{ graph.isLocalLiveAtEntry(i) };
+    benefit += frameLocalCost - (needsInit ? localInitCost : 0);
+    candidates.push_back({ fileIndex, range.begin, false, i, needsInit, benefit, "", -1 });
+  }
+
+  for (size_t i = 0; i < argumentBenefit.size(); i++)
+  {
+    int benefit{ argumentBenefit[i] - argumentCopyCost };
+    if (benefit > 0)
+      candidates.push_back({ fileIndex, range.begin, true, static_cast<int>(i), true, benefit, "", -1 });
+  }
+}
+
+void RegisterAllocator::rewriteFile(size_t fileIndex, const std::vector<Candidate>& assigned)
+{
+  const auto& commands{ m_program[fileIndex].commands };
+  std::vector<VMCommand> output{};
+  output.reserve(commands.size() + assigned.size() * 2);
+
+  for (const auto& range : FlowGraph::functions(m_program[fileIndex]))
+  {
+    std::vector<const Candidate*> cells{};
+    for (const auto& candidate : assigned)
+    {
+      if (candidate.functionBegin == range.begin)
+        cells.push_back(&candidate);
+    }
+
+    if (cells.empty())
+    {
+      output.insert(output.end(), commands.begin() + static_cast<long>(range.begin),
+                                  commands.begin() + static_cast<long>(range.end));
+      continue;
+    }
+
+    // Where each slot ends up: a cell, or a new index in the smaller frame
+    std::vector<const Candidate*> localCell(static_cast<size_t>(range.nLocals), nullptr);
+    std::unordered_map<int, const Candidate*> argumentCell{};
+    for (const Candidate* cell : cells)
+    {
+      if (cell->isArgument)
+        argumentCell[cell->index] = cell;
+      else
+        localCell[static_cast<size_t>(cell->index)] = cell;
+    }
+
+    std::vector<int> localIndex(static_cast<size_t>(range.nLocals), -1);
+    int nLocals{ 0 };
+    for (int i = 0; i < range.nLocals; i++)
+    {
+      if (!localCell[static_cast<size_t>(i)])
+        localIndex[static_cast<size_t>(i)] = nLocals++;
+    }
+
+    output.push_back({ CommandType::C_FUNCTION, range.name, nLocals });
+    for (const Candidate* cell : cells)
+    {
+      if (!cell->needsInit)
+        continue;
+
+      if (cell->isArgument)
+        output.push_back({ CommandType::C_PUSH, "argument", cell->index });
+      else
+        output.push_back({ CommandType::C_PUSH, "constant", 0 });
+      output.push_back({ CommandType::C_POP, cell->segment, cell->cell });
+    }
+
+    for (size_t i = range.begin + 1; i < range.end; i++)
+    {
+      VMCommand command{ commands[i] };
+      if (command.type == CommandType::C_PUSH || command.type == CommandType::C_POP)
+      {
+        if (command.arg1 == "local")
+        {
+          const Candidate* cell{ localCell[static_cast<size_t>(command.arg2)] };
+          if (cell)
+            command = { command.type, cell->segment, cell->cell };
+          else
+            command.arg2 = localIndex[static_cast<size_t>(command.arg2)];
+        }
+        else if (command.arg1 == "argument")
+        {
+          auto it{ argumentCell.find(command.arg2) };
+          if (it != argumentCell.end())
+            command = { command.type, it->second->segment, it->second->cell };
+        }
+      }
+      output.push_back(std::move(command));
+    }
+  }
+
+  m_program[fileIndex].commands = std::move(output);
+}
+
+void RegisterAllocator::run()
+{
+  m_sharedTemps = FlowGraph::sharedTemps(m_program);
+
+  std::unordered_map<std::string, int> nextStatic{};
+  int freeStatics{ staticCells - countStatics(nextStatic) };
+
+  auto byBenefit = [](const Candidate& a, const Candidate& b) { return a.benefit > b.benefit; };
+
+  // 1. Leaf functions take the temps first; what does not fit, like the
+  //    slots of every other non-recursive function, competes for statics
+  std::vector<std::vector<Candidate>> assigned(m_program.size());
+  std::vector<Candidate> staticCandidates{};
+
+  for (size_t f = 0; f < m_program.size(); f++)
+  {
+    for (const auto& range : FlowGraph::functions(m_program[f]))
+    {
+      std::vector<Candidate> candidates{};
+      collectCandidates(f, range, candidates);
+      if (candidates.empty())
+        continue;
+
+      std::stable_sort(candidates.begin(), candidates.end(), byBenefit);
+
+      std::vector<int> freeTemps{};
+      if (m_callGraph.isLeaf(range.name))
+      {
+        std::bitset<tempSize> used{ m_sharedTemps };
+        for (size_t i = range.begin; i < range.end; i++)
+        {
+          if (isTemp(m_program[f].commands[i]))
+            used.set(static_cast<size_t>(m_program[f].commands[i].arg2));
+        }
+        for (int t = tempSize - 1; t >= 0; t--)
+        {
+          if (!used.test(static_cast<size_t>(t)))
+            freeTemps.push_back(t);
+        }
+      }
+
+      for (size_t c = 0; c < candidates.size(); c++)
+      {
+        if (c < freeTemps.size())
+        {
+          candidates[c].segment = "temp";
+          candidates[c].cell = freeTemps[c];
+          assigned[f].push_back(std::move(candidates[c]));
+        }
+        else
+        {
+          staticCandidates.push_back(std::move(candidates[c]));
+        }
+      }
+    }
+  }
+
+  // 2. Statics go to the most profitable slots of the whole program
+  std::stable_sort(staticCandidates.begin(), staticCandidates.end(), byBenefit);
+  for (auto& candidate : staticCandidates)
+  {
+    if (freeStatics == 0)
+      break;
+
+    candidate.segment = "static";
+    candidate.cell = nextStatic[m_program[candidate.fileIndex].fileName]++;
+    freeStatics--;
+    assigned[candidate.fileIndex].push_back(std::move(candidate));
+  }
+
+  for (size_t f = 0; f < m_program.size(); f++)
+  {
+    if (!assigned[f].empty())
+      rewriteFile(f, assigned[f]);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include <ostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include "StackAnalysis.h"
+#include "VMProgram.h"
+#include "CommandType.h"
+#include "FlowGraph.h"
+#include "CallAnalysis.h"
+#include "CallGraph.h"
+
+StackAnalysis::StackAnalysis(const VMProgram& program, const CallAnalysis& callAnalysis)
+{
+  collect(program, callAnalysis, CallGraph(program));
+  propagate();
+}
+
+void StackAnalysis::collect(const VMProgram& program, const CallAnalysis& callAnalysis, const CallGraph& callGraph)
+{
+  for (const auto& vmFile : program)
+  {
+    const auto& commands{ vmFile.commands };
+
+    for (const auto& range : FlowGraph::functions(vmFile))
+    {
+      // A name defined twice keeps its first body, as the assembler would
+      // reject the second label anyway
+      if (range.name.empty() || m_index.contains(range.name))
+        continue;
+
+      const FlowGraph graph(commands, range);
+
+      Function function{};
+      function.name = range.name;
+      function.frame = range.nLocals;
+      function.operand = graph.maxStackDepth();
+      function.isWellFormed = graph.isWellFormed();
+      function.isRecursive = callGraph.isDefined(range.name) && callGraph.isRecursive(range.name);
+
+      for (size_t i = range.begin; i < range.end; i++)
+      {
+        if (commands[i].type != CommandType::C_CALL)
+          continue;
+
+        // Same test the lowering uses to emit a tail call
+        bool isTail{ i + 1 < range.end && commands[i + 1].type == CommandType::C_RETURN &&
+                     callAnalysis.canTailCall(range.name, commands[i].arg1, commands[i].arg2) };
+        int depth{ std::max(graph.depthBefore(i), 0) };
+
+        function.calls.push_back({
+          commands[i].arg1,
+          isTail ? 0 : function.frame + depth + savedFrame,
+          isTail
+        });
+      }
+
+      function.worst = function.frame + function.operand;
+      m_index[function.name] = m_functions.size();
+      m_functions.push_back(std::move(function));
+    }
+  }
+
+  for (auto& function : m_functions)
+  {
+    for (const auto& call : function.calls)
+    {
+      if (!m_index.contains(call.callee))
+        function.callsUndefined = true;
+    }
+  }
+}
+
+void StackAnalysis::propagate()
+{
+  // Longest-path relaxation: with n functions, anything still growing after
+  // n rounds is fed by a cycle of positive weight, i.e. real recursion
+  const size_t n{ m_functions.size() };
+  std::vector<bool> changed(n, false);
+
+  for (size_t round = 0; round <= n; round++)
+  {
+    bool any{ false };
+    for (size_t f = 0; f < n; f++)
+    {
+      Function& function{ m_functions[f] };
+      changed[f] = false;
+
+      for (const auto& call : function.calls)
+      {
+        auto it{ m_index.find(call.callee) };
+        if (it == m_index.end())
+          continue;
+
+        int worst{ call.base + m_functions[it->second].worst };
+        if (worst > function.worst)
+        {
+          function.worst = worst;
+          changed[f] = any = true;
+        }
+      }
+    }
+
+    if (!any)
+      return;
+  }
+
+  // Whatever still grew, and every function that can reach it, is unbounded
+  for (size_t f = 0; f < n; f++)
+    m_functions[f].isUnbounded = changed[f];
+
+  for (bool grew = true; grew; )
+  {
+    grew = false;
+    for (auto& function : m_functions)
+    {
+      if (function.isUnbounded)
+        continue;
+      for (const auto& call : function.calls)
+      {
+        auto it{ m_index.find(call.callee) };
+        if (it != m_index.end() && m_functions[it->second].isUnbounded)
+        {
+          function.isUnbounded = grew = true;
+          break;
+        }
+      }
+    }
+  }
+}
+
+const std::vector<StackAnalysis::Function>& StackAnalysis::functions() const noexcept
+{
+  return m_functions;
+}
+
+int StackAnalysis::programPeak() const
+{
+  // The bootstrap sets SP to 256 and calls Sys.init with no arguments
+  auto it{ m_index.find("Sys.init") };
+  if (it == m_index.end())
+    return stackBase;
+
+  const Function& sysInit{ m_functions[it->second] };
+  if (sysInit.isUnbounded)
+    return -1;
+  return stackBase + savedFrame + sysInit.worst;
+}
+
+void StackAnalysis::writeReport(std::ostream& out) const
+{
+  std::vector<const Function*> sorted{};
+  for (const auto& function : m_functions)
+    sorted.push_back(&function);
+  std::sort(sorted.begin(), sorted.end(), [](const Function* a, const Function* b) { return a->name < b->name; });
+
+  out << std::left << std::setw(40) << "function" << std::right
+      << std::setw(8) << "frame" << std::setw(9) << "operand" << std::setw(11) << "worst" << "  notes\n";
+
+  for (const Function* function : sorted)
+  {
+    out << std::left << std::setw(40) << function->name << std::right
+        << std::setw(8) << function->frame << std::setw(9) << function->operand << std::setw(11);
+    if (function->isUnbounded)
+      out << "unbounded";
+    else
+      out << function->worst;
+
+    out << " ";
+    if (!function->isWellFormed)
+      out << " operand stack underflow or inconsistent depth at a label;";
+    if (function->isRecursive)
+      out << " recursive;";
+    if (function->callsUndefined)
+      out << " calls an undefined function;";
+    if (std::any_of(function->calls.begin(), function->calls.end(), [](const CallSite& c) { return c.isTail; }))
+      out << " tail calls;";
+    out << "\n";
+  }
+
+  int peak{ programPeak() };
+  out << "\nstack: " << stackBase << ".." << heapBase - 1 << ", ";
+  if (peak == -1)
+    out << "peak unbounded (recursion through regular calls)\n";
+  else if (peak > heapBase)
+    out << "peak " << peak << ": OVERFLOWS into the heap by " << peak - heapBase << " words\n";
+  else
+    out << "peak " << peak << " (" << heapBase - peak << " words to spare)\n";
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include "StaticLayout.h"
+#include "VMProgram.h"
+#include "CommandType.h"
+
+StaticLayout::StaticLayout(const VMProgram& program)
+{
+  for (const auto& vmFile : program)
+  {
+    auto [it, isNew]{ m_index.emplace(vmFile.fileName, m_blocks.size()) };
+    if (isNew)
+      m_blocks.push_back({ vmFile.fileName, 0, 0 });
+
+    Block& block{ m_blocks[it->second] };
+    for (const auto& [type, arg1, arg2] : vmFile.commands)
+    {
+      if ((type == CommandType::C_PUSH || type == CommandType::C_POP) && arg1 == "static")
+        block.size = std::max(block.size, arg2 + 1);
+    }
+  }
+
+  int next{ firstAddress };
+  for (auto& block : m_blocks)
+  {
+    block.base = next;
+    next += block.size;
+  }
+
+  if (next - 1 > lastAddress)
+    throw std::runtime_error("Static segment overflow: " + std::to_string(next - firstAddress) +
+                             " cells, at most " + std::to_string(lastAddress - firstAddress + 1));
+}
+
+int StaticLayout::base(const std::string& fileName) const
+{
+  auto it{ m_index.find(fileName) };
+  return (it == m_index.end()) ? firstAddress + size() : m_blocks[it->second].base;
+}
+
+int StaticLayout::size() const noexcept
+{
+  return m_blocks.empty() ? 0 : m_blocks.back().base + m_blocks.back().size - firstAddress;
+}
+
+void StaticLayout::writeMap(std::ostream& out) const
+{
+  for (const auto& block : m_blocks)
+  {
+    for (int i = 0; i < block.size; i++)
+      out << block.fileName << "." << i << " " << block.base + i << "\n";
+  }
+}
\ No newline at end of file
@@ -0,0 +1,473 @@
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <exception>
+#include <functional>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include "Translator.h"
+#include "Parser.h"
+#include "CodeGenerator.h"
+#include "CodeWriter.h"
+#include "InlineCodeWriter.h"
+#include "OutputBuffer.h"
+#include "TranslatorOptions.h"
+#include "StackAnalysis.h"
+#include "HackAssembler.h"
+#include "HackCode.h"
+#include "CommandType.h"
+#include "InputFiles.h"
+#include "VMProgram.h"
+#include "Inliner.h"
+#include "CallAnalysis.h"
+#include "ConstantFolder.h"
+#include "RegisterAllocator.h"
+#include "StaticLayout.h"
+
+Translator::Translator(InputFiles& inputFiles, std::ostream& outputFile, const TranslatorOptions& options)
+  : m_inputFiles(inputFiles)
+  , m_outputFile(outputFile)
+  , m_options(options)
+{
+}
+
+void Translator::forEachFile(size_t nFiles, const std::function<void(size_t)>& task)
+{
+  std::vector<std::exception_ptr> errors(nFiles);
+  std::atomic<size_t> nextFile{ 0 };
+
+  auto worker = [&]()
+  {
+    for (size_t i{ nextFile++ }; i < nFiles; i = nextFile++)
+    {
+      try
+      {
+        task(i);
+      }
+      catch (...)
+      {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+
+  size_t nWorkers{ std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), nFiles) };
+  std::vector<std::thread> workers{};
+  for (size_t i = 1; i < nWorkers; i++)
+  {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto& t : workers)
+  {
+    t.join();
+  }
+
+  // Report the error of the first failing file, as a sequential run would
+  for (const auto& error : errors)
+  {
+    if (error)
+      std::rethrow_exception(error);
+  }
+}
+
+void Translator::translate()
+{
+  const size_t nFiles{ m_inputFiles.size() };
+
+  // 1. Each file is parsed by a pool of workers
+  VMProgram program(nFiles);
+  forEachFile(nFiles, [&](size_t i) { program[i] = parseFile(m_inputFiles[i]); });
+
+  generate(program);
+}
+
+void Translator::translate(std::istream& input)
+{
+  // The whole-program passes, the assembler and the stack report need
+  // every function first
+  if (m_options.level == OptimizationLevel::O2 || m_options.outputFormat != OutputFormat::ASM ||
+      m_options.stackReport)
+  {
+    VMProgram program{ parseStream(input) };
+    generate(program);
+    return;
+  }
+
+  streamFunctions(input);
+}
+
+std::vector<uint16_t> Translator::translateToWords(std::istream& input)
+{
+  VMProgram program{ parseStream(input) };
+  std::vector<uint16_t> words{};
+  generate(program, &words);
+  return words;
+}
+
+// With `words` the program is linked into it rather than written out
+void Translator::generate(VMProgram& program, std::vector<uint16_t>* words)
+{
+  const size_t nFiles{ program.size() };
+
+  // 2. Whole-program passes, -O2 only
+  // Folding first turns multiplications by constants into shifts before the
+  // inliner sees the calls, then again to fold the inlined bodies
+  const bool optimize{ m_options.level == OptimizationLevel::O2 };
+  if (optimize)
+  {
+    forEachFile(nFiles, [&](size_t i) { ConstantFolder(program[i]).run(); });
+
+    Inliner inliner(program);
+    inliner.run();
+
+    forEachFile(nFiles, [&](size_t i) { ConstantFolder(program[i]).run(); });
+
+    RegisterAllocator registerAllocator(program);
+    registerAllocator.run();
+  }
+
+  const CallAnalysis callAnalysis(program, optimize);
+
+  // Statics get their addresses here rather than from the assembler
+  const StaticLayout staticLayout(program);
+  if (!m_options.staticMap.empty())
+  {
+    std::ofstream map(m_options.staticMap);
+    if (!map)
+      throw std::runtime_error("Unable to create static map file: " + m_options.staticMap);
+    staticLayout.writeMap(map);
+  }
+
+  // Stack usage of the program exactly as it will be lowered
+  const StackAnalysis stackAnalysis(program, callAnalysis);
+  if (m_options.stackReport)
+    stackAnalysis.writeReport(std::cout);
+
+  int stackPeak{ stackAnalysis.programPeak() };
+  if (stackPeak > StackAnalysis::heapBase)
+    std::cerr << "Warning: the stack can grow up to " << stackPeak << ", past the heap base at "
+              << StackAnalysis::heapBase << std::endl;
+
+  // 3. Each file is lowered into its own buffer by a pool of workers
+  if (m_options.outputFormat == OutputFormat::ASM && !words)
+  {
+    std::vector<OutputBuffer> buffers(nFiles);
+    forEachFile(nFiles, [&](size_t i) {
+      HackCode code(buffers[i]);
+      lowerFile(program[i], static_cast<int>(i), callAnalysis, staticLayout.base(program[i].fileName), *makeCodeGenerator(code));
+    });
+
+    // Bootstrap code, then every file in the order established by main
+    OutputBuffer boot(m_outputFile);
+    HackCode bootCode(boot);
+    writeBootstrap(callAnalysis, bootCode);
+    boot.flush();
+
+    for (const auto& buffer : buffers)
+    {
+      buffer.writeTo(m_outputFile);
+    }
+    return;
+  }
+
+  // Machine code: the code writers emit instruction words straight into
+  // one object per file, with no assembly text; object 0 is the bootstrap
+  std::vector<HackAssembler::Object> objects(nFiles + 1);
+  forEachFile(nFiles, [&](size_t i) {
+    HackCode code(objects[i + 1]);
+    lowerFile(program[i], static_cast<int>(i), callAnalysis, staticLayout.base(program[i].fileName), *makeCodeGenerator(code));
+  });
+
+  HackCode bootCode(objects[0]);
+  writeBootstrap(callAnalysis, bootCode);
+
+  if (words)
+  {
+    *words = HackAssembler::link(objects);
+    return;
+  }
+
+  const std::vector<uint16_t> linked{ HackAssembler::link(objects) };
+  if (m_options.outputFormat == OutputFormat::HACK_BINARY)
+    HackAssembler::writeBinary(linked, m_outputFile);
+  else
+    HackAssembler::writeText(linked, m_outputFile);
+}
+
+VMCommand Translator::parseCommand(const Parser& parser)
+{
+  CommandType type{ parser.commandType() };
+  switch (type)
+  {
+  case CommandType::C_ARITHMETIC:
+  {
+    return { type, parser.arg1(), 0 };
+  }
+  case CommandType::C_PUSH:
+  case CommandType::C_POP:
+  {
+    return { type, parser.arg1(), parser.arg2() };
+  }
+  case CommandType::C_LABEL:
+  {
+    std::string label{ parser.arg1() };
+    if (!isValidName(label))
+      throw std::invalid_argument("Invalid label command: invalid label: " + label);
+
+    return { type, label, 0 };
+  }
+  case CommandType::C_GOTO:
+  {
+    std::string label{ parser.arg1() };
+    if (!isValidName(label))
+      throw std::invalid_argument("Invalid goto command: invalid label: " + label);
+
+    return { type, label, 0 };
+  }
+  case CommandType::C_IF:
+  {
+    std::string label{ parser.arg1() };
+    if (!isValidName(label))
+      throw std::invalid_argument("Invalid if command: invalid label: " + label);
+
+    return { type, label, 0 };
+  }
+  case CommandType::C_FUNCTION:
+  {
+    std::string functionName{ parser.arg1() };
+    if (!isValidName(functionName))
+      throw std::invalid_argument("Invalid function command: invalid function name: " + functionName);
+
+    int nLocals{ parser.arg2() };
+    if (nLocals < 0)
+      throw std::invalid_argument("Invalid function command: invalid local variables number: " + nLocals);
+
+    return { type, functionName, nLocals };
+  }
+  case CommandType::C_RETURN:
+  {
+    return { type, "", 0 };
+  }
+  case CommandType::C_CALL:
+  {
+    std::string functionName{ parser.arg1() };
+    if (!isValidName(functionName))
+      throw std::invalid_argument("Invalid call command: invalid function name: " + functionName);
+    
+    int nArgs{ parser.arg2() };
+    if (nArgs < 0)
+      throw std::invalid_argument("Invalid call command: invalid arguments number: " + nArgs);
+
+    return { type, functionName, nArgs };
+  }
+  default:
+    throw std::runtime_error("Error: unknown command type");
+  }
+}
+
+VMFile Translator::parseFile(InputFile& inputFile)
+{
+  auto& [fileName, file] = inputFile;
+
+  Parser parser(file);
+  VMFile vmFile{ fileName, {} };
+
+  while (parser.hasMoreCommands())
+  {
+    parser.advance();
+    vmFile.commands.push_back(parseCommand(parser));
+  }
+
+  return vmFile;
+}
+
+VMProgram Translator::parseStream(std::istream& input)
+{
+  // One VMFile per class, named as the file the class would come from
+  Parser parser(input);
+  VMProgram program{};
+
+  while (parser.hasMoreCommands())
+  {
+    parser.advance();
+    VMCommand command{ parseCommand(parser) };
+
+    std::string className{ command.arg1.substr(0, command.arg1.find('.')) };
+    if (program.empty() || (command.type == CommandType::C_FUNCTION && className != program.back().fileName))
+      program.push_back({ command.type == CommandType::C_FUNCTION ? className : "stdin", {} });
+
+    program.back().commands.push_back(std::move(command));
+  }
+
+  return program;
+}
+
+std::unique_ptr<CodeGenerator> Translator::makeCodeGenerator(HackCode& code) const
+{
+  if (m_options.level == OptimizationLevel::O0)
+    return std::make_unique<InlineCodeWriter>(code);
+  return std::make_unique<CodeWriter>(code);
+}
+
+void Translator::writeBootstrap(const CallAnalysis& callAnalysis, HackCode& code) const
+{
+  auto codeWriter{ makeCodeGenerator(code) };
+  codeWriter->setFileName("$BOOT$", -1);
+  codeWriter->writeInit(callAnalysis.callArities(), callAnalysis.tailCallArities(), callAnalysis.isDefined("Sys.init"));
+}
+
+void Translator::translateFile(const VMFile& vmFile, HackAssembler::Object& object, std::set<int>& callArities) const
+{
+  if (m_options.level == OptimizationLevel::O2)
+    throw std::invalid_argument("Separate translation is only available below -O2");
+
+  const CallAnalysis callAnalysis({ vmFile }, false);
+  callArities.insert(callAnalysis.callArities().begin(), callAnalysis.callArities().end());
+
+  HackCode code(object);
+  lowerFile(vmFile, -1, callAnalysis, -1, *makeCodeGenerator(code));
+}
+
+void Translator::writeSeparateBootstrap(const std::set<int>& callArities, bool callSysInit,
+                                        HackAssembler::Object& object) const
+{
+  HackCode code(object);
+  auto codeWriter{ makeCodeGenerator(code) };
+  codeWriter->setFileName("$BOOT$", -1);
+  codeWriter->writeInit(callArities, {}, callSysInit);
+}
+
+void Translator::streamFunctions(std::istream& input)
+{
+  // One function is held at a time. The bootstrap needs to know whether
+  // Sys.init exists and which call stubs are used, so it goes at the end
+  // and address 0 jumps to it; for the same reason statics stay symbolic.
+  Parser parser(input);
+  OutputBuffer output(m_outputFile);
+  HackCode code(output);
+  auto codeWriter{ makeCodeGenerator(code) };
+
+  codeWriter->writeGoto("$STREAM$BOOT$");
+  codeWriter->writeLabel("$STREAM$START$");
+
+  std::set<int> callArities{};
+  bool hasSysInit{ false };
+  VMFile function{ "stdin", {} };
+
+  auto lowerFunction = [&]()
+  {
+    const CallAnalysis callAnalysis({ function }, false);
+    callArities.insert(callAnalysis.callArities().begin(), callAnalysis.callArities().end());
+
+    lowerFile(function, -1, callAnalysis, -1, *codeWriter);
+    output.flush();
+    m_outputFile.flush();
+    function.commands.clear();
+  };
+
+  while (parser.hasMoreCommands())
+  {
+    parser.advance();
+    VMCommand command{ parseCommand(parser) };
+
+    if (command.type == CommandType::C_FUNCTION)
+    {
+      if (!function.commands.empty())
+        lowerFunction();
+
+      function.fileName = command.arg1.substr(0, command.arg1.find('.'));
+      hasSysInit = hasSysInit || command.arg1 == "Sys.init";
+    }
+    function.commands.push_back(std::move(command));
+  }
+  if (!function.commands.empty())
+    lowerFunction();
+
+  // Code without Sys.init would run off its end into the bootstrap
+  codeWriter->writeLabel("$STREAM$END$");
+  codeWriter->writeGoto("$STREAM$END$");
+
+  codeWriter->setFileName("$BOOT$", -1);
+  codeWriter->writeLabel("$STREAM$BOOT$");
+  if (!hasSysInit)
+    codeWriter->writeGoto("$STREAM$START$");
+  codeWriter->writeInit(callArities, {}, hasSysInit);
+  output.flush();
+}
+
+void Translator::lowerFile(const VMFile& vmFile, int fileIndex, const CallAnalysis& callAnalysis, int staticBase,
+                           CodeGenerator& codeWriter) const
+{
+  // Peephole fusions are part of -O2; below it callAnalysis already rules
+  // out tail calls and leaf returns
+  const bool fuse{ m_options.level == OptimizationLevel::O2 };
+
+  codeWriter.setFileName(vmFile.fileName, fileIndex);
+  codeWriter.setStaticBase(staticBase);
+
+  std::string currentFunctionName{};
+
+  const auto& commands{ vmFile.commands };
+  for (size_t i = 0; i < commands.size(); i++)
+  {
+    const auto& [type, arg1, arg2] = commands[i];
+
+    switch (type)
+    {
+    case CommandType::C_ARITHMETIC:
+      if (arg1 == "shl")
+        codeWriter.writeShiftLeft(arg2);
+      else
+        codeWriter.writeArithmetic(arg1);
+      break;
+    case CommandType::C_PUSH:
+      // push x / pop into a fixed address: move x there through D
+      if (fuse && i + 1 < commands.size() && commands[i + 1].type == CommandType::C_POP &&
+          CodeWriter::isFixedSegment(commands[i + 1].arg1))
+      {
+        codeWriter.writeMove(arg1, arg2, commands[i + 1].arg1, commands[i + 1].arg2);
+        i++;
+        break;
+      }
+      codeWriter.writePushPop(type, arg1, arg2);
+      break;
+    case CommandType::C_POP:
+      codeWriter.writePushPop(type, arg1, arg2);
+      break;
+    case CommandType::C_LABEL:
+      codeWriter.writeLabel(currentFunctionName + "$" + arg1);
+      break;
+    case CommandType::C_GOTO:
+      codeWriter.writeGoto(currentFunctionName + "$" + arg1);
+      break;
+    case CommandType::C_IF:
+      codeWriter.writeIf(currentFunctionName + "$" + arg1);
+      break;
+    case CommandType::C_FUNCTION:
+      currentFunctionName = arg1;
+      codeWriter.writeFunction(arg1, arg2);
+      break;
+    case CommandType::C_RETURN:
+      codeWriter.writeReturn(callAnalysis.restoresPointers(currentFunctionName));
+      break;
+    case CommandType::C_CALL:
+      if (i + 1 < commands.size() && commands[i + 1].type == CommandType::C_RETURN &&
+          callAnalysis.canTailCall(currentFunctionName, arg1, arg2))
+      {
+        codeWriter.writeTailCall(arg1, arg2);
+        i++;
+        break;
+      }
+      codeWriter.writeCall(arg1, arg2);
+      break;
+    default:
+      throw std::runtime_error("Error: unknown command type");
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cctype>
+#include <filesystem>
+#include <algorithm>
+#include "InputFiles.h"
+#include "Translator.h"
+#include "TranslatorOptions.h"
+
+namespace fs = std::filesystem;
+
+int main(int argc, char* argv[]) 
+{
+  // --hack / --hack-binary: assemble in process and write machine code
+  // instead of the .asm text
+  // --stack-report: print the worst-case stack usage of every function
+  // -O0 / -O1 / -O2: code generation strategy, see OptimizationLevel.h
+  // (-O2 by default, -O1 for "-" so that stdin is translated as it streams)
+  // --static-map: write the address of every static next to the output (.map)
+  TranslatorOptions options{};
+  std::string outputExtension{ ".asm" };
+  std::string inputPath{};
+  bool staticMap{ false };
+  bool levelGiven{ false };
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg{ argv[i] };
+    if (arg == "--hack")
+    {
+      options.outputFormat = OutputFormat::HACK;
+      outputExtension = ".hack";
+    }
+    else if (arg == "--hack-binary")
+    {
+      options.outputFormat = OutputFormat::HACK_BINARY;
+      outputExtension = ".bin";
+    }
+    else if (arg == "--stack-report")
+    {
+      options.stackReport = true;
+    }
+    else if (arg == "--static-map")
+    {
+      staticMap = true;
+    }
+    else if (arg == "-O0" || arg == "-O1" || arg == "-O2")
+    {
+      options.level = (arg == "-O0") ? OptimizationLevel::O0 :
+                      (arg == "-O1") ? OptimizationLevel::O1 : OptimizationLevel::O2;
+      levelGiven = true;
+    }
+    else if (arg.starts_with("-") && arg != "-")
+    {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return 1;
+    }
+    else if (inputPath.empty())
+    {
+      inputPath = arg;
+    }
+    else
+    {
+      inputPath.clear();
+      break;
+    }
+  }
+
+  if (inputPath.empty()) 
+  {
+    std::cerr << "Usage: VMtranslator [-O0 | -O1 | -O2] [--hack | --hack-binary] [--stack-report] [--static-map] <file.vm | directory | ->" << std::endl;
+    std::cerr << "  -: VM code from stdin, streamed function by function at -O0/-O1 with .asm output" << std::endl;
+    std::cerr << "     (the default there is -O1; -O2 and --hack read the whole stream first)" << std::endl;
+    return 1;
+  }
+
+  // "-": VM code from stdin, output on stdout, so the translator can sit
+  // in a pipeline between the JackCompiler and the Assembler
+  if (inputPath == "-")
+  {
+    if (options.stackReport || staticMap)
+    {
+      std::cerr << "--stack-report and --static-map are not available when the output is on stdout" << std::endl;
+      return 1;
+    }
+
+    // -O2 needs the whole program before emitting anything
+    if (!levelGiven)
+      options.level = OptimizationLevel::O1;
+
+    InputFiles noFiles{};
+    Translator translator(noFiles, std::cout, options);
+    translator.translate(std::cin);
+    std::cout.flush();
+    return 0;
+  }
+
+  fs::path inPath(inputPath);
+  if (!fs::exists(inPath)) 
+  {
+    std::cerr << "Unable to access path: " << inPath << std::endl;
+    return 1;
+  }
+
+  InputFiles inputFiles{};
+  std::string outputFileName{};
+
+  if (fs::is_directory(inPath)) 
+  {
+    // 1) raccogli TUTTI i .vm ricorsivamente (solo file regolari)
+    std::vector<fs::path> vmFiles;
+    for (const auto& entry :
+         fs::recursive_directory_iterator(inPath, fs::directory_options::skip_permission_denied))
+    {
+      if (!entry.is_regular_file()) continue;
+      if (entry.path().extension() == ".vm") vmFiles.push_back(entry.path());
+    }
+
+    if (vmFiles.empty()) 
+    {
+      std::cerr << "No .vm files in directory (recursively): " << inPath << std::endl;
+      return 1;
+    }
+
+    // 2) ordine deterministico su path (lessicografico)
+    std::sort(vmFiles.begin(), vmFiles.end(),
+              [](const fs::path& a, const fs::path& b){
+                return a.generic_string() < b.generic_string();
+              });
+
+    // 3) apri e inserisci in inputFiles
+    for (const auto& p : vmFiles) 
+    {
+      std::ifstream inputFile(p);
+      if (!inputFile) 
+      {
+        std::cerr << "Unable to open file: " << p << std::endl;
+        return 1;
+      }
+      inputFiles.push_back({
+        p.stem().string(),       // nome senza estensione
+        std::move(inputFile)     // ifstream è move-only
+      });
+    }
+
+    // 4) nome output: <dir>/<dir>.asm (come da specifica nand2tetris)
+    outputFileName = (inPath / (
+      (inPath.has_filename() ? inPath.filename() : inPath.parent_path().filename()).string() + outputExtension
+    )).string();
+  }
+  else if (fs::is_regular_file(inPath)) 
+  {
+    // controllo estensione
+    if (inPath.extension() != ".vm") 
+    {
+      std::cerr << "Input file must have a .vm extension" << std::endl;
+      return 1;
+    }
+
+    std::ifstream inputFile(inPath);
+    if (!inputFile) 
+    {
+      std::cerr << "Unable to open file: " << inPath << std::endl;
+      return 1;
+    }
+
+    inputFiles.push_back({
+      inPath.stem().string(),   // base name (senza .vm)
+      std::move(inputFile)
+    });
+
+    // output accanto al file: <file>.asm
+    outputFileName =
+      (inPath.parent_path() / (inPath.stem().string() + outputExtension)).string();
+  }
+  else 
+  {
+    std::cerr << inPath << " is neither a file nor a directory." << std::endl;
+    return 1;
+  }
+
+  if (staticMap)
+    options.staticMap = fs::path(outputFileName).replace_extension(".map").string();
+
+  // crea il file di output
+  std::ofstream outputFile(outputFileName, 
+    options.outputFormat == OutputFormat::HACK_BINARY ? std::ios::out | std::ios::binary : std::ios::out);
+  if (!outputFile) 
+  {
+    std::cerr << "Unable to create output file: " << outputFileName << std::endl;
+    return 1;
+  }
+
+  Translator translator(inputFiles, outputFile, options);
+  translator.translate();
+
+  std::cout << "Translation completed. Output written to: " << outputFileName << std::endl;
+  return 0;
+}
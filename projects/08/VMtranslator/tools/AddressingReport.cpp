@@ -0,0 +1,125 @@
+// Static report of the instructions the addressing selector saves.
+//
+//   AddressingReport <file.vm | directory>...
+//
+// Every push/pop on local, argument, this and that in the given programs is
+// costed twice with CodeWriter's cost model: with the fixed sequences the
+// translators used before (@index / D=A / @BASE / A=D+M, and the address
+// parked in R13 for pops) and with the mode selectAddressing() picks. The
+// counts are per occurrence in the code, not per execution.
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <algorithm>
+#include "Parser.h"
+#include "CodeWriter.h"
+#include "CommandType.h"
+
+namespace fs = std::filesystem;
+
+struct Totals
+{
+  long accesses{ 0 };
+  long before{ 0 };
+  long after{ 0 };
+};
+
+static void countFile(const fs::path& path, Totals& totals)
+{
+  std::ifstream inputFile(path);
+  if (!inputFile)
+    throw std::runtime_error("Unable to open file: " + path.string());
+
+  Parser parser(inputFile);
+  while (parser.hasMoreCommands())
+  {
+    parser.advance();
+
+    CommandType type{ parser.commandType() };
+    if (type != CommandType::C_PUSH && type != CommandType::C_POP)
+      continue;
+
+    std::string segment{ parser.arg1() };
+    int index{ parser.arg2() };
+    if (segment != "local" && segment != "argument" && segment != "this" && segment != "that")
+      continue;
+
+    CodeWriter::Addressing generic{
+      type == CommandType::C_PUSH ? CodeWriter::Addressing::INDEX_ADD : CodeWriter::Addressing::ADDRESS_IN_R13
+    };
+
+    totals.accesses++;
+    totals.before += CodeWriter::addressingCost(type, segment, index, generic);
+    totals.after += CodeWriter::selectAddressing(type, segment, index).cost;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: AddressingReport <file.vm | directory>..." << std::endl;
+    return 1;
+  }
+
+  // One row per directory holding .vm files
+  std::vector<std::pair<std::string, Totals>> rows{};
+  try
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      std::vector<fs::path> vmFiles{};
+      fs::path inPath(argv[i]);
+      if (fs::is_directory(inPath))
+      {
+        for (const auto& entry : fs::recursive_directory_iterator(inPath))
+        {
+          if (entry.is_regular_file() && entry.path().extension() == ".vm")
+            vmFiles.push_back(entry.path());
+        }
+      }
+      else
+      {
+        vmFiles.push_back(inPath);
+      }
+      std::sort(vmFiles.begin(), vmFiles.end());
+
+      for (const auto& vmFile : vmFiles)
+      {
+        std::string program{ vmFile.parent_path().generic_string() };
+        if (rows.empty() || rows.back().first != program)
+          rows.push_back({ program, {} });
+        countFile(vmFile, rows.back().second);
+      }
+    }
+  }
+  catch (const std::exception& error)
+  {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+
+  Totals total{};
+  std::cout << std::left << std::setw(56) << "program" << std::right
+            << std::setw(10) << "accesses" << std::setw(10) << "before"
+            << std::setw(10) << "after" << std::setw(10) << "saved" << "\n";
+  for (const auto& [program, totals] : rows)
+  {
+    std::cout << std::left << std::setw(56) << program << std::right
+              << std::setw(10) << totals.accesses << std::setw(10) << totals.before
+              << std::setw(10) << totals.after << std::setw(10) << totals.before - totals.after << "\n";
+    total.accesses += totals.accesses;
+    total.before += totals.before;
+    total.after += totals.after;
+  }
+
+  double percent{ total.before == 0 ? 0.0 : 100.0 * static_cast<double>(total.before - total.after) / static_cast<double>(total.before) };
+  std::cout << std::left << std::setw(56) << "total" << std::right
+            << std::setw(10) << total.accesses << std::setw(10) << total.before
+            << std::setw(10) << total.after << std::setw(10) << total.before - total.after
+            << "  (" << std::fixed << std::setprecision(1) << percent << "%)" << std::endl;
+  return 0;
+}
\ No newline at end of file
@@ -1,17 +0,0 @@
-#ifndef COMMANDTYPE_H
-#define COMMANDTYPE_H
-
-enum class CommandType
-{
-  C_ARITHMETIC,
-  C_PUSH,
-  C_POP,
-  C_LABEL,
-  C_GOTO,
-  C_IF,
-  C_FUNCTION,
-  C_RETURN,
-  C_CALL
-};
-
-#endif
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef BUILDCACHE_H
+#define BUILDCACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include "HackAssembler.h"
+
+// Results of the build stages kept on disk, one file per class and stage,
+// named after the key of the stage's input (the version of the tool that
+// produced it included): <key>.vm holds the VM code of a Jack class,
+// <key>.obj the assembled code of a VM class. Files are
+// written aside and renamed, so that a concurrent build never reads half a
+// file. A cache without a directory keeps nothing.
+class BuildCache
+{
+public:
+  // Format of the .obj files
+  static constexpr uint32_t version{ 1 };
+
+  // A class translated and assembled on its own, with what the bootstrap
+  // needs to know about it
+  struct Unit
+  {
+    HackAssembler::Object object{};
+    std::set<int> callArities{};
+    bool definesSysInit{ false };
+  };
+
+private:
+  std::filesystem::path m_dir{};
+
+  std::filesystem::path pathOf(uint64_t key, const char* extension) const;
+  void write(const std::filesystem::path& path, const std::string& contents) const;
+
+public:
+  BuildCache() = default;
+  explicit BuildCache(const std::filesystem::path& dir);
+
+  // 64-bit key of the parts, in order
+  static uint64_t key(std::initializer_list<std::string_view> parts);
+
+  // load gives nothing for a missing, stale or damaged file; save throws
+  // std::runtime_error when the file cannot be written
+  std::optional<std::string> loadVM(uint64_t key) const;
+  void saveVM(uint64_t key, const std::string& vmCode) const;
+  std::optional<Unit> loadUnit(uint64_t key) const;
+  void saveUnit(uint64_t key, const Unit& unit) const;
+};
+
+#endif
\ No newline at end of file
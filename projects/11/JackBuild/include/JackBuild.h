@@ -0,0 +1,71 @@
+#ifndef JACKBUILD_H
+#define JACKBUILD_H
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "BuildCache.h"
+#include "OptimizationLevel.h"
+
+struct BuildOptions
+{
+  OptimizationLevel level{ OptimizationLevel::O1 };
+  std::filesystem::path osDir{};      // .vm files of the classes the program does not define
+  std::filesystem::path cacheDir{};   // no cache if empty
+  std::filesystem::path skipDir{};    // never searched for sources (the output directory)
+  unsigned jobs{ 0 };                 // 0: one per hardware thread
+};
+
+// Jack program to Hack machine code in one process: the JackCompiler and
+// the VM translator, which encodes the instructions itself, run on each
+// class in memory, classes in parallel. Below -O2 every class is
+// translated on its own (statics stay symbolic until the link), so that
+// both its VM code and its object can be taken from the cache by the hash
+// of the input; the link of all the objects behind a bootstrap is the only
+// step that always runs. -O2 optimizes across classes: the VM code is
+// still cached, the whole program is translated again.
+class JackBuild
+{
+public:
+  struct Report
+  {
+    size_t classes{ 0 };
+    size_t compiled{ 0 };       // Jack classes not found in the cache
+    size_t translated{ 0 };     // VM classes not found in the cache
+    size_t words{ 0 };
+  };
+
+private:
+  struct Source
+  {
+    std::string className{};
+    std::filesystem::path path{};
+    bool isJack{ false };
+    std::string text{};
+    std::string vmCode{};
+  };
+
+  BuildOptions m_options;
+  BuildCache m_cache;
+  std::vector<Source> m_sources{};
+
+  void addSource(const std::filesystem::path& path);
+  void collect(const std::filesystem::path& input);
+  void forEachSource(const std::function<void(size_t)>& task) const;
+  void compileJack(Report& report);
+  std::vector<uint16_t> linkSeparately(Report& report);
+  std::vector<uint16_t> translateWhole() const;
+
+public:
+  explicit JackBuild(const BuildOptions& options);
+
+  // input: a directory searched recursively for .jack files (and .vm files
+  // of classes without one), or a single .jack file. Throws
+  // CompilationError, std::invalid_argument and std::runtime_error.
+  Report build(const std::filesystem::path& input, std::ostream& hackOut);
+};
+
+#endif
\ No newline at end of file
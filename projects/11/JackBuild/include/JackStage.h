@@ -0,0 +1,19 @@
+#ifndef JACKSTAGE_H
+#define JACKSTAGE_H
+
+#include <string>
+
+// First stage of the build: the JackCompiler on a class in memory. It has
+// a translation unit of its own because the compiler and the translator
+// headers both define an InputFile.
+namespace JackStage
+{
+  // Version of the VM code the compiler emits, part of the cache keys:
+  // bump it whenever the compiler's output changes
+  constexpr int version{ 1 };
+
+  // VM code of the class; throws CompilationError
+  std::string compile(const std::string& className, const std::string& source);
+}
+
+#endif
\ No newline at end of file
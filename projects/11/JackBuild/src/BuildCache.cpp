@@ -0,0 +1,245 @@
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+#include <unistd.h>
+#include "BuildCache.h"
+
+namespace
+{
+  struct ObjectHeader
+  {
+    char magic[8]{};
+    uint32_t version{ 0 };
+    uint32_t definesSysInit{ 0 };
+    uint64_t key{ 0 };
+    uint32_t nWords{ 0 };
+    uint32_t nLabels{ 0 };
+    uint32_t nFixups{ 0 };
+    uint32_t nArities{ 0 };
+    uint32_t nNameBytes{ 0 };
+    uint32_t unused{ 0 };
+  };
+
+  // A label, or the symbol of a fixup at word `value`, in the names
+  struct ObjectName
+  {
+    uint32_t offset{ 0 };
+    uint32_t length{ 0 };
+    uint32_t value{ 0 };
+  };
+
+  constexpr char objectMagic[8]{ 'H', 'A', 'C', 'K', 'O', 'B', 'J', '\0' };
+
+  static_assert(sizeof(ObjectHeader) % 8 == 0 && sizeof(ObjectName) == 12);
+
+  // 64-bit multiply and xor-shift over 8-byte words, as the VM emulator's
+  // cache keys
+  uint64_t mix(uint64_t hash, const char* data, size_t size)
+  {
+    constexpr uint64_t multiplier{ 0x9E3779B97F4A7C15ull };
+    size_t i{ 0 };
+    for (; i + 8 <= size; i += 8)
+    {
+      uint64_t word{ 0 };
+      std::memcpy(&word, data + i, 8);
+      hash = (hash ^ word) * multiplier;
+      hash ^= hash >> 32;
+    }
+    for (; i < size; i++)
+    {
+      hash = (hash ^ static_cast<unsigned char>(data[i])) * multiplier;
+      hash ^= hash >> 32;
+    }
+    return (hash ^ size) * multiplier;
+  }
+
+  std::string keyLine(uint64_t key)
+  {
+    std::ostringstream line{};
+    line << "// " << std::hex << std::setw(16) << std::setfill('0') << key << "\n";
+    return line.str();
+  }
+
+  std::optional<std::string> readFile(const std::filesystem::path& path)
+  {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+      return std::nullopt;
+    std::ostringstream contents{};
+    contents << in.rdbuf();
+    return contents.str();
+  }
+
+  template <typename T>
+  void append(std::string& bytes, const T& value)
+  {
+    bytes.append(reinterpret_cast<const char*>(&value), sizeof value);
+  }
+}
+
+BuildCache::BuildCache(const std::filesystem::path& dir)
+  : m_dir{ dir }
+{
+  std::filesystem::create_directories(m_dir);
+}
+
+uint64_t BuildCache::key(std::initializer_list<std::string_view> parts)
+{
+  uint64_t key{ mix(0, reinterpret_cast<const char*>(&version), sizeof version) };
+  for (std::string_view part : parts)
+    key = mix(key, part.data(), part.size());
+  return key;
+}
+
+std::filesystem::path BuildCache::pathOf(uint64_t key, const char* extension) const
+{
+  std::ostringstream name{};
+  name << std::hex << std::setw(16) << std::setfill('0') << key << extension;
+  return m_dir / name.str();
+}
+
+void BuildCache::write(const std::filesystem::path& path, const std::string& contents) const
+{
+  // Written aside and renamed, so that a reader never sees half a file
+  const std::filesystem::path temporary{ path.string() + ".tmp" + std::to_string(::getpid()) };
+  {
+    std::ofstream out(temporary, std::ios::binary);
+    out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    if (!out)
+    {
+      std::error_code ignored{};
+      std::filesystem::remove(temporary, ignored);
+      throw std::runtime_error("Unable to write cache file: " + temporary.string());
+    }
+  }
+  std::filesystem::rename(temporary, path);
+}
+
+// The VM code follows a comment line with the key
+std::optional<std::string> BuildCache::loadVM(uint64_t key) const
+{
+  if (m_dir.empty())
+    return std::nullopt;
+
+  std::optional<std::string> contents{ readFile(pathOf(key, ".vm")) };
+  const std::string line{ keyLine(key) };
+  if (!contents || !contents->starts_with(line))
+    return std::nullopt;
+  return contents->substr(line.size());
+}
+
+void BuildCache::saveVM(uint64_t key, const std::string& vmCode) const
+{
+  if (!m_dir.empty())
+    write(pathOf(key, ".vm"), keyLine(key) + vmCode);
+}
+
+std::optional<BuildCache::Unit> BuildCache::loadUnit(uint64_t key) const
+{
+  if (m_dir.empty())
+    return std::nullopt;
+
+  std::optional<std::string> contents{ readFile(pathOf(key, ".obj")) };
+  if (!contents || contents->size() < sizeof(ObjectHeader))
+    return std::nullopt;
+  const std::string& bytes{ *contents };
+
+  ObjectHeader header{};
+  std::memcpy(&header, bytes.data(), sizeof header);
+  if (std::memcmp(header.magic, objectMagic, sizeof objectMagic) != 0 || header.version != version ||
+      header.key != key)
+    return std::nullopt;
+
+  const size_t wordsOffset{ sizeof(ObjectHeader) };
+  const size_t labelsOffset{ wordsOffset + size_t{ header.nWords } * sizeof(uint16_t) };
+  const size_t fixupsOffset{ labelsOffset + size_t{ header.nLabels } * sizeof(ObjectName) };
+  const size_t aritiesOffset{ fixupsOffset + size_t{ header.nFixups } * sizeof(ObjectName) };
+  const size_t namesOffset{ aritiesOffset + size_t{ header.nArities } * sizeof(int32_t) };
+  if (namesOffset + header.nNameBytes != bytes.size())
+    return std::nullopt;
+
+  const std::string_view names{ bytes.data() + namesOffset, header.nNameBytes };
+  auto readName = [&](size_t offset, ObjectName& name)
+  {
+    std::memcpy(&name, bytes.data() + offset, sizeof name);
+    return size_t{ name.offset } + name.length <= names.size();
+  };
+
+  Unit unit{};
+  unit.definesSysInit = header.definesSysInit != 0;
+  unit.object.words.resize(header.nWords);
+  std::memcpy(unit.object.words.data(), bytes.data() + wordsOffset, header.nWords * sizeof(uint16_t));
+
+  for (uint32_t i = 0; i < header.nLabels; i++)
+  {
+    ObjectName label{};
+    if (!readName(labelsOffset + i * sizeof(ObjectName), label))
+      return std::nullopt;
+    unit.object.labels.emplace_back(std::string(names.substr(label.offset, label.length)), label.value);
+  }
+  for (uint32_t i = 0; i < header.nFixups; i++)
+  {
+    ObjectName fixup{};
+    if (!readName(fixupsOffset + i * sizeof(ObjectName), fixup) || fixup.value >= header.nWords)
+      return std::nullopt;
+    unit.object.fixups.push_back({ fixup.value, std::string(names.substr(fixup.offset, fixup.length)) });
+  }
+  for (uint32_t i = 0; i < header.nArities; i++)
+  {
+    int32_t arity{ 0 };
+    std::memcpy(&arity, bytes.data() + aritiesOffset + i * sizeof(int32_t), sizeof arity);
+    unit.callArities.insert(arity);
+  }
+
+  return unit;
+}
+
+void BuildCache::saveUnit(uint64_t key, const Unit& unit) const
+{
+  if (m_dir.empty())
+    return;
+
+  std::string names{};
+  std::vector<ObjectName> labels{};
+  std::vector<ObjectName> fixups{};
+  for (const auto& [name, address] : unit.object.labels)
+  {
+    labels.push_back({ static_cast<uint32_t>(names.size()), static_cast<uint32_t>(name.size()),
+                       static_cast<uint32_t>(address) });
+    names += name;
+  }
+  for (const auto& fixup : unit.object.fixups)
+  {
+    fixups.push_back({ static_cast<uint32_t>(names.size()), static_cast<uint32_t>(fixup.symbol.size()),
+                       static_cast<uint32_t>(fixup.word) });
+    names += fixup.symbol;
+  }
+
+  ObjectHeader header{};
+  std::memcpy(header.magic, objectMagic, sizeof objectMagic);
+  header.version = version;
+  header.definesSysInit = unit.definesSysInit ? 1 : 0;
+  header.key = key;
+  header.nWords = static_cast<uint32_t>(unit.object.words.size());
+  header.nLabels = static_cast<uint32_t>(labels.size());
+  header.nFixups = static_cast<uint32_t>(fixups.size());
+  header.nArities = static_cast<uint32_t>(unit.callArities.size());
+  header.nNameBytes = static_cast<uint32_t>(names.size());
+
+  std::string bytes{};
+  append(bytes, header);
+  bytes.append(reinterpret_cast<const char*>(unit.object.words.data()), unit.object.words.size() * sizeof(uint16_t));
+  for (const auto& label : labels)
+    append(bytes, label);
+  for (const auto& fixup : fixups)
+    append(bytes, fixup);
+  for (int arity : unit.callArities)
+    append(bytes, static_cast<int32_t>(arity));
+  bytes += names;
+
+  write(pathOf(key, ".obj"), bytes);
+}
\ No newline at end of file
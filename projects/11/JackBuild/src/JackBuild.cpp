@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include "HackAssembler.h"
+#include "InputFiles.h"
+#include "JackBuild.h"
+#include "JackStage.h"
+#include "Translator.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  std::string readSource(const fs::path& path)
+  {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+      throw std::runtime_error("Unable to open file: " + path.string());
+    std::ostringstream contents{};
+    contents << in.rdbuf();
+    return contents.str();
+  }
+
+  bool isInside(const fs::path& path, const fs::path& dir)
+  {
+    if (dir.empty())
+      return false;
+    const fs::path relative{ path.lexically_relative(dir) };
+    return !relative.empty() && *relative.begin() != "..";
+  }
+
+  bool definesSysInit(const VMProgram& program)
+  {
+    return std::any_of(program.begin(), program.end(), [](const VMFile& file)
+    {
+      return std::any_of(file.commands.begin(), file.commands.end(), [](const VMCommand& command)
+      {
+        return command.type == CommandType::C_FUNCTION && command.arg1 == "Sys.init";
+      });
+    });
+  }
+}
+
+JackBuild::JackBuild(const BuildOptions& options)
+  : m_options{ options },
+    m_cache{ options.cacheDir.empty() ? BuildCache{} : BuildCache{ options.cacheDir } }
+{
+}
+
+void JackBuild::addSource(const fs::path& path)
+{
+  const std::string className{ path.stem().string() };
+  auto sameClass = [&](const Source& source) { return source.className == className; };
+  if (std::any_of(m_sources.begin(), m_sources.end(), sameClass))
+    throw std::invalid_argument("Class " + className + " is defined twice: " + path.string());
+
+  m_sources.push_back({ className, path, path.extension() == ".jack", readSource(path), {} });
+}
+
+// .jack files, then .vm files of the classes they do not define (a
+// directory built by the JackCompiler before), then the OS classes the
+// program does not define; each group in path order
+void JackBuild::collect(const fs::path& input)
+{
+  if (fs::is_regular_file(input))
+  {
+    if (input.extension() != ".jack")
+      throw std::invalid_argument("Not a .jack file: " + input.string());
+    addSource(input);
+  }
+  else if (fs::is_directory(input))
+  {
+    const fs::path skipDir{ fs::weakly_canonical(m_options.skipDir) };
+    const fs::path cacheDir{ fs::weakly_canonical(m_options.cacheDir) };
+    std::vector<fs::path> jackFiles{};
+    std::vector<fs::path> vmFiles{};
+    for (const auto& entry : fs::recursive_directory_iterator(input, fs::directory_options::skip_permission_denied))
+    {
+      const fs::path path{ fs::weakly_canonical(entry.path()) };
+      if (!entry.is_regular_file() || isInside(path, skipDir) || isInside(path, cacheDir))
+        continue;
+      if (entry.path().extension() == ".jack")
+        jackFiles.push_back(entry.path());
+      else if (entry.path().extension() == ".vm")
+        vmFiles.push_back(entry.path());
+    }
+    if (jackFiles.empty() && vmFiles.empty())
+      throw std::invalid_argument("No .jack or .vm files in directory (recursively): " + input.string());
+
+    auto byPath = [](const fs::path& a, const fs::path& b) { return a.generic_string() < b.generic_string(); };
+    std::sort(jackFiles.begin(), jackFiles.end(), byPath);
+    std::sort(vmFiles.begin(), vmFiles.end(), byPath);
+    for (const auto& path : jackFiles)
+      addSource(path);
+
+    const size_t nJack{ m_sources.size() };
+    for (const auto& path : vmFiles)
+    {
+      const std::string className{ path.stem().string() };
+      if (std::none_of(m_sources.begin(), m_sources.begin() + static_cast<std::ptrdiff_t>(nJack),
+                       [&](const Source& source) { return source.className == className; }))
+        addSource(path);
+    }
+  }
+  else
+  {
+    throw std::invalid_argument("Unable to access path: " + input.string());
+  }
+
+  if (m_options.osDir.empty())
+    return;
+
+  std::vector<fs::path> osFiles{};
+  for (const auto& entry : fs::directory_iterator(m_options.osDir))
+  {
+    if (entry.is_regular_file() && entry.path().extension() == ".vm")
+      osFiles.push_back(entry.path());
+  }
+  std::sort(osFiles.begin(), osFiles.end());
+  for (const auto& path : osFiles)
+  {
+    const std::string className{ path.stem().string() };
+    if (std::none_of(m_sources.begin(), m_sources.end(),
+                     [&](const Source& source) { return source.className == className; }))
+      addSource(path);
+  }
+}
+
+// Same work queue as Translator::forEachFile, on at most m_options.jobs
+// threads; the first error, in source order, is rethrown
+void JackBuild::forEachSource(const std::function<void(size_t)>& task) const
+{
+  const size_t nSources{ m_sources.size() };
+  std::vector<std::exception_ptr> errors(nSources);
+  std::atomic<size_t> nextSource{ 0 };
+
+  auto worker = [&]()
+  {
+    for (size_t i{ nextSource++ }; i < nSources; i = nextSource++)
+    {
+      try
+      {
+        task(i);
+      }
+      catch (...)
+      {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+
+  const unsigned jobs{ m_options.jobs > 0 ? m_options.jobs : std::max(std::thread::hardware_concurrency(), 1u) };
+  const size_t nWorkers{ std::min<size_t>(jobs, nSources) };
+  std::vector<std::thread> workers{};
+  for (size_t i = 1; i < nWorkers; i++)
+  {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto& t : workers)
+  {
+    t.join();
+  }
+
+  for (const auto& error : errors)
+  {
+    if (error)
+      std::rethrow_exception(error);
+  }
+}
+
+void JackBuild::compileJack(Report& report)
+{
+  const std::string compilerVersion{ std::to_string(JackStage::version) };
+  std::atomic<size_t> compiled{ 0 };
+  forEachSource([&](size_t i)
+  {
+    Source& source{ m_sources[i] };
+    if (!source.isJack)
+    {
+      source.vmCode = source.text;
+      return;
+    }
+
+    const uint64_t key{ BuildCache::key({ "jack", compilerVersion, source.className, source.text }) };
+    if (auto cached{ m_cache.loadVM(key) })
+    {
+      source.vmCode = std::move(*cached);
+      return;
+    }
+    source.vmCode = JackStage::compile(source.className, source.text);
+    m_cache.saveVM(key, source.vmCode);
+    compiled++;
+  });
+  report.compiled = compiled;
+}
+
+std::vector<uint16_t> JackBuild::linkSeparately(Report& report)
+{
+  InputFiles noFiles{};
+  std::ostringstream unused{};
+  const Translator translator(noFiles, unused, { OutputFormat::HACK, m_options.level });
+  const std::string level{ std::to_string(static_cast<int>(m_options.level)) };
+  const std::string codeVersion{ std::to_string(Translator::codeVersion) };
+
+  std::vector<BuildCache::Unit> units(m_sources.size());
+  std::atomic<size_t> translated{ 0 };
+  forEachSource([&](size_t i)
+  {
+    const Source& source{ m_sources[i] };
+    const uint64_t key{ BuildCache::key({ "unit", codeVersion, level, source.className, source.vmCode }) };
+    if (auto cached{ m_cache.loadUnit(key) })
+    {
+      units[i] = std::move(*cached);
+      return;
+    }
+
+    std::istringstream input{ source.vmCode };
+    VMProgram program{ Translator::parseStream(input) };
+    if (program.size() == 1)
+      program[0].fileName = source.className;
+
+    BuildCache::Unit& unit{ units[i] };
+    for (const auto& vmFile : program)
+      translator.translateFile(vmFile, unit.object, unit.callArities);
+    unit.definesSysInit = definesSysInit(program);
+    m_cache.saveUnit(key, unit);
+    translated++;
+  });
+  report.translated = translated;
+
+  std::set<int> callArities{};
+  bool callSysInit{ false };
+  for (const auto& unit : units)
+  {
+    callArities.insert(unit.callArities.begin(), unit.callArities.end());
+    callSysInit = callSysInit || unit.definesSysInit;
+  }
+
+  std::vector<HackAssembler::Object> objects(1);
+  objects.reserve(units.size() + 1);
+  translator.writeSeparateBootstrap(callArities, callSysInit, objects[0]);
+  for (auto& unit : units)
+    objects.push_back(std::move(unit.object));
+
+  return HackAssembler::link(objects);
+}
+
+// -O2 inlines and allocates across classes, so nothing below the VM code
+// can be kept per class
+std::vector<uint16_t> JackBuild::translateWhole() const
+{
+  std::string vmCode{};
+  for (const auto& source : m_sources)
+  {
+    vmCode += source.vmCode;
+    vmCode += '\n';
+  }
+
+  InputFiles noFiles{};
+  std::ostringstream unused{};
+  std::istringstream input{ vmCode };
+  return Translator(noFiles, unused, { OutputFormat::HACK, m_options.level }).translateToWords(input);
+}
+
+JackBuild::Report JackBuild::build(const fs::path& input, std::ostream& hackOut)
+{
+  m_sources.clear();
+  collect(input);
+
+  Report report{};
+  report.classes = m_sources.size();
+  compileJack(report);
+
+  const std::vector<uint16_t> words{ m_options.level == OptimizationLevel::O2 ? translateWhole()
+                                                                               : linkSeparately(report) };
+  report.words = words.size();
+  HackAssembler::writeText(words, hackOut);
+  return report;
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#include <string>
+#include "compiler/JackCompiler.h"
+#include "JackStage.h"
+
+std::string JackStage::compile(const std::string& className, const std::string& source)
+{
+  return JackCompiler::compileSource(className, source);
+}
\ No newline at end of file
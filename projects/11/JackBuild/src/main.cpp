@@ -0,0 +1,126 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <filesystem>
+#include "JackBuild.h"
+
+namespace fs = std::filesystem;
+
+int main(int argc, char* argv[])
+{
+  // -O0 / -O1 / -O2: code generation strategy of the translator
+  // --os: directory of the OS .vm files linked with the program
+  // --cache: directory of the build cache (default <dir>/out/cache)
+  // --no-cache: build everything again and keep nothing
+  // --jobs: classes built at the same time (default one per core)
+  // -o: output file (default <dir>/out/<dir>.hack)
+  BuildOptions options{};
+  std::string inputPath{};
+  std::string outputPath{};
+  std::string cachePath{};
+  bool useCache{ true };
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg{ argv[i] };
+    bool hasValue{ i + 1 < argc };
+    if (arg == "-O0" || arg == "-O1" || arg == "-O2")
+    {
+      options.level = (arg == "-O0") ? OptimizationLevel::O0 :
+                      (arg == "-O1") ? OptimizationLevel::O1 : OptimizationLevel::O2;
+    }
+    else if (arg == "--os" && hasValue)
+    {
+      options.osDir = argv[++i];
+    }
+    else if (arg == "--cache" && hasValue)
+    {
+      cachePath = argv[++i];
+    }
+    else if (arg == "--no-cache")
+    {
+      useCache = false;
+    }
+    else if (arg == "--jobs" && hasValue)
+    {
+      options.jobs = static_cast<unsigned>(std::stoul(argv[++i]));
+    }
+    else if (arg == "-o" && hasValue)
+    {
+      outputPath = argv[++i];
+    }
+    else if (arg.starts_with("-"))
+    {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return 1;
+    }
+    else if (inputPath.empty())
+    {
+      inputPath = arg;
+    }
+    else
+    {
+      inputPath.clear();
+      break;
+    }
+  }
+
+  if (inputPath.empty())
+  {
+    std::cerr << "Usage: JackBuild [-O0 | -O1 | -O2] [--os dir] [--cache dir | --no-cache] [--jobs N] [-o file.hack] <directory | file.jack>" << std::endl;
+    return 1;
+  }
+
+  fs::path inPath(inputPath);
+  if (!fs::exists(inPath))
+  {
+    std::cerr << "Unable to access path: " << inPath << std::endl;
+    return 1;
+  }
+
+  // Output next to the JackCompiler's: <dir>/out, or out beside the file
+  const bool isDirectory{ fs::is_directory(inPath) };
+  const fs::path baseDir{ isDirectory ? inPath : inPath.parent_path() };
+  const fs::path outputDir{ baseDir / "out" };
+  const std::string programName{ isDirectory
+    ? (inPath.has_filename() ? inPath.filename() : inPath.parent_path().filename()).string()
+    : inPath.stem().string() };
+
+  options.skipDir = outputDir;
+  if (useCache)
+    options.cacheDir = cachePath.empty() ? outputDir / "cache" : fs::path(cachePath);
+  if (outputPath.empty())
+  {
+    fs::create_directories(outputDir);
+    outputPath = (outputDir / (programName + ".hack")).string();
+  }
+
+  std::ofstream outputFile(outputPath);
+  if (!outputFile)
+  {
+    std::cerr << "Unable to create output file: " << outputPath << std::endl;
+    return 1;
+  }
+
+  try
+  {
+    const auto start{ std::chrono::steady_clock::now() };
+    JackBuild::Report report{ JackBuild(options).build(inPath, outputFile) };
+    const auto elapsed{ std::chrono::steady_clock::now() - start };
+
+    std::cout << "Build completed: " << report.classes << " classes ("
+              << report.compiled << " compiled, " << report.translated << " translated), "
+              << report.words << " words in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << " ms" << std::endl;
+    std::cout << "Output written to: " << outputPath << std::endl;
+  }
+  catch (const std::exception& e)
+  {
+    outputFile.close();
+    fs::remove(outputPath);
+    std::cerr << "Build failed:\n  " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define COMPILATION_ENGINE_H
 
 #include <fstream>
+#include <istream>
+#include <ostream>
 #include <string>
 #include <initializer_list>
 #include "utils/InputFile.h"
@@ -81,6 +83,7 @@ private:
   
 public:
   CompilationEngine(InputFile& inputFile, std::ofstream& outputFile);
+  CompilationEngine(const std::string& fileName, std::istream& input, std::ostream& output);
 
   void compile();
 };
@@ -17,6 +17,9 @@ public:
   JackCompiler(InputFiles& inputFiles, fs::path& outputDir);
 
   void compile();
+
+  // VM code of one class from its source in memory, for build tools
+  static std::string compileSource(const std::string& fileName, const std::string& source);
 };
 
 #endif
\ No newline at end of file
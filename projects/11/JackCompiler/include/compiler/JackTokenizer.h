@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <fstream>
+#include <istream>
 #include <string>
 #include "utils/TokenType.h"
 #include "utils/KeyWords.h"
@@ -23,10 +24,11 @@ private:
   int m_currentTokenIndex{ -1 };
   Token m_currentToken{};
   
-  std::vector<Token> tokenizeFile(std::ifstream& file) const;
+  std::vector<Token> tokenizeFile(std::istream& file) const;
 
 public:
   JackTokenizer(InputFile& inputFile);
+  JackTokenizer(const std::string& fileName, std::istream& input);
 
   bool hasMoreTokens() const noexcept;
   void advance() noexcept;
@@ -14,9 +14,14 @@
 #include "compiler/CompilationEngine.h"
 
 CompilationEngine::CompilationEngine(InputFile& inputFile, std::ofstream& outputFile)
-  : m_fileName(inputFile.fileName + ".jack")
-  , m_writer(outputFile)
-  , m_tokenizer(inputFile)
+  : CompilationEngine(inputFile.fileName, inputFile.file, outputFile)
+{
+}
+
+CompilationEngine::CompilationEngine(const std::string& fileName, std::istream& input, std::ostream& output)
+  : m_fileName(fileName + ".jack")
+  , m_writer(output)
+  , m_tokenizer(fileName, input)
   , m_symbolTable()
 {
 }
@@ -1,6 +1,7 @@
 #include <string>
 #include <filesystem>
 #include <iostream>
+#include <sstream>
 #include "utils/InputFile.h"
 #include "compiler/CompilationEngine.h"
 #include "compiler/JackCompiler.h"
@@ -37,3 +38,14 @@ void JackCompiler::compile()
     std::cout << inputFile.fileName << ".jack: " << "Compiled\n";
   }
 }
+
+std::string JackCompiler::compileSource(const std::string& fileName, const std::string& source)
+{
+  std::istringstream input(source);
+  std::ostringstream output{};
+
+  CompilationEngine compilationEngine(fileName, input, output);
+  compilationEngine.compile();
+
+  return output.str();
+}
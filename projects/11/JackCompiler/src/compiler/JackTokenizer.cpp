@@ -10,14 +10,19 @@
 #include "compiler/JackTokenizer.h"
 
 JackTokenizer::JackTokenizer(InputFile& inputFile)
-  : m_fileName(inputFile.fileName + ".jack")
-  , m_tokenizedFile(tokenizeFile(inputFile.file))
+  : JackTokenizer(inputFile.fileName, inputFile.file)
+{
+}
+
+JackTokenizer::JackTokenizer(const std::string& fileName, std::istream& input)
+  : m_fileName(fileName + ".jack")
+  , m_tokenizedFile(tokenizeFile(input))
   , m_hasMoreTokens(!m_tokenizedFile.empty())
   , m_currentTokenIndex(-1)
 {
 }
 
-std::vector<JackTokenizer::Token> JackTokenizer::tokenizeFile(std::ifstream& file) const
+std::vector<JackTokenizer::Token> JackTokenizer::tokenizeFile(std::istream& file) const
 {
   std::vector<JackTokenizer::Token> tokenizedFile;
   std::string line{};
@@ -0,0 +1,132 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include "OutputBuffer.h"
+
+// Emits the same push/pop/add stream the code writers produce for a large
+// program, once the old way (std::string concatenation + operator<< on the
+// ofstream per command) and once through OutputBuffer, and compares the
+// throughput of the two. Both outputs must be identical.
+
+namespace
+{
+  constexpr int nCommands{ 2'000'000 };
+
+  // "@" + std::to_string(index) draws a false -Wrestrict warning from
+  // GCC 12, hence the first two pieces appended
+  std::string oldPush(const std::string& base, int index)
+  {
+    std::string code{ "@" };
+    code += std::to_string(index);
+    return std::move(code) +
+      "\n"
+      "D=A\n"
+      "@" + base + "\n"
+      "A=D+M\n"
+      "D=M\n"
+      "@SP\n"
+      "AM=M+1\n"
+      "A=A-1\n"
+      "M=D\n";
+  }
+
+  std::string oldPop(const std::string& fileName, int index)
+  {
+    return
+      "@" + fileName + "." + std::to_string(index) + "\n"
+      "D=A\n"
+      "@R13\n"
+      "M=D\n"
+      "@SP\n"
+      "AM=M-1\n"
+      "D=M\n"
+      "@R13\n"
+      "A=M\n"
+      "M=D\n";
+  }
+
+  void newPush(OutputBuffer& out, const std::string& base, int index)
+  {
+    out << "@" << index << "\n"
+      "D=A\n"
+      "@" << base << "\n"
+      "A=D+M\n"
+      "D=M\n"
+      "@SP\n"
+      "AM=M+1\n"
+      "A=A-1\n"
+      "M=D\n";
+  }
+
+  void newPop(OutputBuffer& out, const std::string& fileName, int index)
+  {
+    out << "@" << fileName << "." << index << "\n"
+      "D=A\n"
+      "@R13\n"
+      "M=D\n"
+      "@SP\n"
+      "AM=M-1\n"
+      "D=M\n"
+      "@R13\n"
+      "A=M\n"
+      "M=D\n";
+  }
+
+  template <typename F>
+  double seconds(F&& f)
+  {
+    auto start{ std::chrono::steady_clock::now() };
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  const std::string oldPath{ argc > 1 ? std::string(argv[1]) + ".old" : "OutputBufferBench.old.asm" };
+  const std::string newPath{ argc > 1 ? std::string(argv[1]) + ".new" : "OutputBufferBench.new.asm" };
+  const std::string fileName{ "Main" };
+
+  double oldTime{ seconds([&]() {
+    std::ofstream out(oldPath);
+    for (int i = 0; i < nCommands; i++)
+    {
+      out << oldPush("LCL", i % 32);
+      out << oldPop(fileName, i % 7);
+    }
+  }) };
+
+  double newTime{ seconds([&]() {
+    std::ofstream out(newPath);
+    OutputBuffer buffer(out);
+    for (int i = 0; i < nCommands; i++)
+    {
+      newPush(buffer, "LCL", i % 32);
+      newPop(buffer, fileName, i % 7);
+    }
+    buffer.flush();
+  }) };
+
+  std::ifstream oldFile(oldPath, std::ios::binary);
+  std::ifstream newFile(newPath, std::ios::binary);
+  std::stringstream oldText, newText;
+  oldText << oldFile.rdbuf();
+  newText << newFile.rdbuf();
+  bool identical{ oldText.str() == newText.str() };
+  double megabytes{ static_cast<double>(newText.str().size()) / (1024.0 * 1024.0) };
+
+  std::remove(oldPath.c_str());
+  std::remove(newPath.c_str());
+
+  std::cout << "output size:       " << megabytes << " MiB\n"
+            << "string + ofstream: " << oldTime << " s (" << megabytes / oldTime << " MiB/s)\n"
+            << "OutputBuffer:      " << newTime << " s (" << megabytes / newTime << " MiB/s)\n"
+            << "speedup:           " << oldTime / newTime << "x\n"
+            << "identical output:  " << (identical ? "yes" : "NO") << std::endl;
+
+  return identical ? 0 : 1;
+}
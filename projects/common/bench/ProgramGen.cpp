@@ -0,0 +1,946 @@
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Random program generator, for fuzzing and benchmarking the toolchain.
+//
+//   ProgramGen [options] out-dir
+//
+//   --vm              raw VM code (Sys.vm plus one file per class, no OS)
+//                     instead of Jack classes
+//   --seed N          seed of the program (default 1)
+//   --count N         write N programs to out-dir/0 ... out-dir/N-1, the
+//                     i-th with the seed plus i; without it one, in out-dir
+//   --classes N       classes per program, besides Main or Sys (default 3)
+//   --subroutines N   functions and methods per class (default 4)
+//   --statements N    statements per subroutine body, nested ones
+//                     included (default 6)
+//   --levels N        depth of the call graph (default 3)
+//   --mask-compares   mask the operands of < and > (gt and lt) to 14 bits,
+//                     out of reach of the translator's overflow bug below
+//
+// Jack programs are valid for the JackCompiler: every name is declared
+// once per scope, fields are only used in methods and constructors, method
+// calls without an object only appear in methods, and values keep their
+// declared types. They need the OS (tools/OS) to run; Main.main calls every
+// function and method once and prints a checksum. VM programs keep the
+// stack balanced at every label and leave Sys.init in a final loop.
+// Either kind runs in VMDiff (Jack once compiled, with the OS files next to
+// it) and makes a corpus for TranslatorBench (--os for the Jack ones).
+//
+// Every program terminates: a subroutine only calls subroutines of a lower
+// level, every loop counts down from at most 3 a counter that its body
+// never writes, array indices are masked into the 8 elements every array
+// has, and divisors are positive constants. Objects and arrays are freed
+// before the subroutine that allocated them returns. Classes past the 240
+// static cells of the Hack RAM have no statics. The same seed gives the
+// same program everywhere (no <random> distributions), with or without
+// --mask-compares.
+//
+// The translator compares through x - y, which gives the other answer
+// when the subtraction overflows (20000 > -20000 is false): VMDiff reports
+// the first such comparison in a program as a divergence. --mask-compares
+// keeps the operands in 0..16383 so that the other bugs can be looked for.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  struct Options
+  {
+    bool vm{ false };
+    uint64_t seed{ 1 };
+    int count{ 0 };
+    int classes{ 3 };
+    int subroutines{ 4 };
+    int statements{ 6 };
+    int levels{ 3 };
+    bool maskCompares{ false };
+  };
+
+  constexpr int staticCells{ 240 };   // RAM[16..255], shared by all classes
+
+  // splitmix64
+  class Random
+  {
+  private:
+    uint64_t m_state;
+
+  public:
+    explicit Random(uint64_t seed) : m_state{ seed } {}
+
+    uint64_t next() noexcept
+    {
+      uint64_t z{ m_state += 0x9E3779B97F4A7C15ull };
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      return z ^ (z >> 31);
+    }
+
+    // In [lo, hi]
+    int between(int lo, int hi) noexcept
+    {
+      return lo + static_cast<int>(next() % static_cast<uint64_t>(hi - lo + 1));
+    }
+
+    bool chance(int percent) noexcept { return between(1, 100) <= percent; }
+
+    template <typename T>
+    const T& pick(const std::vector<T>& items) noexcept
+    {
+      return items[static_cast<size_t>(between(0, static_cast<int>(items.size()) - 1))];
+    }
+  };
+
+  // ------- JACK -------
+
+  enum class Type { INT, CHAR, BOOLEAN, ARRAY, OBJECT, VOID };
+
+  struct Var
+  {
+    std::string name{};
+    Type type{ Type::INT };
+    int cls{ -1 };          // class of OBJECT variables
+  };
+
+  struct Subroutine
+  {
+    std::string name{};
+    bool isMethod{ false };
+    Type returnType{ Type::VOID };
+    std::vector<Var> params{};
+    int level{ 1 };
+  };
+
+  struct Class
+  {
+    std::string name{};
+    std::vector<Var> fields{};
+    std::vector<Var> statics{};
+    bool hasData{ false };  // Array field "data", allocated by the constructor
+    std::vector<Subroutine> subroutines{};
+  };
+
+  std::string typeName(Type type, const std::vector<Class>& classes, int cls)
+  {
+    switch (type)
+    {
+      case Type::INT:     return "int";
+      case Type::CHAR:    return "char";
+      case Type::BOOLEAN: return "boolean";
+      case Type::ARRAY:   return "Array";
+      case Type::OBJECT:  return classes[static_cast<size_t>(cls)].name;
+      case Type::VOID:    return "void";
+    }
+    return "int"; // never
+  }
+
+  // GCC 12 warns (-Wrestrict) on "literal" + std::to_string(n)
+  template <typename T>
+  std::string numbered(std::string name, T n)
+  {
+    return name += std::to_string(n);
+  }
+
+  bool isNumeric(Type type) noexcept { return type == Type::INT || type == Type::CHAR; }
+
+  class JackGenerator
+  {
+  private:
+    // What the body being generated can see
+    struct Scope
+    {
+      int cls{ -1 };              // -1: Main
+      bool inMethod{ false };
+      int level{ 0 };
+      std::vector<Var> assignable{};
+      std::vector<Var> readable{}; // assignable plus loop counters
+      std::vector<Var> arrays{};
+      std::vector<Var> objects{};
+      bool hasString{ false };
+      int loopDepth{ 0 };
+    };
+
+    static constexpr int maxLoopDepth{ 2 };
+    static constexpr int maxExprDepth{ 3 };
+
+    const Options& m_options;
+    Random m_random;
+    std::vector<Class> m_classes{};
+    int m_budget{ 0 };
+
+    Type scalarType() noexcept
+    {
+      int r{ m_random.between(0, 9) };
+      return r < 6 ? Type::INT : (r < 8 ? Type::BOOLEAN : Type::CHAR);
+    }
+
+    void declareClasses();
+    std::string intConstant();
+    std::string term(Type type, const Scope& scope, int depth);
+    std::string expression(Type type, const Scope& scope, int depth);
+    bool call(Type type, const Scope& scope, int depth, std::string& text);
+    std::string arguments(const Subroutine& sub, const Scope& scope, int depth, bool& ok);
+    void statements(Scope& scope, const std::string& indent, std::ostream& out);
+    void statement(Scope& scope, const std::string& indent, std::ostream& out);
+    void writeSubroutine(const Class& cls, int clsIndex, const Subroutine& sub, std::ostream& out);
+    void writeConstructor(const Class& cls, std::ostream& out);
+    void writeMain(std::ostream& out);
+
+  public:
+    JackGenerator(const Options& options, uint64_t seed)
+      : m_options{ options }
+      , m_random{ seed }
+    {
+    }
+
+    void write(const fs::path& dir);
+  };
+
+  void JackGenerator::declareClasses()
+  {
+    m_classes.resize(static_cast<size_t>(m_options.classes));
+    for (size_t k = 0; k < m_classes.size(); k++)
+      m_classes[k].name = numbered("C", k);
+
+    int staticsLeft{ staticCells };
+    for (auto& cls : m_classes)
+    {
+      int nFields{ m_random.between(1, 4) };
+      for (int j = 0; j < nFields; j++)
+        cls.fields.push_back({ numbered("fld", j), scalarType(), -1 });
+      int nStatics{ std::min(m_random.between(1, 3), staticsLeft) };
+      staticsLeft -= nStatics;
+      for (int j = 0; j < nStatics; j++)
+        cls.statics.push_back({ numbered("st", j), scalarType(), -1 });
+      cls.hasData = m_random.chance(50);
+
+      for (int j = 0; j < m_options.subroutines; j++)
+      {
+        Subroutine sub{};
+        sub.isMethod = m_random.chance(50);
+        sub.name = numbered(sub.isMethod ? "m" : "f", j);
+        sub.returnType = m_random.chance(25) ? Type::VOID : scalarType();
+        sub.level = m_random.between(1, m_options.levels);
+        int nParams{ m_random.between(0, 3) };
+        for (int p = 0; p < nParams; p++)
+          sub.params.push_back({ numbered("a", p), m_random.chance(15) ? Type::ARRAY : scalarType(), -1 });
+        cls.subroutines.push_back(std::move(sub));
+      }
+    }
+  }
+
+  std::string JackGenerator::intConstant()
+  {
+    return std::to_string(m_random.chance(80) ? m_random.between(0, 100) : m_random.between(0, 32767));
+  }
+
+  // Appends the call of a subroutine the scope may call and that returns a
+  // value usable as type (VOID: any), if there is one
+  bool JackGenerator::call(Type type, const Scope& scope, int depth, std::string& text)
+  {
+    struct Candidate
+    {
+      const Subroutine* sub;
+      std::string prefix;
+    };
+    std::vector<Candidate> candidates{};
+
+    for (size_t k = 0; k < m_classes.size(); k++)
+    {
+      for (const auto& sub : m_classes[k].subroutines)
+      {
+        if (sub.level >= scope.level)
+          continue;
+        bool returns{ type == Type::VOID ||
+                      sub.returnType == type ||
+                      (isNumeric(type) && isNumeric(sub.returnType)) };
+        if (!returns)
+          continue;
+        if (!sub.isMethod)
+          candidates.push_back({ &sub, m_classes[k].name + "." });
+        else
+        {
+          if (scope.inMethod && static_cast<size_t>(scope.cls) == k)
+            candidates.push_back({ &sub, "" });
+          for (const auto& obj : scope.objects)
+            if (static_cast<size_t>(obj.cls) == k)
+              candidates.push_back({ &sub, obj.name + "." });
+        }
+      }
+    }
+    if (candidates.empty())
+      return false;
+
+    const Candidate& chosen{ m_random.pick(candidates) };
+    bool ok{ true };
+    std::string args{ arguments(*chosen.sub, scope, depth, ok) };
+    if (!ok)
+      return false;
+    text += chosen.prefix + chosen.sub->name + "(" + args + ")";
+    return true;
+  }
+
+  std::string JackGenerator::arguments(const Subroutine& sub, const Scope& scope, int depth, bool& ok)
+  {
+    std::string args{};
+    for (size_t p = 0; p < sub.params.size(); p++)
+    {
+      if (p > 0)
+        args += ", ";
+      if (sub.params[p].type == Type::ARRAY)
+      {
+        if (scope.arrays.empty())
+        {
+          ok = false;
+          return "";
+        }
+        args += m_random.pick(scope.arrays).name;
+      }
+      else
+        args += expression(sub.params[p].type, scope, depth + 1);
+    }
+    return args;
+  }
+
+  std::string JackGenerator::term(Type type, const Scope& scope, int depth)
+  {
+    bool leaf{ depth >= maxExprDepth };
+    std::vector<Var> vars{};
+    for (const auto& var : scope.readable)
+      if (var.type == type || (isNumeric(type) && isNumeric(var.type)))
+        vars.push_back(var);
+
+    for (int attempt = 0; attempt < 4; attempt++)
+    {
+      int r{ m_random.between(0, leaf ? 1 : 6) };
+      if (r == 0)
+      {
+        if (type == Type::BOOLEAN)
+          return m_random.chance(50) ? "true" : "false";
+        return intConstant();
+      }
+      if (r == 1 && !vars.empty())
+        return m_random.pick(vars).name;
+      if (r == 2)
+      {
+        std::string text{};
+        if (call(type, scope, depth, text))
+          return text;
+      }
+      if (r == 3)
+      {
+        if (type == Type::BOOLEAN)
+          return "~" + term(type, scope, depth + 1);
+        return "-" + term(type, scope, depth + 1);
+      }
+      if (r == 4 && isNumeric(type) && !scope.arrays.empty())
+        return m_random.pick(scope.arrays).name + "[(" + expression(Type::INT, scope, depth + 1) + ") & 7]";
+      if (r >= 5)
+      {
+        if (type == Type::BOOLEAN && m_random.chance(60))
+        {
+          if (m_random.chance(30))
+            return "(" + expression(Type::INT, scope, depth + 1) + " = " + term(Type::INT, scope, depth + 1) + ")";
+          const std::string mask{ m_options.maskCompares ? " & 16383" : "" };
+          return "((" + expression(Type::INT, scope, depth + 1) + ")" + mask + (m_random.chance(50) ? " < " : " > ") +
+                 "(" + term(Type::INT, scope, depth + 1) + mask + "))";
+        }
+        return "(" + expression(type, scope, depth + 1) + ")";
+      }
+    }
+    return type == Type::BOOLEAN ? "false" : intConstant();
+  }
+
+  // Jack has no precedence: operators apply left to right
+  std::string JackGenerator::expression(Type type, const Scope& scope, int depth)
+  {
+    std::string text{ term(type, scope, depth) };
+    int nOps{ depth >= maxExprDepth ? 0 : m_random.between(0, 2) };
+    for (int j = 0; j < nOps; j++)
+    {
+      if (type == Type::BOOLEAN)
+        text += (m_random.chance(50) ? " & " : " | ") + term(type, scope, depth + 1);
+      else
+      {
+        static const char* ops[]{ " + ", " - ", " * ", " & ", " | " };
+        int op{ m_random.between(0, 5) };
+        if (op == 5)
+          text += " / " + std::to_string(m_random.between(1, 100));
+        else
+          text += ops[op] + term(type, scope, depth + 1);
+      }
+    }
+    return text;
+  }
+
+  void JackGenerator::statements(Scope& scope, const std::string& indent, std::ostream& out)
+  {
+    int n{ m_random.between(1, 3) };
+    for (int j = 0; j < n && m_budget > 0; j++)
+      statement(scope, indent, out);
+  }
+
+  void JackGenerator::statement(Scope& scope, const std::string& indent, std::ostream& out)
+  {
+    m_budget--;
+    int r{ m_random.between(0, 11) };
+
+    if (r <= 3 && !scope.assignable.empty())
+    {
+      const Var& var{ m_random.pick(scope.assignable) };
+      out << indent << "let " << var.name << " = " << expression(var.type, scope, 0) << ";\n";
+    }
+    else if (r == 4 && !scope.arrays.empty())
+    {
+      out << indent << "let " << m_random.pick(scope.arrays).name << "[(" << expression(Type::INT, scope, 1)
+          << ") & 7] = " << expression(Type::INT, scope, 0) << ";\n";
+    }
+    else if (r <= 6)
+    {
+      out << indent << "if (" << expression(Type::BOOLEAN, scope, 0) << ") {\n";
+      statements(scope, indent + "  ", out);
+      if (m_random.chance(50))
+      {
+        out << indent << "}\n" << indent << "else {\n";
+        statements(scope, indent + "  ", out);
+      }
+      out << indent << "}\n";
+    }
+    else if (r == 7 && scope.loopDepth < maxLoopDepth)
+    {
+      std::string counter{ numbered("i", scope.loopDepth) };
+      out << indent << "let " << counter << " = " << m_random.between(1, 3) << ";\n"
+          << indent << "while (" << counter << " > 0) {\n";
+      scope.loopDepth++;
+      statements(scope, indent + "  ", out);
+      scope.loopDepth--;
+      out << indent << "  let " << counter << " = " << counter << " - 1;\n"
+          << indent << "}\n";
+    }
+    else if (r == 8 && scope.hasString && !scope.assignable.empty())
+    {
+      // A String only lives within the statements that use it
+      std::string text{};
+      int length{ m_random.between(1, 8) };
+      for (int j = 0; j < length; j++)
+        text += static_cast<char>(m_random.chance(15) ? ' ' : 'a' + m_random.between(0, 25));
+      Var var{ m_random.pick(scope.assignable) };
+      out << indent << "let str = \"" << text << "\";\n";
+      if (isNumeric(var.type))
+        out << indent << "let " << var.name << " = str.length() + str.charAt(" << m_random.between(0, length - 1) << ");\n";
+      out << indent << "do str.dispose();\n";
+    }
+    else
+    {
+      std::string text{};
+      if (call(Type::VOID, scope, 0, text))
+        out << indent << "do " << text << ";\n";
+    }
+  }
+
+  void JackGenerator::writeConstructor(const Class& cls, std::ostream& out)
+  {
+    out << "  constructor " << cls.name << " new(";
+    for (size_t j = 0; j < cls.fields.size(); j++)
+      out << (j > 0 ? ", " : "") << typeName(cls.fields[j].type, m_classes, -1) << " a" << j;
+    out << ") {\n";
+    for (size_t j = 0; j < cls.fields.size(); j++)
+      out << "    let " << cls.fields[j].name << " = a" << j << ";\n";
+    if (cls.hasData)
+    {
+      out << "    let data = Array.new(8);\n";
+      for (int j = 0; j < 8; j++)
+        out << "    let data[" << j << "] = " << intConstant() << ";\n";
+    }
+    out << "    return this;\n  }\n\n";
+
+    out << "  method void dispose() {\n";
+    if (cls.hasData)
+      out << "    do data.dispose();\n";
+    out << "    do Memory.deAlloc(this);\n    return;\n  }\n";
+  }
+
+  // Locals are set before the body, so that every read sees a value;
+  // arrays and objects are freed after the return value is computed
+  void JackGenerator::writeSubroutine(const Class& cls, int clsIndex, const Subroutine& sub, std::ostream& out)
+  {
+    out << "\n  " << (sub.isMethod ? "method " : "function ")
+        << typeName(sub.returnType, m_classes, -1) << " " << sub.name << "(";
+    for (size_t p = 0; p < sub.params.size(); p++)
+      out << (p > 0 ? ", " : "") << typeName(sub.params[p].type, m_classes, -1) << " " << sub.params[p].name;
+    out << ") {\n";
+
+    Scope scope{};
+    scope.cls = clsIndex;
+    scope.inMethod = sub.isMethod;
+    scope.level = sub.level;
+
+    for (const auto& param : sub.params)
+      (param.type == Type::ARRAY ? scope.arrays : scope.assignable).push_back(param);
+    for (const auto& var : cls.statics)
+      scope.assignable.push_back(var);
+    if (sub.isMethod)
+    {
+      for (const auto& var : cls.fields)
+        scope.assignable.push_back(var);
+      if (cls.hasData)
+        scope.arrays.push_back({ "data", Type::ARRAY, -1 });
+    }
+
+    std::vector<Var> locals{};
+    int nLocals{ m_random.between(1, 4) };
+    for (int j = 0; j < nLocals; j++)
+      locals.push_back({ numbered("v", j), scalarType(), -1 });
+    std::vector<Var> ownArrays{};
+    if (m_random.chance(40))
+      ownArrays.push_back({ "arr0", Type::ARRAY, -1 });
+    std::vector<Var> ownObjects{};
+    int nObjects{ m_random.chance(40) ? m_random.between(1, 2) : 0 };
+    for (int j = 0; j < nObjects; j++)
+      ownObjects.push_back({ numbered("obj", j), Type::OBJECT, m_random.between(0, m_options.classes - 1) });
+    scope.hasString = m_random.chance(30);
+
+    out << "    var int i0, i1;\n";
+    for (const auto& var : locals)
+      out << "    var " << typeName(var.type, m_classes, -1) << " " << var.name << ";\n";
+    for (const auto& var : ownArrays)
+      out << "    var Array " << var.name << ";\n";
+    for (const auto& var : ownObjects)
+      out << "    var " << typeName(var.type, m_classes, var.cls) << " " << var.name << ";\n";
+    if (scope.hasString)
+      out << "    var String str;\n";
+    if (sub.returnType != Type::VOID)
+      out << "    var " << typeName(sub.returnType, m_classes, -1) << " res;\n";
+    out << "\n";
+
+    // Initial values only use the parameters and the class variables
+    for (const auto& var : locals)
+      out << "    let " << var.name << " = " << expression(var.type, scope, maxExprDepth - 1) << ";\n";
+    for (const auto& var : ownArrays)
+    {
+      out << "    let " << var.name << " = Array.new(8);\n"
+          << "    let i0 = 8;\n"
+          << "    while (i0 > 0) {\n"
+          << "      let i0 = i0 - 1;\n"
+          << "      let " << var.name << "[i0] = " << expression(Type::INT, scope, maxExprDepth - 1) << ";\n"
+          << "    }\n";
+    }
+    for (const auto& var : ownObjects)
+    {
+      const Class& objClass{ m_classes[static_cast<size_t>(var.cls)] };
+      out << "    let " << var.name << " = " << objClass.name << ".new(";
+      for (size_t j = 0; j < objClass.fields.size(); j++)
+        out << (j > 0 ? ", " : "") << expression(objClass.fields[j].type, scope, maxExprDepth - 1);
+      out << ");\n";
+    }
+
+    scope.assignable.insert(scope.assignable.end(), locals.begin(), locals.end());
+    scope.arrays.insert(scope.arrays.end(), ownArrays.begin(), ownArrays.end());
+    scope.objects = ownObjects;
+    scope.readable = scope.assignable;
+    scope.readable.push_back({ "i0", Type::INT, -1 });
+    scope.readable.push_back({ "i1", Type::INT, -1 });
+
+    m_budget = m_options.statements;
+    while (m_budget > 0)
+      statement(scope, "    ", out);
+
+    if (sub.returnType != Type::VOID)
+      out << "    let res = " << expression(sub.returnType, scope, 0) << ";\n";
+    for (const auto& var : ownArrays)
+      out << "    do " << var.name << ".dispose();\n";
+    for (const auto& var : ownObjects)
+      out << "    do " << var.name << ".dispose();\n";
+    out << (sub.returnType != Type::VOID ? "    return res;\n" : "    return;\n") << "  }\n";
+  }
+
+  // Main.main calls every function, and every method on an object of its
+  // class, once
+  void JackGenerator::writeMain(std::ostream& out)
+  {
+    Scope scope{};
+    scope.level = m_options.levels + 1;
+    scope.arrays.push_back({ "arr0", Type::ARRAY, -1 });
+    std::vector<Var> objects{};
+    for (size_t k = 0; k < m_classes.size(); k++)
+      objects.push_back({ numbered("obj", k), Type::OBJECT, static_cast<int>(k) });
+
+    out << "class Main {\n"
+        << "  function void main() {\n"
+        << "    var int sum;\n"
+        << "    var Array arr0;\n";
+    for (const auto& obj : objects)
+      out << "    var " << typeName(obj.type, m_classes, obj.cls) << " " << obj.name << ";\n";
+    out << "\n"
+        << "    let sum = 0;\n"
+        << "    let arr0 = Array.new(8);\n";
+    for (int j = 0; j < 8; j++)
+      out << "    let arr0[" << j << "] = " << intConstant() << ";\n";
+
+    for (size_t k = 0; k < m_classes.size(); k++)
+    {
+      const Class& cls{ m_classes[k] };
+      const Var& obj{ objects[k] };
+      out << "    let " << obj.name << " = " << cls.name << ".new(";
+      for (size_t j = 0; j < cls.fields.size(); j++)
+        out << (j > 0 ? ", " : "") << expression(cls.fields[j].type, scope, maxExprDepth - 1);
+      out << ");\n";
+
+      // Only the object of this class is alive
+      scope.objects = { obj };
+
+      for (const auto& sub : cls.subroutines)
+      {
+        bool ok{ true };
+        std::string text{ (sub.isMethod ? obj.name : cls.name) + "." + sub.name + "(" +
+                          arguments(sub, scope, maxExprDepth - 1, ok) + ")" };
+        if (sub.returnType == Type::VOID)
+          out << "    do " << text << ";\n";
+        else if (sub.returnType == Type::BOOLEAN)
+          out << "    if (" << text << ") {\n      let sum = sum + 1;\n    }\n";
+        else
+          out << "    let sum = sum + " << text << ";\n";
+      }
+      out << "    do " << obj.name << ".dispose();\n";
+      scope.objects.clear();
+    }
+
+    out << "    do arr0.dispose();\n"
+        << "    do Output.printInt(sum);\n"
+        << "    return;\n"
+        << "  }\n"
+        << "}\n";
+  }
+
+  void JackGenerator::write(const fs::path& dir)
+  {
+    declareClasses();
+    fs::create_directories(dir);
+
+    for (size_t k = 0; k < m_classes.size(); k++)
+    {
+      const Class& cls{ m_classes[k] };
+      std::ofstream out(dir / (cls.name + ".jack"));
+      out << "class " << cls.name << " {\n";
+      for (const auto& var : cls.statics)
+        out << "  static " << typeName(var.type, m_classes, -1) << " " << var.name << ";\n";
+      for (const auto& var : cls.fields)
+        out << "  field " << typeName(var.type, m_classes, -1) << " " << var.name << ";\n";
+      if (cls.hasData)
+        out << "  field Array data;\n";
+      out << "\n";
+
+      writeConstructor(cls, out);
+      for (const auto& sub : cls.subroutines)
+        writeSubroutine(cls, static_cast<int>(k), sub, out);
+      out << "}\n";
+    }
+
+    std::ofstream main(dir / "Main.jack");
+    writeMain(main);
+  }
+
+  // ------- VM -------
+
+  class VMGenerator
+  {
+  private:
+    struct Function
+    {
+      std::string name{};
+      int nArgs{ 0 };
+      int level{ 1 };
+    };
+
+    // The function being generated
+    struct Frame
+    {
+      int nArgs{ 0 };
+      int nLocals{ 0 };         // locals 0 and 1 are the loop counters
+      int nStatics{ 0 };
+      bool usesPointers{ false };
+      int level{ 0 };
+      int loopDepth{ 0 };
+      int labelIdx{ 0 };
+    };
+
+    static constexpr int maxLoopDepth{ 2 };
+    static constexpr int maxExprDepth{ 3 };
+    static constexpr int pointerBase{ 3000 };   // THIS/THAT point into [3000, 4000)
+    static constexpr int sysStatics{ 16 };      // results kept by Sys.init
+
+    const Options& m_options;
+    Random m_random;
+    std::vector<std::vector<Function>> m_classes{};
+    std::vector<int> m_nStatics{};
+    int m_budget{ 0 };
+
+    std::string pointerValue() { return std::to_string(pointerBase + 8 * m_random.between(0, 120)); }
+    void expression(Frame& frame, int depth, std::ostream& out);
+    bool call(Frame& frame, int depth, std::ostream& out);
+    void statements(Frame& frame, std::ostream& out);
+    void statement(Frame& frame, std::ostream& out);
+
+  public:
+    VMGenerator(const Options& options, uint64_t seed)
+      : m_options{ options }
+      , m_random{ seed }
+    {
+    }
+
+    void write(const fs::path& dir);
+  };
+
+  // Pushes the arguments and calls a function of a lower level, if any
+  bool VMGenerator::call(Frame& frame, int depth, std::ostream& out)
+  {
+    std::vector<const Function*> candidates{};
+    for (const auto& functions : m_classes)
+      for (const auto& function : functions)
+        if (function.level < frame.level)
+          candidates.push_back(&function);
+    if (candidates.empty())
+      return false;
+
+    const Function& callee{ *m_random.pick(candidates) };
+    for (int j = 0; j < callee.nArgs; j++)
+      expression(frame, depth + 1, out);
+    out << "call " << callee.name << " " << callee.nArgs << "\n";
+    return true;
+  }
+
+  // Leaves exactly one value on the stack
+  void VMGenerator::expression(Frame& frame, int depth, std::ostream& out)
+  {
+    int r{ m_random.between(0, depth >= maxExprDepth ? 1 : 4) };
+
+    if (r == 1 || (r == 2 && !call(frame, depth, out)))
+    {
+      std::vector<std::string> sources{ numbered("local ", m_random.between(0, frame.nLocals - 1)),
+                                        numbered("temp ", m_random.between(0, 7)) };
+      if (frame.nStatics > 0)
+        sources.push_back(numbered("static ", m_random.between(0, frame.nStatics - 1)));
+      if (frame.nArgs > 0)
+        sources.push_back(numbered("argument ", m_random.between(0, frame.nArgs - 1)));
+      if (frame.usesPointers)
+      {
+        sources.push_back(numbered("this ", m_random.between(0, 7)));
+        sources.push_back(numbered("that ", m_random.between(0, 7)));
+        sources.push_back(numbered("pointer ", m_random.between(0, 1)));
+      }
+      out << "push " << m_random.pick(sources) << "\n";
+    }
+    else if (r == 0)
+      out << "push constant " << (m_random.chance(80) ? m_random.between(0, 100) : m_random.between(0, 32767)) << "\n";
+    else if (r == 3)
+    {
+      expression(frame, depth + 1, out);
+      out << (m_random.chance(50) ? "neg\n" : "not\n");
+    }
+    else if (r == 4)
+    {
+      static const std::vector<std::string> ops{ "add", "sub", "and", "or", "eq", "gt", "lt" };
+      const std::string& op{ m_random.pick(ops) };
+      bool masked{ m_options.maskCompares && (op == "gt" || op == "lt") };
+      for (int j = 0; j < 2; j++)
+      {
+        expression(frame, depth + 1, out);
+        if (masked)
+          out << "push constant 16383\nand\n";
+      }
+      out << op << "\n";
+    }
+  }
+
+  void VMGenerator::statements(Frame& frame, std::ostream& out)
+  {
+    int n{ m_random.between(1, 3) };
+    for (int j = 0; j < n && m_budget > 0; j++)
+      statement(frame, out);
+  }
+
+  // Starts and ends with an empty stack
+  void VMGenerator::statement(Frame& frame, std::ostream& out)
+  {
+    m_budget--;
+    int r{ m_random.between(0, 9) };
+
+    if (r <= 3)
+    {
+      std::vector<std::string> targets{ numbered("temp ", m_random.between(0, 7)) };
+      if (frame.nStatics > 0)
+        targets.push_back(numbered("static ", m_random.between(0, frame.nStatics - 1)));
+      if (frame.nLocals > 2)
+        targets.push_back(numbered("local ", m_random.between(2, frame.nLocals - 1)));
+      if (frame.nArgs > 0)
+        targets.push_back(numbered("argument ", m_random.between(0, frame.nArgs - 1)));
+      if (frame.usesPointers)
+      {
+        targets.push_back(numbered("this ", m_random.between(0, 7)));
+        targets.push_back(numbered("that ", m_random.between(0, 7)));
+      }
+      expression(frame, 0, out);
+      out << "pop " << m_random.pick(targets) << "\n";
+    }
+    else if (r == 4 && frame.usesPointers)
+      out << "push constant " << pointerValue() << "\npop pointer " << m_random.between(0, 1) << "\n";
+    else if (r <= 6)
+    {
+      std::string thenLabel{ numbered("IF_TRUE", frame.labelIdx) };
+      std::string endLabel{ numbered("IF_END", frame.labelIdx++) };
+      expression(frame, 0, out);
+      out << "if-goto " << thenLabel << "\n";
+      statements(frame, out);
+      out << "goto " << endLabel << "\nlabel " << thenLabel << "\n";
+      statements(frame, out);
+      out << "label " << endLabel << "\n";
+    }
+    else if (r == 7 && frame.loopDepth < maxLoopDepth)
+    {
+      std::string counter{ numbered("local ", frame.loopDepth) };
+      std::string topLabel{ numbered("LOOP", frame.labelIdx) };
+      std::string endLabel{ numbered("LOOP_END", frame.labelIdx++) };
+      out << "push constant " << m_random.between(1, 3) << "\npop " << counter << "\n"
+          << "label " << topLabel << "\n"
+          << "push " << counter << "\npush constant 0\neq\nif-goto " << endLabel << "\n";
+      frame.loopDepth++;
+      statements(frame, out);
+      frame.loopDepth--;
+      out << "push " << counter << "\npush constant 1\nsub\npop " << counter << "\n"
+          << "goto " << topLabel << "\nlabel " << endLabel << "\n";
+    }
+    else if (call(frame, 0, out))
+      out << "pop temp " << m_random.between(0, 7) << "\n";
+  }
+
+  void VMGenerator::write(const fs::path& dir)
+  {
+    m_classes.resize(static_cast<size_t>(m_options.classes));
+    int staticsLeft{ staticCells - sysStatics };
+    for (size_t k = 0; k < m_classes.size(); k++)
+    {
+      m_nStatics.push_back(std::min(m_random.between(1, 4), staticsLeft));
+      staticsLeft -= m_nStatics.back();
+      for (int j = 0; j < m_options.subroutines; j++)
+      {
+        Function function{};
+        function.name = numbered(numbered("C", k) + ".f", j);
+        function.nArgs = m_random.between(0, 3);
+        function.level = m_random.between(1, m_options.levels);
+        m_classes[k].push_back(std::move(function));
+      }
+    }
+    fs::create_directories(dir);
+
+    for (size_t k = 0; k < m_classes.size(); k++)
+    {
+      std::ofstream out(dir / (numbered("C", k) + ".vm"));
+      for (const auto& function : m_classes[k])
+      {
+        Frame frame{};
+        frame.nArgs = function.nArgs;
+        frame.nLocals = 2 + m_random.between(0, 3);
+        frame.nStatics = m_nStatics[k];
+        frame.usesPointers = m_random.chance(40);
+        frame.level = function.level;
+
+        out << "function " << function.name << " " << frame.nLocals << "\n";
+        if (frame.usesPointers)
+        {
+          out << "push constant " << pointerValue() << "\npop pointer 0\n"
+              << "push constant " << pointerValue() << "\npop pointer 1\n";
+        }
+        m_budget = m_options.statements;
+        while (m_budget > 0)
+          statement(frame, out);
+        expression(frame, 0, out);
+        out << "return\n";
+      }
+    }
+
+    // Sys.init calls every function once and keeps the results
+    std::ofstream sys(dir / "Sys.vm");
+    sys << "function Sys.init 0\n";
+    int result{ 0 };
+    for (const auto& functions : m_classes)
+    {
+      for (const auto& function : functions)
+      {
+        for (int j = 0; j < function.nArgs; j++)
+          sys << "push constant " << m_random.between(0, 100) << "\n";
+        sys << "call " << function.name << " " << function.nArgs << "\n"
+            << "pop static " << (result++ % sysStatics) << "\n";
+      }
+    }
+    sys << "label HALT\ngoto HALT\n";
+  }
+
+  bool parseOptions(int argc, char* argv[], Options& options, fs::path& outDir)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg{ argv[i] };
+      bool hasValue{ i + 1 < argc };
+      if (arg == "--vm")
+        options.vm = true;
+      else if (arg == "--seed" && hasValue)
+        options.seed = std::stoull(argv[++i]);
+      else if (arg == "--count" && hasValue)
+        options.count = std::stoi(argv[++i]);
+      else if (arg == "--classes" && hasValue)
+        options.classes = std::stoi(argv[++i]);
+      else if (arg == "--subroutines" && hasValue)
+        options.subroutines = std::stoi(argv[++i]);
+      else if (arg == "--statements" && hasValue)
+        options.statements = std::stoi(argv[++i]);
+      else if (arg == "--levels" && hasValue)
+        options.levels = std::stoi(argv[++i]);
+      else if (arg == "--mask-compares")
+        options.maskCompares = true;
+      else if (!arg.starts_with("--") && outDir.empty())
+        outDir = arg;
+      else
+        return false;
+    }
+    return !outDir.empty() && options.classes >= 1 && options.subroutines >= 1 &&
+           options.statements >= 0 && options.levels >= 1 && options.count >= 0;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  Options options{};
+  fs::path outDir{};
+  try
+  {
+    if (!parseOptions(argc, argv, options, outDir))
+    {
+      std::cerr << "Usage: ProgramGen [--vm] [--seed N] [--count N] [--classes N] [--subroutines N]\n"
+                   "                  [--statements N] [--levels N] [--mask-compares] out-dir\n";
+      return 1;
+    }
+  }
+  catch (const std::exception&)
+  {
+    std::cerr << "Invalid numeric option\n";
+    return 1;
+  }
+
+  int count{ std::max(options.count, 1) };
+  for (int i = 0; i < count; i++)
+  {
+    uint64_t seed{ options.seed + static_cast<uint64_t>(i) };
+    fs::path dir{ options.count > 0 ? outDir / std::to_string(i) : outDir };
+    if (options.vm)
+      VMGenerator(options, seed).write(dir);
+    else
+      JackGenerator(options, seed).write(dir);
+  }
+
+  return 0;
+}
\ No newline at end of file
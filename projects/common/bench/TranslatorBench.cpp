@@ -0,0 +1,488 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <spawn.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "OutputBuffer.h"
+#include "HackAssembler.h"
+#include "HackEmulator.h"
+#include "KeyboardLog.h"
+
+// Benchmark harness for the VM translators.
+//
+//   TranslatorBench [options] name=command... -- program-dir...
+//
+//   name=command      a translator to measure, e.g. base=/path/VMtranslator;
+//                     the command may carry options ("O2=/path/VMtranslator -O2")
+//   program-dir       searched recursively: every directory holding .vm
+//                     files is one program
+//   --os dir          add the .vm files of dir (the Jack OS) to programs
+//                     that call a class they do not define
+//   --synthetic N     also run a generated program of N classes
+//   --repeat N        translate each program N times (default 3): the time
+//                     is the fastest run, the RSS the largest
+//   --max-cycles N    emulation budget per program (default 100000000)
+//   --keys file       keyboard log replayed in every run (see KeyboardLog.h),
+//                     so that interactive programs run the same way each time
+//   --csv file        write the results as CSV
+//   --json file       write the results as JSON
+//
+// For each translator and program it records the translation wall-clock
+// time and peak RSS of the translator process, the number of instructions
+// in the .asm it produced, and, for programs with a Sys.init, the cycles
+// the Hack CPU takes from reset to Sys.halt (or to the final @X / 0;JMP
+// loop). Programs are copied to a scratch directory first, so the source
+// tree is never written to.
+
+namespace fs = std::filesystem;
+
+extern char** environ;
+
+namespace
+{
+  struct Translator
+  {
+    std::string name{};
+    std::vector<std::string> command{};
+  };
+
+  struct Program
+  {
+    std::string name{};
+    std::vector<fs::path> files{};
+    bool hasSysInit{ false };
+  };
+
+  struct Result
+  {
+    std::string translator{};
+    std::string program{};
+    std::string status{};
+    double translateMs{ 0 };
+    long peakRssKiB{ 0 };
+    long instructions{ -1 };
+    long long cycles{ -1 };
+  };
+
+  std::string readFile(const fs::path& path)
+  {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream text{};
+    text << file.rdbuf();
+    return text.str();
+  }
+
+  // Functions a set of .vm files defines, and classes it calls into
+  void scanVm(const fs::path& path, std::unordered_set<std::string>& defined,
+              std::unordered_set<std::string>& calledClasses, bool& hasSysInit)
+  {
+    std::istringstream text{ readFile(path) };
+    std::string line{};
+    while (std::getline(text, line))
+    {
+      std::istringstream words{ line };
+      std::string command{};
+      std::string name{};
+      words >> command >> name;
+      if (command == "function")
+      {
+        defined.insert(name.substr(0, name.find('.')));
+        hasSysInit = hasSysInit || name == "Sys.init";
+      }
+      else if (command == "call")
+      {
+        calledClasses.insert(name.substr(0, name.find('.')));
+      }
+    }
+  }
+
+  Program loadProgram(const fs::path& dir, const std::string& name, const fs::path& osDir)
+  {
+    Program program{};
+    program.name = name;
+
+    std::unordered_set<std::string> defined{};
+    std::unordered_set<std::string> calledClasses{};
+    std::unordered_set<std::string> fileNames{};
+    for (const auto& entry : fs::directory_iterator(dir))
+    {
+      if (entry.is_regular_file() && entry.path().extension() == ".vm")
+      {
+        program.files.push_back(entry.path());
+        fileNames.insert(entry.path().filename().string());
+        scanVm(entry.path(), defined, calledClasses, program.hasSysInit);
+      }
+    }
+
+    bool needsOs{ false };
+    for (const auto& c : calledClasses)
+      needsOs = needsOs || !defined.contains(c);
+
+    if (needsOs && !osDir.empty())
+    {
+      for (const auto& entry : fs::directory_iterator(osDir))
+      {
+        if (entry.path().extension() != ".vm" || fileNames.contains(entry.path().filename().string()))
+          continue;
+        program.files.push_back(entry.path());
+        scanVm(entry.path(), defined, calledClasses, program.hasSysInit);
+      }
+    }
+
+    std::sort(program.files.begin(), program.files.end());
+    return program;
+  }
+
+  void findPrograms(const fs::path& root, const fs::path& osDir, std::vector<Program>& programs)
+  {
+    std::vector<fs::path> dirs{ root };
+    for (const auto& entry : fs::recursive_directory_iterator(root))
+    {
+      if (entry.is_directory())
+        dirs.push_back(entry.path());
+    }
+    std::sort(dirs.begin(), dirs.end());
+
+    for (const auto& dir : dirs)
+    {
+      bool hasVm{ false };
+      for (const auto& entry : fs::directory_iterator(dir))
+        hasVm = hasVm || entry.path().extension() == ".vm";
+      if (hasVm)
+        programs.push_back(loadProgram(dir, dir.lexically_normal().generic_string(), osDir));
+    }
+  }
+
+  // N classes with a loop, a helper and some never-called code each, plus
+  // a Sys.init that runs every loop once and halts
+  Program writeSynthetic(const fs::path& dir, int nClasses)
+  {
+    fs::create_directories(dir);
+    std::ofstream sys(dir / "Sys.vm");
+    sys << "function Sys.init 0\n";
+    for (int k = 0; k < nClasses; k++)
+      sys << "push constant 10\ncall C" << k << ".loop 1\npop temp 0\n";
+    sys << "label HALT\ngoto HALT\n";
+    sys.close();
+
+    for (int k = 0; k < nClasses; k++)
+    {
+      std::ofstream file(dir / ("C" + std::to_string(k) + ".vm"));
+      file <<
+        "function C" << k << ".loop 2\n"
+        "push constant 0\npop local 0\npush argument 0\npop local 1\n"
+        "label LOOP\npush local 1\npush constant 0\neq\nif-goto END\n"
+        "push local 0\npush local 1\ncall C" << k << ".step 1\nadd\npop local 0\n"
+        "push local 1\npush constant 1\nsub\npop local 1\ngoto LOOP\n"
+        "label END\npush local 0\nreturn\n"
+        "function C" << k << ".step 1\n"
+        "push argument 0\npush argument 0\nadd\npop local 0\n"
+        "push local 0\npush static 0\nadd\npop static 0\n"
+        "push local 0\npush constant " << k % 100 << "\nlt\nif-goto SMALL\n"
+        "push local 0\nneg\nreturn\n"
+        "label SMALL\npush local 0\nnot\nreturn\n";
+
+      for (int j = 0; j < 8; j++)
+      {
+        file <<
+          "function C" << k << ".unused" << j << " 3\n"
+          "push argument 0\npush argument 1\nand\npop local 0\n"
+          "push local 0\npush constant " << j << "\nor\npop this " << j << "\n"
+          "push that " << j << "\npush local 0\ngt\npop local 1\n"
+          "push local 1\npush static " << j << "\nsub\nreturn\n";
+      }
+    }
+
+    Program program{};
+    program.name = "synthetic/" + std::to_string(nClasses);
+    program.hasSysInit = true;
+    for (const auto& entry : fs::directory_iterator(dir))
+      program.files.push_back(entry.path());
+    std::sort(program.files.begin(), program.files.end());
+    return program;
+  }
+
+  // Runs the translator on dir with its output discarded; returns the exit
+  // status and fills the wall-clock time and peak RSS of the child
+  int runTranslator(const Translator& translator, const fs::path& dir, double& ms, long& rssKiB)
+  {
+    std::vector<std::string> args{ translator.command };
+    args.push_back(dir.string());
+    std::vector<char*> argv{};
+    for (auto& arg : args)
+      argv.push_back(arg.data());
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions{};
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+
+    auto start{ std::chrono::steady_clock::now() };
+    pid_t pid{};
+    int error{ posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ) };
+    posix_spawn_file_actions_destroy(&actions);
+    if (error != 0)
+      return -1;
+
+    int status{};
+    rusage usage{};
+    wait4(pid, &status, 0, &usage);
+    ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    rssKiB = usage.ru_maxrss;
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  }
+
+  Result measure(const Translator& translator, const Program& program, const fs::path& work,
+                 int repeat, uint64_t maxCycles, const std::string& keyLog)
+  {
+    Result result{};
+    result.translator = translator.name;
+    result.program = program.name;
+
+    // The translators name their output after the directory
+    fs::remove_all(work);
+    fs::create_directories(work);
+    for (const auto& file : program.files)
+      fs::copy_file(file, work / file.filename());
+
+    for (int r = 0; r < repeat; r++)
+    {
+      double ms{ 0 };
+      long rssKiB{ 0 };
+      if (runTranslator(translator, work, ms, rssKiB) != 0)
+      {
+        result.status = "translate-failed";
+        return result;
+      }
+      result.translateMs = (r == 0) ? ms : std::min(result.translateMs, ms);
+      result.peakRssKiB = std::max(result.peakRssKiB, rssKiB);
+    }
+
+    std::vector<HackAssembler::Object> objects(1);
+    try
+    {
+      OutputBuffer text{};
+      text << readFile(work / (work.filename().string() + ".asm"));
+      objects[0] = HackAssembler::assemble(text);
+    }
+    catch (const std::exception&)
+    {
+      result.status = "assemble-failed";
+      return result;
+    }
+    result.instructions = static_cast<long>(objects[0].words.size());
+
+    // Counted even when it does not fit: the ROM only holds 32K words
+    std::vector<uint16_t> words{};
+    HackAssembler::SymbolTable symbols{};
+    try
+    {
+      words = HackAssembler::link(objects, symbols);
+    }
+    catch (const std::exception&)
+    {
+      result.status = (objects[0].words.size() > HackEmulator::memorySize) ? "rom-overflow" : "link-failed";
+      return result;
+    }
+    result.status = "ok";
+
+    if (!program.hasSysInit)
+      return result;
+
+    auto halt{ symbols.find("Sys.halt") };
+    HackEmulator emulator(std::move(words));
+    std::istringstream keyText{ keyLog };
+    KeyboardLog keys(keyText);
+    emulator.setKeyboard(&keys);
+    HackEmulator::Stop stop{ emulator.run(maxCycles, halt == symbols.end() ? -1 : halt->second) };
+
+    result.cycles = static_cast<long long>(emulator.cycles());
+    if (stop == HackEmulator::Stop::CYCLES)
+      result.status = "timeout";
+    else if (stop == HackEmulator::Stop::END_OF_ROM)
+      result.status = "fell-off-rom";
+    return result;
+  }
+
+  std::string jsonString(const std::string& s)
+  {
+    std::string quoted{ "\"" };
+    for (char c : s)
+    {
+      if (c == '"' || c == '\\')
+        quoted += '\\';
+      quoted += c;
+    }
+    return quoted + "\"";
+  }
+
+  void writeCsv(const std::vector<Result>& results, std::ostream& out)
+  {
+    out << "translator,program,status,translate_ms,peak_rss_kib,instructions,cycles\n";
+    for (const auto& r : results)
+    {
+      out << r.translator << "," << r.program << "," << r.status << ","
+          << std::fixed << std::setprecision(3) << r.translateMs << ","
+          << r.peakRssKiB << "," << r.instructions << "," << r.cycles << "\n";
+    }
+  }
+
+  void writeJson(const std::vector<Result>& results, std::ostream& out)
+  {
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+      const auto& r{ results[i] };
+      out << "  {\"translator\": " << jsonString(r.translator)
+          << ", \"program\": " << jsonString(r.program)
+          << ", \"status\": " << jsonString(r.status)
+          << ", \"translate_ms\": " << std::fixed << std::setprecision(3) << r.translateMs
+          << ", \"peak_rss_kib\": " << r.peakRssKiB
+          << ", \"instructions\": " << r.instructions
+          << ", \"cycles\": " << r.cycles << "}"
+          << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  std::vector<Translator> translators{};
+  std::vector<fs::path> roots{};
+  fs::path osDir{};
+  fs::path csvPath{};
+  fs::path jsonPath{};
+  int repeat{ 3 };
+  int synthetic{ 0 };
+  uint64_t maxCycles{ 100'000'000 };
+  fs::path keysPath{};
+
+  bool programsFollow{ false };
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg{ argv[i] };
+    bool hasValue{ i + 1 < argc };
+
+    if (programsFollow)
+      roots.push_back(arg);
+    else if (arg == "--")
+      programsFollow = true;
+    else if (arg == "--os" && hasValue)
+      osDir = argv[++i];
+    else if (arg == "--csv" && hasValue)
+      csvPath = argv[++i];
+    else if (arg == "--json" && hasValue)
+      jsonPath = argv[++i];
+    else if (arg == "--repeat" && hasValue)
+      repeat = std::max(1, std::stoi(argv[++i]));
+    else if (arg == "--synthetic" && hasValue)
+      synthetic = std::stoi(argv[++i]);
+    else if (arg == "--max-cycles" && hasValue)
+      maxCycles = std::stoull(argv[++i]);
+    else if (arg == "--keys" && hasValue)
+      keysPath = argv[++i];
+    else if (arg.find('=') != std::string::npos && !arg.starts_with("--"))
+    {
+      Translator translator{};
+      translator.name = arg.substr(0, arg.find('='));
+      std::istringstream words{ arg.substr(arg.find('=') + 1) };
+      for (std::string word; words >> word; )
+        translator.command.push_back(word);
+      translators.push_back(std::move(translator));
+    }
+    else
+    {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  if (translators.empty() || (roots.empty() && synthetic == 0))
+  {
+    std::cerr << "Usage: TranslatorBench [--os dir] [--synthetic N] [--repeat N] [--max-cycles N]\n"
+                 "                      [--keys file] [--csv file] [--json file] name=command... -- program-dir..." << std::endl;
+    return 1;
+  }
+
+  // Checked once here, parsed again for each run
+  std::string keyLog{};
+  if (!keysPath.empty())
+  {
+    std::ifstream in(keysPath);
+    if (!in)
+    {
+      std::cerr << "Unable to open keyboard log: " << keysPath << std::endl;
+      return 1;
+    }
+    keyLog.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    try
+    {
+      std::istringstream keyText{ keyLog };
+      KeyboardLog keys(keyText);
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << "Error: " << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  const fs::path scratch{ fs::temp_directory_path() / ("vmbench-" + std::to_string(getpid())) };
+
+  std::vector<Program> programs{};
+  for (const auto& root : roots)
+    findPrograms(root, osDir, programs);
+  if (synthetic > 0)
+    programs.push_back(writeSynthetic(scratch / "synthetic", synthetic));
+
+  std::vector<Result> results{};
+  std::cout << std::left << std::setw(12) << "translator" << std::setw(48) << "program"
+            << std::setw(18) << "status" << std::right << std::setw(12) << "time ms"
+            << std::setw(10) << "rss KiB" << std::setw(10) << "instr" << std::setw(14) << "cycles" << "\n";
+
+  for (size_t t = 0; t < translators.size(); t++)
+  {
+    for (size_t p = 0; p < programs.size(); p++)
+    {
+      const fs::path work{ scratch / std::to_string(t) / ("p" + std::to_string(p)) };
+      Result r{ measure(translators[t], programs[p], work, repeat, maxCycles, keyLog) };
+
+      std::cout << std::left << std::setw(12) << r.translator << std::setw(48) << r.program
+                << std::setw(18) << r.status << std::right << std::fixed << std::setprecision(2)
+                << std::setw(12) << r.translateMs << std::setw(10) << r.peakRssKiB
+                << std::setw(10) << r.instructions << std::setw(14) << r.cycles << std::endl;
+      results.push_back(std::move(r));
+    }
+  }
+
+  fs::remove_all(scratch);
+
+  if (!csvPath.empty())
+  {
+    std::ofstream csv(csvPath);
+    writeCsv(results, csv);
+  }
+  if (!jsonPath.empty())
+  {
+    std::ofstream json(jsonPath);
+    writeJson(results, json);
+  }
+
+  return 0;
+}
\ No newline at end of file
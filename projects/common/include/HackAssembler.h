@@ -0,0 +1,51 @@
+#ifndef HACKASSEMBLER_H
+#define HACKASSEMBLER_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "OutputBuffer.h"
+
+// In-process Hack assembler, used when the translator emits .hack directly
+// and by the tools that need to run translated code.
+// Each file's code is encoded on its own (and in parallel) into an object
+// with relative label addresses and a list of symbolic @references; link()
+// lays the objects out in order, resolves the references and allocates
+// variables from RAM[16] in order of first appearance, exactly like the
+// two-pass Assembler of project 06.
+class HackAssembler
+{
+public:
+  struct Fixup
+  {
+    size_t word;                 // index of the A-instruction in the object
+    std::string symbol;
+  };
+
+  struct Object
+  {
+    std::vector<uint16_t> words{};
+    std::vector<std::pair<std::string, size_t>> labels{};
+    std::vector<Fixup> fixups{};
+  };
+
+private:
+  static uint16_t encodeC(std::string_view instruction);
+  static void encodeLine(std::string_view line, Object& object);
+
+public:
+  static Object assemble(const OutputBuffer& code);
+  typedef std::unordered_map<std::string, uint16_t> SymbolTable;
+
+  static std::vector<uint16_t> link(const std::vector<Object>& objects);
+  static std::vector<uint16_t> link(const std::vector<Object>& objects, SymbolTable& symbols);
+
+  static void writeText(const std::vector<uint16_t>& words, std::ostream& out);
+  static void writeBinary(const std::vector<uint16_t>& words, std::ostream& out);
+};
+
+#endif
\ No newline at end of file
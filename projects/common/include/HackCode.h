@@ -0,0 +1,251 @@
+#ifndef HACKCODE_H
+#define HACKCODE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "HackAssembler.h"
+#include "OutputBuffer.h"
+
+// Where the code writers put their instructions: as .asm text in an
+// OutputBuffer, or as encoded words in a HackAssembler::Object, with no
+// text in between. Fixed sequences are written as "..."_hack literals,
+// which are encoded at compile time; addresses, symbols and labels known
+// only at run time go through at() and label().
+namespace HackLiteral
+{
+  // A string literal as a template argument
+  template <size_t N>
+  struct Text
+  {
+    char chars[N]{};
+
+    consteval Text(const char (&text)[N]) { std::copy_n(text, N, chars); }
+  };
+
+  struct Instruction
+  {
+    enum class Kind : uint8_t { WORD, REFERENCE, LABEL };
+
+    Kind kind{ Kind::WORD };
+    uint16_t word{ 0 };
+    std::string_view symbol{};    // REFERENCE and LABEL
+  };
+
+  struct Mnemonic
+  {
+    std::string_view text;
+    uint16_t bits;
+  };
+
+  constexpr Mnemonic comps[]{
+    {"0",   0b0101010}, {"1",   0b0111111}, {"-1",  0b0111010},
+    {"D",   0b0001100}, {"A",   0b0110000}, {"!D",  0b0001101},
+    {"!A",  0b0110001}, {"-D",  0b0001111}, {"-A",  0b0110011},
+    {"D+1", 0b0011111}, {"A+1", 0b0110111}, {"D-1", 0b0001110},
+    {"A-1", 0b0110010}, {"D+A", 0b0000010}, {"D-A", 0b0010011},
+    {"A-D", 0b0000111}, {"D&A", 0b0000000}, {"D|A", 0b0010101},
+    {"M",   0b1110000}, {"!M",  0b1110001}, {"-M",  0b1110011},
+    {"M+1", 0b1110111}, {"M-1", 0b1110010}, {"D+M", 0b1000010},
+    {"D-M", 0b1010011}, {"M-D", 0b1000111}, {"D&M", 0b1000000},
+    {"D|M", 0b1010101}
+  };
+
+  constexpr Mnemonic dests[]{
+    {"",  0b000}, {"M",  0b001}, {"D",  0b010}, {"MD",  0b011},
+    {"A", 0b100}, {"AM", 0b101}, {"AD", 0b110}, {"AMD", 0b111}
+  };
+
+  constexpr Mnemonic jumps[]{
+    {"",    0b000}, {"JGT", 0b001}, {"JEQ", 0b010}, {"JGE", 0b011},
+    {"JLT", 0b100}, {"JNE", 0b101}, {"JLE", 0b110}, {"JMP", 0b111}
+  };
+
+  // Predefined symbols are resolved here, every other one by the linker
+  constexpr Mnemonic predefined[]{
+    {"R0", 0},   {"R1", 1},   {"R2", 2},   {"R3", 3},
+    {"R4", 4},   {"R5", 5},   {"R6", 6},   {"R7", 7},
+    {"R8", 8},   {"R9", 9},   {"R10", 10}, {"R11", 11},
+    {"R12", 12}, {"R13", 13}, {"R14", 14}, {"R15", 15},
+    {"SP", 0},   {"LCL", 1},  {"ARG", 2},  {"THIS", 3}, {"THAT", 4},
+    {"SCREEN", 16384}, {"KBD", 24576}
+  };
+
+  // An invalid mnemonic is not a constant expression: the literal does
+  // not compile
+  template <size_t N>
+  consteval uint16_t lookup(const Mnemonic (&table)[N], std::string_view text)
+  {
+    for (const auto& [mnemonic, bits] : table)
+    {
+      if (mnemonic == text)
+        return bits;
+    }
+    throw "Invalid mnemonic in a _hack literal";
+  }
+
+  consteval Instruction encode(std::string_view line)
+  {
+    if (line.front() == '(')
+      return { Instruction::Kind::LABEL, 0, line.substr(1, line.size() - 2) };
+
+    if (line.front() == '@')
+    {
+      std::string_view symbol{ line.substr(1) };
+      if (symbol.front() >= '0' && symbol.front() <= '9')
+      {
+        unsigned int value{ 0 };
+        for (char c : symbol)
+          value = value * 10 + static_cast<unsigned int>(c - '0');
+        if (value > 0x7FFF)
+          throw "Constant out of range in a _hack literal";
+        return { Instruction::Kind::WORD, static_cast<uint16_t>(value), {} };
+      }
+      for (const auto& [name, address] : predefined)
+      {
+        if (name == symbol)
+          return { Instruction::Kind::WORD, address, {} };
+      }
+      return { Instruction::Kind::REFERENCE, 0, symbol };
+    }
+
+    std::string_view dest{};
+    std::string_view comp{ line };
+    std::string_view jump{};
+    if (size_t eq{ comp.find('=') }; eq != std::string_view::npos)
+    {
+      dest = comp.substr(0, eq);
+      comp.remove_prefix(eq + 1);
+    }
+    if (size_t semi{ comp.find(';') }; semi != std::string_view::npos)
+    {
+      jump = comp.substr(semi + 1);
+      comp = comp.substr(0, semi);
+    }
+    return { Instruction::Kind::WORD,
+             static_cast<uint16_t>(0b111 << 13 | lookup(comps, comp) << 6 | lookup(dests, dest) << 3 |
+                                   lookup(jumps, jump)),
+             {} };
+  }
+
+  // One instruction per line, every line ended by '\n', as the writers
+  // format their .asm output
+  consteval size_t countLines(std::string_view text)
+  {
+    if (text.empty() || text.back() != '\n')
+      throw "A _hack literal must end with a newline";
+    return static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+  }
+
+  template <Text T>
+  struct Block
+  {
+    static constexpr std::string_view text{ T.chars, sizeof(T.chars) - 1 };
+    static constexpr size_t size{ countLines(text) };
+    static constexpr std::array<Instruction, size> instructions{ []() consteval
+    {
+      std::array<Instruction, size> encoded{};
+      std::string_view rest{ text };
+      for (auto& instruction : encoded)
+      {
+        size_t newline{ rest.find('\n') };
+        instruction = encode(rest.substr(0, newline));
+        rest.remove_prefix(newline + 1);
+      }
+      return encoded;
+    }() };
+  };
+}
+
+template <HackLiteral::Text T>
+constexpr HackLiteral::Block<T> operator""_hack()
+{
+  return {};
+}
+
+class HackCode
+{
+private:
+  OutputBuffer* m_text{ nullptr };
+  HackAssembler::Object* m_object{ nullptr };
+
+  static void appendPart(std::string& symbol, std::string_view part) { symbol += part; }
+  static void appendPart(std::string& symbol, char part) { symbol += part; }
+  static void appendPart(std::string& symbol, int part) { symbol += std::to_string(part); }
+
+  template <typename... Parts>
+  static std::string join(const Parts&... parts)
+  {
+    std::string symbol{};
+    (appendPart(symbol, parts), ...);
+    return symbol;
+  }
+
+  void reference(std::string symbol);
+
+public:
+  explicit HackCode(OutputBuffer& text) : m_text{ &text } {}
+  explicit HackCode(HackAssembler::Object& object) : m_object{ &object } {}
+
+  HackCode(const HackCode&) = delete;
+  HackCode& operator=(const HackCode&) = delete;
+
+  template <HackLiteral::Text T>
+  HackCode& operator<<(HackLiteral::Block<T> block)
+  {
+    if (m_text)
+    {
+      m_text->append(block.text);
+      return *this;
+    }
+
+    for (const auto& [kind, word, symbol] : block.instructions)
+    {
+      if (kind == HackLiteral::Instruction::Kind::WORD)
+        m_object->words.push_back(word);
+      else if (kind == HackLiteral::Instruction::Kind::REFERENCE)
+        reference(std::string(symbol));
+      else
+        m_object->labels.emplace_back(std::string(symbol), m_object->words.size());
+    }
+    return *this;
+  }
+
+  // @value, 0 <= value <= 32767
+  void at(int value);
+
+  // @symbol and (symbol), the symbol made of the parts in order (strings,
+  // characters and ints)
+  template <typename... Parts>
+  void at(std::string_view first, const Parts&... parts)
+  {
+    if (m_text)
+    {
+      *m_text << '@' << first;
+      (*m_text << ... << parts) << '\n';
+    }
+    else
+    {
+      reference(join(first, parts...));
+    }
+  }
+
+  template <typename... Parts>
+  void label(std::string_view first, const Parts&... parts)
+  {
+    if (m_text)
+    {
+      *m_text << '(' << first;
+      (*m_text << ... << parts) << ")\n";
+    }
+    else
+    {
+      m_object->labels.emplace_back(join(first, parts...), m_object->words.size());
+    }
+  }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef HACKEMULATOR_H
+#define HACKEMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "KeyboardLog.h"
+
+// Instruction-level emulator of the Hack CPU of project 05: 32K words of
+// ROM and RAM (the screen and the keyboard are plain RAM cells), one
+// instruction per cycle. As in the hardware, a C-instruction reads M and
+// jumps through the value A had before the instruction.
+class HackEmulator
+{
+public:
+  static constexpr size_t memorySize{ 32768 };
+  static constexpr uint16_t keyboard{ 24576 };
+
+  enum class Stop
+  {
+    CYCLES,       // maxCycles instructions executed
+    HALT,         // a loop that can never leave: PC came back to a jump target
+                  // with A, D and RAM as they were on the previous arrival
+    BREAKPOINT,   // PC reached the stop address, or one of the breakpoints
+    END_OF_ROM    // PC went past the last instruction
+  };
+
+private:
+  // Cells a loop may write and still be recognised as a halt
+  static constexpr size_t maxLoopWrites{ 16 };
+
+  std::vector<uint16_t> m_rom{};
+  std::vector<int16_t> m_ram{};
+  int16_t m_a{ 0 };
+  int16_t m_d{ 0 };
+  uint16_t m_pc{ 0 };
+  uint64_t m_cycles{ 0 };
+  KeyboardLog* m_keyboard{ nullptr };
+
+  template <typename AtBreakpoint>
+  Stop execute(uint64_t maxCycles, AtBreakpoint atBreakpoint);
+
+public:
+  HackEmulator(std::vector<uint16_t> rom);
+
+  HackEmulator(const HackEmulator&) = delete;
+  HackEmulator& operator=(const HackEmulator&) = delete;
+
+  // PC, A and D back to 0, cycle count cleared; RAM is left as it is
+  void reset() noexcept;
+
+  int16_t& ram(uint16_t address) { return m_ram[address & (memorySize - 1)]; }
+  int16_t ram(uint16_t address) const { return m_ram[address & (memorySize - 1)]; }
+
+  // All of RAM at once, for tools that compare it
+  std::span<const int16_t> memory() const noexcept { return m_ram; }
+
+  uint16_t pc() const noexcept { return m_pc; }
+  uint64_t cycles() const noexcept { return m_cycles; }
+  const std::vector<uint16_t>& rom() const noexcept { return m_rom; }
+
+  // The keyboard cell follows `keys` (timed in cycles) from the next run on;
+  // a halt while keys are left waits for the next one
+  void setKeyboard(KeyboardLog* keys) noexcept { m_keyboard = keys; }
+
+  // Executes until one of the Stop conditions; stopAt < 0 disables the
+  // breakpoint
+  Stop run(uint64_t maxCycles, int stopAt = -1);
+
+  // Same, stopping at every address marked in `breakpoints` (one flag per
+  // ROM word). As with stopAt, a run started on a breakpoint stops there.
+  Stop run(uint64_t maxCycles, const std::vector<bool>& breakpoints);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef KEYBOARDLOG_H
+#define KEYBOARDLOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+// Keyboard input of an emulated program as a list of events: the value
+// the keyboard cell (24576) takes from a given time on, in VM steps for
+// the VMEmulator and in cycles for the HackEmulator. The emulators stop at
+// each event to apply it, so a run with the same log is the same run.
+//
+// A program that halts (see the emulators' Stop::HALT) while events are
+// left is waiting for one: it gets the next event at once, and the event
+// is moved to that time. Once the log runs out, characters of a `typed`
+// stream are pressed and released in the same way and appended to the
+// log, which can then be written out and replayed.
+//
+// As text, one "time key" pair per line; '#' starts a comment.
+class KeyboardLog
+{
+public:
+  struct Event
+  {
+    uint64_t time{ 0 };
+    int16_t key{ 0 };
+  };
+
+  // Time a typed key is held, unless the program waits for its release
+  static constexpr uint64_t keyHold{ 100000 };
+  static constexpr uint64_t never{ std::numeric_limits<uint64_t>::max() };
+
+private:
+  std::vector<Event> m_events{};
+  size_t m_next{ 0 };
+  std::istream* m_typed{ nullptr };
+
+public:
+  KeyboardLog() = default;
+
+  // Throws std::runtime_error for a malformed line or a time that goes back
+  explicit KeyboardLog(std::istream& in);
+
+  KeyboardLog(const KeyboardLog&) = delete;
+  KeyboardLog& operator=(const KeyboardLog&) = delete;
+
+  void type(std::istream& typed) noexcept { m_typed = &typed; }
+
+  const std::vector<Event>& events() const noexcept { return m_events; }
+  void write(std::ostream& out) const;
+
+  // Time of the next event, never when none is left
+  uint64_t next() const noexcept { return m_next < m_events.size() ? m_events[m_next].time : never; }
+
+  // Key of the next event, which is then done
+  int16_t deliver() noexcept { return m_events[m_next++].key; }
+
+  // The program waits for input at `time`: true with the next event moved
+  // there, false when there is no input left
+  bool wait(uint64_t time);
+
+  // Hack key code of a typed character: newline 128, backspace 129, the
+  // printable ASCII characters themselves; 0 for the others
+  static int16_t keyCode(char c) noexcept;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef OUTPUTBUFFER_H
+#define OUTPUTBUFFER_H
+
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Append-only text buffer used by the code writers instead of building a
+// temporary std::string per command. Text is copied into preallocated
+// chunks of chunkSize bytes, integers are formatted in place without
+// allocating, and every chunk reaches the stream with a single write()
+// call: either all together through writeTo(), or one by one as they fill
+// up when the buffer is attached to a sink stream.
+class OutputBuffer
+{
+public:
+  static constexpr size_t chunkSize{ 64 * 1024 };
+
+private:
+  std::ostream* m_sink{ nullptr };
+  std::vector<std::unique_ptr<char[]>> m_chunks{};
+  std::vector<size_t> m_sizes{};          // bytes used in each chunk
+  char* m_cursor{ nullptr };              // next free byte of the last chunk
+  char* m_limit{ nullptr };               // end of the last chunk
+
+  void newChunk();
+  void appendSlow(const char* data, size_t size);
+
+public:
+  OutputBuffer() = default;
+  explicit OutputBuffer(std::ostream& sink);
+  OutputBuffer(const OutputBuffer&) = delete;
+  OutputBuffer& operator=(const OutputBuffer&) = delete;
+  OutputBuffer(OutputBuffer&& other) noexcept;
+  OutputBuffer& operator=(OutputBuffer&& other) noexcept;
+
+  void append(std::string_view text)
+  {
+    if (static_cast<size_t>(m_limit - m_cursor) >= text.size())
+    {
+      std::memcpy(m_cursor, text.data(), text.size());
+      m_cursor += text.size();
+    }
+    else
+    {
+      appendSlow(text.data(), text.size());
+    }
+  }
+
+  void append(char c)
+  {
+    if (m_cursor == m_limit)
+      newChunk();
+    *m_cursor++ = c;
+  }
+
+  void append(int value);
+  void append(const OutputBuffer& other);
+
+  // String literals: the length is known at compile time
+  template <size_t N>
+  OutputBuffer& operator<<(const char (&text)[N]) { append(std::string_view(text, N - 1)); return *this; }
+
+  OutputBuffer& operator<<(std::string_view text) { append(text); return *this; }
+  OutputBuffer& operator<<(const std::string& text) { append(std::string_view(text)); return *this; }
+  OutputBuffer& operator<<(char c)                { append(c); return *this; }
+  OutputBuffer& operator<<(int value)             { append(value); return *this; }
+
+  // Calls f(std::string_view) on the used part of every chunk, in order
+  template <typename F>
+  void forEachChunk(F&& f) const
+  {
+    for (size_t i = 0; i < m_chunks.size(); i++)
+    {
+      size_t used{ (i + 1 == m_chunks.size())
+        ? static_cast<size_t>(m_cursor - m_chunks[i].get())
+        : m_sizes[i] };
+      f(std::string_view(m_chunks[i].get(), used));
+    }
+  }
+
+  size_t size() const noexcept;
+  void writeTo(std::ostream& out) const;
+  void flushTo(std::ostream& out);
+  void flush();
+  void clear() noexcept;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "HackAssembler.h"
+#include "OutputBuffer.h"
+
+namespace
+{
+  const std::unordered_map<std::string_view, uint16_t> compTable{
+    {"0",   0b0101010}, {"1",   0b0111111}, {"-1",  0b0111010},
+    {"D",   0b0001100}, {"A",   0b0110000}, {"!D",  0b0001101},
+    {"!A",  0b0110001}, {"-D",  0b0001111}, {"-A",  0b0110011},
+    {"D+1", 0b0011111}, {"A+1", 0b0110111}, {"D-1", 0b0001110},
+    {"A-1", 0b0110010}, {"D+A", 0b0000010}, {"D-A", 0b0010011},
+    {"A-D", 0b0000111}, {"D&A", 0b0000000}, {"D|A", 0b0010101},
+
+    {"M",   0b1110000}, {"!M",  0b1110001}, {"-M",  0b1110011},
+    {"M+1", 0b1110111}, {"M-1", 0b1110010}, {"D+M", 0b1000010},
+    {"D-M", 0b1010011}, {"M-D", 0b1000111}, {"D&M", 0b1000000},
+    {"D|M", 0b1010101}
+  };
+
+  const std::unordered_map<std::string_view, uint16_t> destTable{
+    {"",   0b000}, {"M",  0b001}, {"D",  0b010}, {"MD",  0b011},
+    {"A",  0b100}, {"AM", 0b101}, {"AD", 0b110}, {"AMD", 0b111}
+  };
+
+  const std::unordered_map<std::string_view, uint16_t> jumpTable{
+    {"",    0b000}, {"JGT", 0b001}, {"JEQ", 0b010}, {"JGE", 0b011},
+    {"JLT", 0b100}, {"JNE", 0b101}, {"JLE", 0b110}, {"JMP", 0b111}
+  };
+
+  const std::unordered_map<std::string, uint16_t> predefinedSymbols{
+    {"R0", 0},   {"R1", 1},   {"R2", 2},   {"R3", 3},
+    {"R4", 4},   {"R5", 5},   {"R6", 6},   {"R7", 7},
+    {"R8", 8},   {"R9", 9},   {"R10", 10}, {"R11", 11},
+    {"R12", 12}, {"R13", 13}, {"R14", 14}, {"R15", 15},
+    {"SP", 0},   {"LCL", 1},  {"ARG", 2},  {"THIS", 3}, {"THAT", 4},
+    {"SCREEN", 16384}, {"KBD", 24576}
+  };
+
+  uint16_t lookup(const std::unordered_map<std::string_view, uint16_t>& table,
+                  std::string_view mnemonic, const char* what)
+  {
+    auto it{ table.find(mnemonic) };
+    if (it == table.end())
+      throw std::runtime_error(std::string("Invalid ") + what + " mnemonic: " + std::string(mnemonic));
+    return it->second;
+  }
+}
+
+uint16_t HackAssembler::encodeC(std::string_view instruction)
+{
+  std::string_view dest{};
+  std::string_view comp{ instruction };
+  std::string_view jump{};
+
+  if (size_t eq{ comp.find('=') }; eq != std::string_view::npos)
+  {
+    dest = comp.substr(0, eq);
+    comp.remove_prefix(eq + 1);
+  }
+  if (size_t semi{ comp.find(';') }; semi != std::string_view::npos)
+  {
+    jump = comp.substr(semi + 1);
+    comp = comp.substr(0, semi);
+  }
+
+  return static_cast<uint16_t>(
+    0b111 << 13 |
+    lookup(compTable, comp, "comp") << 6 |
+    lookup(destTable, dest, "dest") << 3 |
+    lookup(jumpTable, jump, "jump"));
+}
+
+void HackAssembler::encodeLine(std::string_view line, Object& object)
+{
+  // The code writers emit one instruction per line with no blanks or
+  // comments, but hand-written fragments may carry both
+  if (size_t comment{ line.find("//") }; comment != std::string_view::npos)
+    line = line.substr(0, comment);
+  while (!line.empty() && (line.front() == ' ' || line.front() == '\t'))
+    line.remove_prefix(1);
+  while (!line.empty() && (line.back() == ' ' || line.back() == '\t' || line.back() == '\r'))
+    line.remove_suffix(1);
+
+  if (line.empty())
+    return;
+
+  if (line.front() == '(')
+  {
+    if (line.back() != ')' || line.size() < 3)
+      throw std::runtime_error("Invalid L_COMMAND: " + std::string(line));
+
+    object.labels.emplace_back(std::string(line.substr(1, line.size() - 2)), object.words.size());
+  }
+  else if (line.front() == '@')
+  {
+    std::string_view symbol{ line.substr(1) };
+    if (symbol.empty())
+      throw std::runtime_error("Invalid A_COMMAND format: @");
+
+    if (symbol.front() >= '0' && symbol.front() <= '9')
+    {
+      unsigned int value{ 0 };
+      for (char c : symbol)
+      {
+        if (c < '0' || c > '9')
+          throw std::runtime_error("Invalid symbol in A_COMMAND: " + std::string(symbol));
+        value = value * 10 + static_cast<unsigned int>(c - '0');
+        if (value > 0x7FFF)
+          throw std::runtime_error("Invalid A_COMMAND format: @" + std::string(symbol));
+      }
+      object.words.push_back(static_cast<uint16_t>(value));
+    }
+    else
+    {
+      object.fixups.push_back({ object.words.size(), std::string(symbol) });
+      object.words.push_back(0);
+    }
+  }
+  else
+  {
+    object.words.push_back(encodeC(line));
+  }
+}
+
+HackAssembler::Object HackAssembler::assemble(const OutputBuffer& code)
+{
+  Object object{};
+  std::string carry{};   // line split across two chunks
+
+  code.forEachChunk([&](std::string_view chunk) {
+    while (!chunk.empty())
+    {
+      size_t newline{ chunk.find('\n') };
+      if (newline == std::string_view::npos)
+      {
+        carry.append(chunk);
+        return;
+      }
+
+      if (carry.empty())
+      {
+        encodeLine(chunk.substr(0, newline), object);
+      }
+      else
+      {
+        carry.append(chunk.substr(0, newline));
+        encodeLine(carry, object);
+        carry.clear();
+      }
+      chunk.remove_prefix(newline + 1);
+    }
+  });
+
+  if (!carry.empty())
+    encodeLine(carry, object);
+
+  return object;
+}
+
+std::vector<uint16_t> HackAssembler::link(const std::vector<Object>& objects)
+{
+  SymbolTable symbols{};
+  return link(objects, symbols);
+}
+
+std::vector<uint16_t> HackAssembler::link(const std::vector<Object>& objects, SymbolTable& symbols)
+{
+  // On return symbols holds every label and variable of the program
+  symbols = predefinedSymbols;
+  std::vector<uint16_t> program{};
+
+  // 1. Lay the objects out one after the other and place their labels
+  std::vector<size_t> bases{};
+  for (const auto& object : objects)
+  {
+    bases.push_back(program.size());
+    for (const auto& [label, address] : object.labels)
+    {
+      if (!symbols.emplace(label, static_cast<uint16_t>(program.size() + address)).second)
+        throw std::runtime_error("Invalid L_COMMAND. Duplicate symbol found: " + label);
+    }
+    program.insert(program.end(), object.words.begin(), object.words.end());
+  }
+
+  if (program.size() > 32768)
+    throw std::runtime_error("Program does not fit in the ROM: " + std::to_string(program.size()) + " words");
+
+  // 2. Patch the references, allocating variables as they are first met
+  uint16_t nextVariableAddress{ 16 };
+  for (size_t i = 0; i < objects.size(); i++)
+  {
+    for (const auto& [word, symbol] : objects[i].fixups)
+    {
+      auto [it, isNew]{ symbols.emplace(symbol, nextVariableAddress) };
+      if (isNew)
+        nextVariableAddress++;
+      program[bases[i] + word] = it->second;
+    }
+  }
+
+  return program;
+}
+
+void HackAssembler::writeText(const std::vector<uint16_t>& words, std::ostream& out)
+{
+  OutputBuffer buffer(out);
+  char line[17];
+  line[16] = '\n';
+  for (uint16_t word : words)
+  {
+    for (int bit = 0; bit < 16; bit++)
+      line[bit] = (word >> (15 - bit)) & 1 ? '1' : '0';
+    buffer << std::string_view(line, sizeof(line));
+  }
+  buffer.flush();
+}
+
+void HackAssembler::writeBinary(const std::vector<uint16_t>& words, std::ostream& out)
+{
+  // Big-endian 16-bit words, the byte order of the Hack instruction format
+  OutputBuffer buffer(out);
+  for (uint16_t word : words)
+  {
+    buffer << static_cast<char>(word >> 8) << static_cast<char>(word & 0xFF);
+  }
+  buffer.flush();
+}
\ No newline at end of file
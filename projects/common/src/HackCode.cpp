@@ -0,0 +1,21 @@
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "HackCode.h"
+
+void HackCode::reference(std::string symbol)
+{
+  m_object->fixups.push_back({ m_object->words.size(), std::move(symbol) });
+  m_object->words.push_back(0);
+}
+
+void HackCode::at(int value)
+{
+  if (value < 0 || value > 0x7FFF)
+    throw std::invalid_argument("A-instruction constant out of range: " + std::to_string(value));
+
+  if (m_text)
+    *m_text << '@' << value << '\n';
+  else
+    m_object->words.push_back(static_cast<uint16_t>(value));
+}
\ No newline at end of file
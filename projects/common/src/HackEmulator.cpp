@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "HackEmulator.h"
+
+HackEmulator::HackEmulator(std::vector<uint16_t> rom)
+  : m_rom(std::move(rom))
+  , m_ram(memorySize, 0)
+{
+}
+
+void HackEmulator::reset() noexcept
+{
+  m_a = 0;
+  m_d = 0;
+  m_pc = 0;
+  m_cycles = 0;
+}
+
+HackEmulator::Stop HackEmulator::run(uint64_t maxCycles, int stopAt)
+{
+  return execute(maxCycles, [stopAt](uint16_t pc) { return pc == stopAt; });
+}
+
+HackEmulator::Stop HackEmulator::run(uint64_t maxCycles, const std::vector<bool>& breakpoints)
+{
+  return execute(maxCycles, [&breakpoints](uint16_t pc) { return pc < breakpoints.size() && breakpoints[pc]; });
+}
+
+template <typename AtBreakpoint>
+HackEmulator::Stop HackEmulator::execute(uint64_t maxCycles, AtBreakpoint atBreakpoint)
+{
+  KeyboardLog* const keys{ m_keyboard };
+  const uint16_t* rom{ m_rom.data() };
+  const size_t romSize{ m_rom.size() };
+  int16_t* ram{ m_ram.data() };
+
+  int16_t a{ m_a };
+  int16_t d{ m_d };
+  uint16_t pc{ m_pc };
+  uint64_t cycles{ m_cycles };
+  Stop stop{ Stop::CYCLES };
+
+  // Cycles run to the next key event, or to maxCycles
+  uint64_t limit{ keys ? std::min(maxCycles, keys->next()) : maxCycles };
+
+  // Halt detection: the state at the last jump target, and the cells
+  // written since then with the values they had there
+  int loopTarget{ -1 };
+  int16_t loopA{ 0 };
+  int16_t loopD{ 0 };
+  std::pair<uint16_t, int16_t> written[maxLoopWrites]{};
+  size_t nWritten{ 0 };
+
+  while (true)
+  {
+    if (cycles >= limit)
+    {
+      if (cycles >= maxCycles)
+        break;
+      ram[keyboard] = keys->deliver();
+      loopTarget = -1;
+      nWritten = 0;
+      limit = std::min(maxCycles, keys->next());
+      continue;
+    }
+    if (pc >= romSize)
+    {
+      stop = Stop::END_OF_ROM;
+      break;
+    }
+    if (atBreakpoint(pc))
+    {
+      stop = Stop::BREAKPOINT;
+      break;
+    }
+
+    const uint16_t instruction{ rom[pc] };
+    cycles++;
+
+    if (!(instruction & 0x8000))
+    {
+      a = static_cast<int16_t>(instruction);
+      pc++;
+      continue;
+    }
+
+    // ALU: zx nx zy ny f no, with y = A or M
+    const uint16_t address{ static_cast<uint16_t>(static_cast<uint16_t>(a) & (memorySize - 1)) };
+    const uint16_t control{ static_cast<uint16_t>(instruction >> 6) };
+    uint16_t x{ static_cast<uint16_t>(d) };
+    uint16_t y{ static_cast<uint16_t>((instruction & 0x1000) ? ram[address] : a) };
+
+    if (control & 0x20) x = 0;
+    if (control & 0x10) x = static_cast<uint16_t>(~x);
+    if (control & 0x08) y = 0;
+    if (control & 0x04) y = static_cast<uint16_t>(~y);
+    uint16_t out{ static_cast<uint16_t>((control & 0x02) ? x + y : x & y) };
+    if (control & 0x01) out = static_cast<uint16_t>(~out);
+    const int16_t result{ static_cast<int16_t>(out) };
+
+    if (instruction & 0x0008)
+    {
+      if (nWritten <= maxLoopWrites && ram[address] != result)
+      {
+        bool seen{ false };
+        for (size_t i = 0; i < nWritten && !seen; i++)
+          seen = written[i].first == address;
+        if (!seen && nWritten < maxLoopWrites)
+          written[nWritten] = { address, ram[address] };
+        if (!seen)
+          nWritten++;
+      }
+      ram[address] = result;
+    }
+    const int16_t oldA{ a };
+    if (instruction & 0x0020) a = result;
+    if (instruction & 0x0010) d = result;
+
+    const bool jump{ ((instruction & 0x4) && result < 0) ||
+                     ((instruction & 0x2) && result == 0) ||
+                     ((instruction & 0x1) && result > 0) };
+    if (!jump)
+    {
+      pc++;
+      continue;
+    }
+
+    pc = static_cast<uint16_t>(oldA);
+
+    // Same target, registers and memory as on the previous arrival, with
+    // no other jump in between: the loop will repeat forever
+    bool same{ pc == loopTarget && a == loopA && d == loopD && nWritten <= maxLoopWrites };
+    for (size_t i = 0; i < nWritten && same; i++)
+      same = ram[written[i].first] == written[i].second;
+    if (same && keys && keys->wait(cycles))
+    {
+      limit = cycles;
+    }
+    else if (same)
+    {
+      stop = Stop::HALT;
+      break;
+    }
+    loopTarget = pc;
+    loopA = a;
+    loopD = d;
+    nWritten = 0;
+  }
+
+  m_a = a;
+  m_d = d;
+  m_pc = pc;
+  m_cycles = cycles;
+  return stop;
+}
\ No newline at end of file
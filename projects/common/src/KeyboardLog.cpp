@@ -0,0 +1,65 @@
+#include <cctype>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "KeyboardLog.h"
+
+KeyboardLog::KeyboardLog(std::istream& in)
+{
+  std::string line{};
+  for (int number = 1; std::getline(in, line); number++)
+  {
+    line = line.substr(0, line.find('#'));
+    std::istringstream fields(line);
+    std::string extra{};
+    uint64_t time{ 0 };
+    int key{ 0 };
+    if (!(fields >> std::ws) || fields.eof())
+      continue;
+    if (!std::isdigit(fields.peek()) || !(fields >> time >> key) || (fields >> extra) ||
+        key < -32768 || key > 65535)
+      throw std::runtime_error("Keyboard log line " + std::to_string(number) + ": expected \"time key\": " + line);
+    if (!m_events.empty() && time < m_events.back().time)
+      throw std::runtime_error("Keyboard log line " + std::to_string(number) + ": time goes back");
+    m_events.push_back({ time, static_cast<int16_t>(key) });
+  }
+}
+
+void KeyboardLog::write(std::ostream& out) const
+{
+  out << "# time key\n";
+  for (const Event& event : m_events)
+    out << event.time << ' ' << event.key << '\n';
+}
+
+bool KeyboardLog::wait(uint64_t time)
+{
+  for (char c{}; m_next == m_events.size() && m_typed && m_typed->get(c); )
+  {
+    const int16_t key{ keyCode(c) };
+    if (key != 0)
+    {
+      m_events.push_back({ time, key });
+      m_events.push_back({ time + keyHold, 0 });
+    }
+  }
+  if (m_next == m_events.size())
+    return false;
+  if (m_events[m_next].time > time)
+    m_events[m_next].time = time;
+  return true;
+}
+
+int16_t KeyboardLog::keyCode(char c) noexcept
+{
+  if (c == '\n')
+    return 128;
+  if (c == '\b' || c == 127)
+    return 129;
+  if (c >= 32 && c < 127)
+    return c;
+  return 0;
+}
\ No newline at end of file
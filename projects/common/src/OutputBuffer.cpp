@@ -0,0 +1,131 @@
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include "OutputBuffer.h"
+
+OutputBuffer::OutputBuffer(std::ostream& sink)
+  : m_sink(&sink)
+{
+}
+
+OutputBuffer::OutputBuffer(OutputBuffer&& other) noexcept
+  : m_sink(std::exchange(other.m_sink, nullptr))
+  , m_chunks(std::move(other.m_chunks))
+  , m_sizes(std::move(other.m_sizes))
+  , m_cursor(std::exchange(other.m_cursor, nullptr))
+  , m_limit(std::exchange(other.m_limit, nullptr))
+{
+}
+
+OutputBuffer& OutputBuffer::operator=(OutputBuffer&& other) noexcept
+{
+  m_sink = std::exchange(other.m_sink, nullptr);
+  m_chunks = std::move(other.m_chunks);
+  m_sizes = std::move(other.m_sizes);
+  m_cursor = std::exchange(other.m_cursor, nullptr);
+  m_limit = std::exchange(other.m_limit, nullptr);
+  return *this;
+}
+
+void OutputBuffer::newChunk()
+{
+  // With a sink the single chunk is written out and reused
+  if (m_sink && !m_chunks.empty())
+  {
+    flush();
+    return;
+  }
+
+  if (!m_chunks.empty())
+    m_sizes.back() = static_cast<size_t>(m_cursor - m_chunks.back().get());
+
+  m_chunks.push_back(std::make_unique_for_overwrite<char[]>(chunkSize));
+  m_sizes.push_back(0);
+  m_cursor = m_chunks.back().get();
+  m_limit = m_cursor + chunkSize;
+}
+
+void OutputBuffer::appendSlow(const char* data, size_t size)
+{
+  while (size > 0)
+  {
+    if (m_cursor == m_limit)
+      newChunk();
+
+    size_t n{ std::min(size, static_cast<size_t>(m_limit - m_cursor)) };
+    std::memcpy(m_cursor, data, n);
+    m_cursor += n;
+    data += n;
+    size -= n;
+  }
+}
+
+void OutputBuffer::append(int value)
+{
+  // Formats right to left in a local array: no std::to_string temporary
+  char digits[12];
+  char* end{ digits + sizeof(digits) };
+  char* p{ end };
+
+  unsigned int magnitude{ value < 0 ? 0u - static_cast<unsigned int>(value) : static_cast<unsigned int>(value) };
+  do
+  {
+    *--p = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  if (value < 0)
+    *--p = '-';
+
+  append(std::string_view(p, static_cast<size_t>(end - p)));
+}
+
+void OutputBuffer::append(const OutputBuffer& other)
+{
+  other.forEachChunk([this](std::string_view chunk) { append(chunk); });
+}
+
+size_t OutputBuffer::size() const noexcept
+{
+  if (m_chunks.empty())
+    return 0;
+
+  size_t total{ static_cast<size_t>(m_cursor - m_chunks.back().get()) };
+  for (size_t i = 0; i + 1 < m_chunks.size(); i++)
+    total += m_sizes[i];
+  return total;
+}
+
+void OutputBuffer::writeTo(std::ostream& out) const
+{
+  forEachChunk([&out](std::string_view chunk) {
+    out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+  });
+}
+
+void OutputBuffer::flushTo(std::ostream& out)
+{
+  writeTo(out);
+  clear();
+}
+
+void OutputBuffer::flush()
+{
+  if (m_sink)
+    flushTo(*m_sink);
+}
+
+void OutputBuffer::clear() noexcept
+{
+  // Keep the first chunk around for the next round of appends
+  if (m_chunks.empty())
+    return;
+
+  m_chunks.resize(1);
+  m_sizes.assign(1, 0);
+  m_cursor = m_chunks.front().get();
+  m_limit = m_cursor + chunkSize;
+}
\ No newline at end of file